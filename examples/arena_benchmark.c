@@ -0,0 +1,271 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Benchmark of a large bulk decode with the default allocator and with
+ * arena allocators backed by regular and by huge pages. Reports decode
+ * and random access times, along with data TLB load misses where the
+ * kernel exposes them (Linux perf events).
+ *
+ * usage: arena_benchmark [message count]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <arena.h>
+#include <dynmessage_cerializer.h>
+
+/* number of fields of the benchmark message */
+#define FIELD_COUNT 16
+
+/* number of fields read per message during the access pass */
+#define FIELDS_READ 4
+
+/**
+ * Get current time in micro-seconds.
+ *
+ * @return current time in micro-seconds.
+ */
+static double
+now_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec * 1000000.0 + (double)tv.tv_usec;
+}
+
+/**
+ * Open a counter of data TLB load misses for the current thread.
+ *
+ * @return counter file descriptor, -1 if not available.
+ */
+static int
+dtlb_counter_open(void) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+/**
+ * Start counting.
+ *
+ * @param fd counter file descriptor.
+ */
+static void
+dtlb_counter_start(int fd) {
+#ifdef __linux__
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+/**
+ * Stop counting.
+ *
+ * @param fd counter file descriptor.
+ *
+ * @return counted events, -1 if not available.
+ */
+static long long
+dtlb_counter_stop(int fd) {
+    long long count = -1;
+#ifdef __linux__
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+            count = -1;
+        }
+    }
+#endif
+    return count;
+}
+
+/**
+ * Print a measurement.
+ *
+ * @param mode allocator mode.
+ * @param phase benchmark phase.
+ * @param us elapsed micro-seconds.
+ * @param count number of messages.
+ * @param misses data TLB load misses (-1 if not available).
+ */
+static void
+report(const char *mode, const char *phase, double us, size_t count, long long misses) {
+    if (misses < 0) {
+        fprintf(stdout, "%-16s %-8s %12.1f ns/msg %16s\n", mode, phase,
+            us * 1000.0 / count, "n/a");
+    } else {
+        fprintf(stdout, "%-16s %-8s %12.1f ns/msg %16lld (%.2f/msg)\n", mode, phase,
+            us * 1000.0 / count, misses, (double)misses / count);
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t count = 100000;
+    char names[FIELD_COUNT][32];
+    long int_values[FIELD_COUNT];
+    double double_values[FIELD_COUNT];
+    unsigned long long ulong_values[FIELD_COUNT];
+    dynamicmessage message;
+    serialized_data_info serdi;
+    dynamicmessage **decoded;
+    size_t *order;
+    size_t i;
+    int mode;
+    int fd = dtlb_counter_open();
+
+    if (argc > 1) {
+        count = strtoul(argv[1], NULL, 10);
+    }
+    if (count == 0) {
+        count = 1;
+    }
+
+    /* build and encode the benchmark message once */
+    dynmessage_init(&message, "BenchmarkMessage");
+    for (i = 0; i < FIELD_COUNT; i++) {
+        sprintf(names[i], "benchmark_field_%02lu", (unsigned long)i);
+        int_values[i] = (long)i;
+        double_values[i] = i * 0.5;
+        ulong_values[i] = i * 1000000007ULL;
+        switch (i % 4) {
+        case 0:
+            dynmessage_put_int32_field_value(&message, names[i], &int_values[i]);
+            break;
+        case 1:
+            dynmessage_put_float64_field_value(&message, names[i], &double_values[i]);
+            break;
+        case 2:
+            dynmessage_put_string_field_value(&message, names[i], "benchmark string value");
+            break;
+        default:
+            dynmessage_put_uint64_field_value(&message, names[i], &ulong_values[i]);
+            break;
+        }
+    }
+    dynmessage_serialize_bin(&message, &serdi);
+
+    decoded = (dynamicmessage **)malloc(count * sizeof(dynamicmessage *));
+    order = (size_t *)malloc(count * sizeof(size_t));
+    if (decoded == NULL || order == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    /* random visiting order for the access pass */
+    for (i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    srand(42);
+    for (i = count - 1; i > 0; i--) {
+        size_t j = (size_t)rand() % (i + 1);
+        size_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    fprintf(stdout, "%lu messages of %d fields (%d bytes encoded each)\n",
+        (unsigned long)count, FIELD_COUNT, serdi.ser_data_len);
+    fprintf(stdout, "%-16s %-8s %19s %16s\n", "allocator", "phase", "time", "dTLB load misses");
+
+    for (mode = 0; mode < 3; mode++) {
+        static const char *mode_names[] = { "malloc", "arena", "arena+hugepages" };
+        cerializer_arena *arena = NULL;
+        const cerializer_allocator *allocator = NULL;
+        unsigned long long checksum = 0;
+        double t;
+        long long misses;
+
+        if (mode > 0) {
+            arena = cerializer_arena_create(0, mode == 2 ? CERIALIZER_ARENA_HUGEPAGES : 0);
+            allocator = cerializer_arena_allocator(arena);
+        }
+
+        /* decode */
+        dtlb_counter_start(fd);
+        t = now_us();
+        for (i = 0; i < count; i++) {
+            decoded[i] = (dynamicmessage *)dynmessage_deserialize_bin_with_allocator(
+                serdi.ser_data, serdi.ser_data_len, allocator);
+        }
+        t = now_us() - t;
+        misses = dtlb_counter_stop(fd);
+        report(mode_names[mode], "decode", t, count, misses);
+
+        /* random access */
+        dtlb_counter_start(fd);
+        t = now_us();
+        for (i = 0; i < count; i++) {
+            dynamicmessage *m = decoded[order[i]];
+            int f;
+            for (f = 0; f < FIELDS_READ; f++) {
+                dyn_field field;
+                dynmessage_get_field(m, names[f * (FIELD_COUNT / FIELDS_READ) + f % 4], &field);
+                if (field.value != NULL) {
+                    checksum += field.value->uint64_value & 0xff;
+                }
+            }
+        }
+        t = now_us() - t;
+        misses = dtlb_counter_stop(fd);
+        report(mode_names[mode], "access", t, count, misses);
+
+        if (arena != NULL) {
+            cerializer_arena_stats stats;
+            cerializer_arena_get_stats(arena, &stats);
+            fprintf(stdout, "%-16s %lu chunks, %lu MiB mapped, %lu MiB used, %lu hugetlb, %lu thp\n",
+                "", (unsigned long)stats.chunks, (unsigned long)(stats.mapped_bytes >> 20),
+                (unsigned long)(stats.used_bytes >> 20), (unsigned long)stats.hugetlb_chunks,
+                (unsigned long)stats.thp_chunks);
+        }
+        for (i = 0; i < count; i++) {
+            dynmessage_destroy(decoded[i]);
+        }
+        cerializer_arena_destroy(arena);
+        if (checksum == 0) {
+            fprintf(stdout, "unexpected checksum\n");
+        }
+    }
+
+    free(order);
+    free(decoded);
+    clear_serialized_data_info(&serdi);
+    dynmessage_free(&message);
+    exit(0);
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Simple benchmark comparing the iteration speed of the libcerializer
+ * containers (slinkedlist, ulinkedlist and pvec) for 10^3 to 10^7 elements.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+
+#include <slinkedlist.h>
+#include <ulinkedlist.h>
+#include <pvec.h>
+
+/* number of elements visited per measurement (across all passes) */
+#define VISITS_PER_RUN 100000000UL
+
+/**
+ * Get current time in micro-seconds.
+ *
+ * @return current time in micro-seconds.
+ */
+static double
+now_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec * 1000000.0 + (double)tv.tv_usec;
+}
+
+int main(int argc, char **argv) {
+    size_t n;
+
+    fprintf(stdout, "%10s %16s %16s %16s  (ns per element)\n",
+        "elements", "slinkedlist", "ulinkedlist", "pvec");
+
+    for (n = 1000; n <= 10000000; n *= 10) {
+        size_t i, pass;
+        size_t passes = VISITS_PER_RUN / n;
+        unsigned long sum_sll = 0, sum_ull = 0, sum_vec = 0;
+        double t_sll, t_ull, t_vec;
+        slinkedlist sll;
+        ulinkedlist ull;
+        pvec vec;
+
+        if (passes == 0) {
+            passes = 1;
+        }
+        /* accumulate */
+        slinkedlist_init(&sll);
+        ulinkedlist_init(&ull);
+        pvec_init(&vec);
+        for (i = 0; i < n; i++) {
+            void *data = (void *)(i + 1);
+            slinkedlist_append(&sll, data);
+            ulinkedlist_append(&ull, data);
+            pvec_append(&vec, data);
+        }
+
+        /* iterate single linked list */
+        t_sll = now_us();
+        for (pass = 0; pass < passes; pass++) {
+            slinkedlist_node_t *it = sll.head;
+            while (it) {
+                sum_sll += (unsigned long)it->data;
+                it = it->next;
+            }
+        }
+        t_sll = now_us() - t_sll;
+
+        /* iterate unrolled linked list */
+        t_ull = now_us();
+        for (pass = 0; pass < passes; pass++) {
+            ulinkedlist_node_t *it = ull.head;
+            while (it) {
+                size_t j;
+                for (j = 0; j < it->count; j++) {
+                    sum_ull += (unsigned long)it->data[j];
+                }
+                it = it->next;
+            }
+        }
+        t_ull = now_us() - t_ull;
+
+        /* iterate vector */
+        t_vec = now_us();
+        for (pass = 0; pass < passes; pass++) {
+            for (i = 0; i < vec.size; i++) {
+                sum_vec += (unsigned long)vec.data[i];
+            }
+        }
+        t_vec = now_us() - t_vec;
+
+        if (sum_sll != sum_ull || sum_sll != sum_vec) {
+            fprintf(stderr, "checksum mismatch for %lu elements\n", (unsigned long)n);
+            exit(1);
+        }
+        fprintf(stdout, "%10lu %16.3f %16.3f %16.3f\n", (unsigned long)n,
+            t_sll * 1000.0 / ((double)passes * n),
+            t_ull * 1000.0 / ((double)passes * n),
+            t_vec * 1000.0 / ((double)passes * n));
+
+        slinkedlist_free(&sll, NULL);
+        ulinkedlist_free(&ull, NULL);
+        pvec_free(&vec, NULL);
+    }
+
+    exit(0);
+}
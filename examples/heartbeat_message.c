@@ -159,6 +159,29 @@ int main(int argc, char **argv) {
     fprintf(stdout, "message_out.message_version = %f\n", message_out.message_version);
     fprintf(stdout, "message_in.system_version  = %f\n", message_in.system_version);
     fprintf(stdout, "message_out.system_version = %f\n", message_out.system_version);
+
+    /*
+     * A single schema fingerprint may precede a message: data with two
+     * fingerprints must be rejected (not de-serialized past its end).
+     */
+    {
+        serialized_data_info fp_serdi;
+        unsigned char *twice = NULL;
+        dynamicmessage *dynmessage_twice = NULL;
+        dynmessage_serialize_bin_with_fingerprint((void *)&dynmessage_out, &fp_serdi);
+        twice = malloc(DYN_MSG_FINGERPRINT_LEN + fp_serdi.ser_data_len);
+        memcpy(twice, fp_serdi.ser_data, DYN_MSG_FINGERPRINT_LEN);
+        memcpy(twice + DYN_MSG_FINGERPRINT_LEN, fp_serdi.ser_data, fp_serdi.ser_data_len);
+        dynmessage_twice = (dynamicmessage *)dynmessage_deserialize_bin(
+            twice, DYN_MSG_FINGERPRINT_LEN + fp_serdi.ser_data_len);
+        fprintf(stdout, "double fingerprint rejected = %s\n", dynmessage_twice == NULL ? "yes" : "no");
+        if (dynmessage_twice != NULL) {
+            dynmessage_destroy(dynmessage_twice);
+            exit(1);
+        }
+        free(twice);
+        clear_serialized_data_info(&fp_serdi);
+    }
     /*
      * Free resources.
      */
@@ -0,0 +1,445 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Opt-in allocation instrumentation keeping per-callsite counters of
+ * library allocations. Counting is compiled in only when the library
+ * is built with CERIALIZER_ALLOC_STATS defined (e.g. by configuring with
+ * CPPFLAGS=-DCERIALIZER_ALLOC_STATS), otherwise all functions are no-ops.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "alloc_stats.h"
+
+#if defined(CERIALIZER_ALLOC_STATS) && defined(__GNUC__)
+#define USE_ALLOC_STATS
+#include <pthread.h>
+#include <stdint.h>
+#endif
+
+#ifdef USE_ALLOC_STATS
+
+/* maximum number of distinct call sites (power of two) */
+#define ALLOC_STATS_SITES 1024
+
+/* number of independently locked live allocation tables (power of two) */
+#define ALLOC_STATS_STRIPES 64
+
+/* initial number of buckets of a live allocation table (power of two) */
+#define ALLOC_STATS_MIN_BUCKETS 64
+
+/* Structure to hold the counters of a call site. */
+typedef struct _alloc_site_struct {
+    int used; /* non-zero once the call site key is published */
+    const char *modulename; /* source file of the call site */
+    const char *funcname; /* function of the call site */
+    unsigned long lineno; /* line of the call site */
+    unsigned long allocs; /* number of allocations */
+    unsigned long frees; /* number of allocations released */
+    unsigned long long bytes; /* total bytes allocated */
+    unsigned long long live_bytes; /* bytes currently allocated */
+    unsigned long long peak_bytes; /* maximum of live bytes */
+} alloc_site;
+
+/* Structure to hold a live allocation. */
+typedef struct _alloc_record_struct {
+    void *ptr; /* allocated memory */
+    size_t size; /* size of the allocation */
+    alloc_site *site; /* call site of the allocation */
+    struct _alloc_record_struct *next; /* next record of the bucket */
+} alloc_record;
+
+/* Structure to hold a table of live allocations. */
+typedef struct _alloc_stripe_struct {
+    pthread_mutex_t lock; /* protects all members */
+    alloc_record **buckets; /* chained hash table of records */
+    size_t capacity; /* number of buckets */
+    size_t size; /* number of records */
+} alloc_stripe;
+
+/* call sites, looked up without locking once published */
+static alloc_site alloc_sites[ALLOC_STATS_SITES];
+static pthread_mutex_t alloc_sites_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* call site collecting allocations once alloc_sites is full */
+static alloc_site alloc_overflow_site = { 1, "<other>", "<other sites>", 0, 0, 0, 0, 0, 0 };
+
+/* live allocations, to credit frees to the allocating call site */
+static alloc_stripe alloc_stripes[ALLOC_STATS_STRIPES];
+static pthread_once_t alloc_stripes_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Initialize the live allocation tables.
+ */
+static void
+alloc_stripes_init(void) {
+    int i;
+    for (i = 0; i < ALLOC_STATS_STRIPES; i++) {
+        pthread_mutex_init(&alloc_stripes[i].lock, NULL);
+        alloc_stripes[i].buckets = NULL;
+        alloc_stripes[i].capacity = 0;
+        alloc_stripes[i].size = 0;
+    }
+}
+
+/**
+ * Hash an allocated pointer.
+ *
+ * @param ptr pointer to hash.
+ *
+ * @return hash value of the pointer.
+ */
+static size_t
+alloc_ptr_hash(void *ptr) {
+    unsigned long long h = (unsigned long long)(uintptr_t)ptr;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (size_t)h;
+}
+
+/**
+ * Test whether a call site matches the provided key.
+ *
+ * @param site the call site.
+ * @param modulename name of the module.
+ * @param funcname name of the function.
+ * @param lineno line number.
+ *
+ * @return Non-zero if the call site matches, zero otherwise.
+ */
+static int
+alloc_site_matches(
+    alloc_site *site,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno) {
+    return site->lineno == lineno
+        && site->modulename == modulename
+        && site->funcname == funcname;
+}
+
+/**
+ * Find (or register) the call site with the provided key.
+ *
+ * @param modulename name of the module.
+ * @param funcname name of the function.
+ * @param lineno line number.
+ *
+ * @return the call site.
+ */
+static alloc_site *
+alloc_site_get(const char *modulename, const char *funcname, unsigned long lineno) {
+    size_t start = (alloc_ptr_hash((void *)modulename) ^ lineno) & (ALLOC_STATS_SITES - 1);
+    size_t i = start;
+    alloc_site *site;
+
+    /* fast path, the call site is already published */
+    do {
+        site = &alloc_sites[i];
+        if (!__atomic_load_n(&site->used, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        if (alloc_site_matches(site, modulename, funcname, lineno)) {
+            return site;
+        }
+        i = (i + 1) & (ALLOC_STATS_SITES - 1);
+    } while (i != start);
+
+    /* register it, unless another thread just did */
+    pthread_mutex_lock(&alloc_sites_lock);
+    i = start;
+    do {
+        site = &alloc_sites[i];
+        if (!site->used) {
+            site->modulename = modulename;
+            site->funcname = funcname;
+            site->lineno = lineno;
+            __atomic_store_n(&site->used, 1, __ATOMIC_RELEASE);
+            break;
+        }
+        if (alloc_site_matches(site, modulename, funcname, lineno)) {
+            break;
+        }
+        i = (i + 1) & (ALLOC_STATS_SITES - 1);
+        site = &alloc_overflow_site;
+    } while (i != start);
+    pthread_mutex_unlock(&alloc_sites_lock);
+    return site;
+}
+
+/**
+ * Double the buckets of a live allocation table.
+ *
+ * @param stripe the table (locked).
+ */
+static void
+alloc_stripe_grow(alloc_stripe *stripe) {
+    size_t capacity = stripe->capacity ? 2 * stripe->capacity : ALLOC_STATS_MIN_BUCKETS;
+    alloc_record **buckets = (alloc_record **)calloc(capacity, sizeof(alloc_record *));
+    size_t i;
+
+    if (buckets == NULL) {
+        return;
+    }
+    for (i = 0; i < stripe->capacity; i++) {
+        alloc_record *it = stripe->buckets[i];
+        while (it) {
+            alloc_record *next = it->next;
+            size_t b = (alloc_ptr_hash(it->ptr) / ALLOC_STATS_STRIPES) & (capacity - 1);
+            it->next = buckets[b];
+            buckets[b] = it;
+            it = next;
+        }
+    }
+    free(stripe->buckets);
+    stripe->buckets = buckets;
+    stripe->capacity = capacity;
+}
+
+#endif /* USE_ALLOC_STATS */
+
+/**
+ * Record an allocation.
+ *
+ * @param ptr pointer to the allocated memory.
+ * @param size amount of memory allocated.
+ * @param modulename name of the module which allocated.
+ * @param funcname name of the function which allocated.
+ * @param lineno line number of the code which allocated.
+ */
+extern void
+alloc_stats_record_alloc(
+    void *ptr,
+    size_t size,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno) {
+#ifdef USE_ALLOC_STATS
+    alloc_site *site = alloc_site_get(modulename, funcname, lineno);
+    size_t h = alloc_ptr_hash(ptr);
+    alloc_stripe *stripe = &alloc_stripes[h & (ALLOC_STATS_STRIPES - 1)];
+    alloc_record *record = (alloc_record *)malloc(sizeof(alloc_record));
+    unsigned long long live;
+    unsigned long long peak;
+
+    __atomic_fetch_add(&site->allocs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&site->bytes, size, __ATOMIC_RELAXED);
+    live = __atomic_add_fetch(&site->live_bytes, size, __ATOMIC_RELAXED);
+    peak = __atomic_load_n(&site->peak_bytes, __ATOMIC_RELAXED);
+    while (live > peak
+        && !__atomic_compare_exchange_n(&site->peak_bytes, &peak, live, 1,
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        /* peak was reloaded, retry */
+    }
+
+    if (record == NULL) {
+        return; /* the allocation is counted but its free will not be */
+    }
+    record->ptr = ptr;
+    record->size = size;
+    record->site = site;
+
+    pthread_once(&alloc_stripes_once, alloc_stripes_init);
+    pthread_mutex_lock(&stripe->lock);
+    if (stripe->size >= stripe->capacity) {
+        alloc_stripe_grow(stripe);
+    }
+    if (stripe->capacity > 0) {
+        size_t b = (h / ALLOC_STATS_STRIPES) & (stripe->capacity - 1);
+        record->next = stripe->buckets[b];
+        stripe->buckets[b] = record;
+        stripe->size++;
+        record = NULL;
+    }
+    pthread_mutex_unlock(&stripe->lock);
+    free(record);
+#endif
+}
+
+/**
+ * Record the release of an allocation. Pointers that were not recorded
+ * are ignored.
+ *
+ * @param ptr pointer to the released memory.
+ */
+extern void
+alloc_stats_record_free(void *ptr) {
+#ifdef USE_ALLOC_STATS
+    size_t h = alloc_ptr_hash(ptr);
+    alloc_stripe *stripe = &alloc_stripes[h & (ALLOC_STATS_STRIPES - 1)];
+    alloc_record *record = NULL;
+
+    if (ptr == NULL) {
+        return;
+    }
+    pthread_once(&alloc_stripes_once, alloc_stripes_init);
+    pthread_mutex_lock(&stripe->lock);
+    if (stripe->capacity > 0) {
+        alloc_record **it = &stripe->buckets[(h / ALLOC_STATS_STRIPES) & (stripe->capacity - 1)];
+        while (*it) {
+            if ((*it)->ptr == ptr) {
+                record = *it;
+                *it = record->next;
+                stripe->size--;
+                break;
+            }
+            it = &(*it)->next;
+        }
+    }
+    pthread_mutex_unlock(&stripe->lock);
+
+    if (record != NULL) {
+        __atomic_fetch_add(&record->site->frees, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_sub(&record->site->live_bytes, record->size, __ATOMIC_RELAXED);
+        free(record);
+    }
+#endif
+}
+
+/**
+ * Test whether allocation instrumentation is compiled in.
+ *
+ * @return Non-zero if allocations are counted, zero otherwise.
+ */
+extern int
+cerializer_alloc_stats_enabled(void) {
+    int result = 0;
+#ifdef USE_ALLOC_STATS
+    result++;
+#endif
+    return result;
+}
+
+#ifdef USE_ALLOC_STATS
+
+/**
+ * Compare two call site counters by descending allocated bytes (qsort style).
+ *
+ * @param l pointer to the first call site counters.
+ * @param r pointer to the second call site counters.
+ *
+ * @return negative, zero or positive if `l` allocated more, equal or
+ *         less bytes than `r` respectively.
+ */
+static int
+alloc_site_stats_compare(const void *l, const void *r) {
+    const cerializer_alloc_site_stats *ls = (const cerializer_alloc_site_stats *)l;
+    const cerializer_alloc_site_stats *rs = (const cerializer_alloc_site_stats *)r;
+    if (ls->bytes != rs->bytes) {
+        return ls->bytes < rs->bytes ? 1 : -1;
+    }
+    return ls->allocs < rs->allocs ? 1 : (ls->allocs > rs->allocs ? -1 : 0);
+}
+
+/**
+ * Take a snapshot of the counters of a call site.
+ *
+ * @param site the call site.
+ * @param stats structure to fill in.
+ */
+static void
+alloc_site_snapshot(alloc_site *site, cerializer_alloc_site_stats *stats) {
+    stats->modulename = site->modulename;
+    stats->funcname = site->funcname;
+    stats->lineno = site->lineno;
+    stats->allocs = __atomic_load_n(&site->allocs, __ATOMIC_RELAXED);
+    stats->frees = __atomic_load_n(&site->frees, __ATOMIC_RELAXED);
+    stats->bytes = __atomic_load_n(&site->bytes, __ATOMIC_RELAXED);
+    stats->live_bytes = __atomic_load_n(&site->live_bytes, __ATOMIC_RELAXED);
+    stats->peak_bytes = __atomic_load_n(&site->peak_bytes, __ATOMIC_RELAXED);
+}
+
+#endif /* USE_ALLOC_STATS */
+
+/**
+ * Get the counters of the call sites that allocated the most bytes.
+ *
+ * @param stats array to fill in, in descending order of allocated bytes.
+ * @param max_sites maximum number of entries to fill in.
+ *
+ * @return number of entries filled in.
+ */
+extern int
+cerializer_get_alloc_stats(cerializer_alloc_site_stats *stats, int max_sites) {
+    int count = 0;
+#ifdef USE_ALLOC_STATS
+    cerializer_alloc_site_stats *all;
+    int i;
+
+    if (stats == NULL || max_sites <= 0) {
+        return 0;
+    }
+    all = (cerializer_alloc_site_stats *)malloc(
+        (ALLOC_STATS_SITES + 1) * sizeof(cerializer_alloc_site_stats));
+    if (all == NULL) {
+        return 0;
+    }
+    for (i = 0; i < ALLOC_STATS_SITES; i++) {
+        if (__atomic_load_n(&alloc_sites[i].used, __ATOMIC_ACQUIRE)) {
+            alloc_site_snapshot(&alloc_sites[i], &all[count++]);
+        }
+    }
+    if (__atomic_load_n(&alloc_overflow_site.allocs, __ATOMIC_RELAXED) > 0) {
+        alloc_site_snapshot(&alloc_overflow_site, &all[count++]);
+    }
+    qsort(all, count, sizeof(cerializer_alloc_site_stats), alloc_site_stats_compare);
+    if (count > max_sites) {
+        count = max_sites;
+    }
+    for (i = 0; i < count; i++) {
+        stats[i] = all[i];
+    }
+    free(all);
+#endif
+    return count;
+}
+
+/**
+ * Write a report of the call sites that allocated the most bytes.
+ *
+ * @param out stream to write to (NULL for stdout).
+ * @param max_sites maximum number of call sites to report.
+ */
+extern void
+cerializer_alloc_stats_dump(FILE *out, int max_sites) {
+    if (out == NULL) {
+        out = stdout;
+    }
+    if (!cerializer_alloc_stats_enabled()) {
+        fprintf(out, "allocation statistics not compiled in (define CERIALIZER_ALLOC_STATS)\n");
+    } else if (max_sites > 0) {
+        cerializer_alloc_site_stats *stats = (cerializer_alloc_site_stats *)
+            malloc(max_sites * sizeof(cerializer_alloc_site_stats));
+        int count = cerializer_get_alloc_stats(stats, max_sites);
+        int i;
+
+        fprintf(out, "%10s %10s %14s %14s %14s  %s\n",
+            "allocs", "frees", "bytes", "live bytes", "peak bytes", "call site");
+        for (i = 0; i < count; i++) {
+            fprintf(out, "%10lu %10lu %14llu %14llu %14llu  %s:%s:%lu\n",
+                stats[i].allocs, stats[i].frees, stats[i].bytes,
+                stats[i].live_bytes, stats[i].peak_bytes,
+                stats[i].modulename ? stats[i].modulename : "<unknown>",
+                stats[i].funcname ? stats[i].funcname : "<unknown>",
+                stats[i].lineno);
+        }
+        free(stats);
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Opt-in allocation instrumentation keeping per-callsite counters of
+ * library allocations. Counting is compiled in only when the library
+ * is built with CERIALIZER_ALLOC_STATS defined (e.g. by configuring with
+ * CPPFLAGS=-DCERIALIZER_ALLOC_STATS), otherwise all functions are no-ops.
+ */
+
+#ifndef ALLOC_STATS_H_
+#define ALLOC_STATS_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdio.h>
+
+/* Structure to hold the allocation counters of a call site. */
+typedef struct _cerializer_alloc_site_stats_struct {
+    const char *modulename; /* source file of the call site */
+    const char *funcname; /* function of the call site */
+    unsigned long lineno; /* line of the call site */
+    unsigned long allocs; /* number of allocations */
+    unsigned long frees; /* number of allocations released */
+    unsigned long long bytes; /* total bytes allocated */
+    unsigned long long live_bytes; /* bytes currently allocated */
+    unsigned long long peak_bytes; /* maximum of live bytes */
+} cerializer_alloc_site_stats;
+
+/**
+ * Record an allocation.
+ *
+ * @param ptr pointer to the allocated memory.
+ * @param size amount of memory allocated.
+ * @param modulename name of the module which allocated.
+ * @param funcname name of the function which allocated.
+ * @param lineno line number of the code which allocated.
+ */
+extern void
+alloc_stats_record_alloc(
+    void *ptr,
+    size_t size,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno);
+
+/**
+ * Record the release of an allocation. Pointers that were not recorded
+ * are ignored.
+ *
+ * @param ptr pointer to the released memory.
+ */
+extern void
+alloc_stats_record_free(void *ptr);
+
+/**
+ * Test whether allocation instrumentation is compiled in.
+ *
+ * @return Non-zero if allocations are counted, zero otherwise.
+ */
+extern int
+cerializer_alloc_stats_enabled(void);
+
+/**
+ * Get the counters of the call sites that allocated the most bytes.
+ *
+ * @param stats array to fill in, in descending order of allocated bytes.
+ * @param max_sites maximum number of entries to fill in.
+ *
+ * @return number of entries filled in.
+ */
+extern int
+cerializer_get_alloc_stats(cerializer_alloc_site_stats *stats, int max_sites);
+
+/**
+ * Write a report of the call sites that allocated the most bytes.
+ *
+ * @param out stream to write to (NULL for stdout).
+ * @param max_sites maximum number of call sites to report.
+ */
+extern void
+cerializer_alloc_stats_dump(FILE *out, int max_sites);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* ALLOC_STATS_H_ */
@@ -0,0 +1,377 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Arena allocator for bulk de-serialization workloads. Memory is carved
+ * out of large chunks, optionally backed by huge pages, so that decoded
+ * messages are packed densely and need few TLB entries. Individual frees
+ * are (mostly) no-ops, all memory is released at once by resetting or
+ * destroying the arena. An arena must not be used by several threads
+ * concurrently.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ARENA_USE_MMAP
+#include <sys/mman.h>
+#include <unistd.h>
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+#include "arena.h"
+#include "stdlib_util.h"
+
+/* size of a (2 MiB) huge page */
+#define ARENA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/* room reserved for the chunk header at the start of every chunk */
+#define ARENA_CHUNK_HEADER_SIZE ((sizeof(cerializer_arena_chunk) + 15) & ~(size_t)15)
+
+/**
+ * Round a value up to a multiple of the provided alignment.
+ *
+ * @param value value to round.
+ * @param alignment alignment (a power of two).
+ *
+ * @return the rounded value.
+ */
+static size_t
+arena_round_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * Map memory for a new chunk, preferring huge pages as requested by
+ * the flags and falling back to regular pages.
+ *
+ * @param size minimum size of the chunk, including its header.
+ * @param flags CERIALIZER_ARENA_* flags.
+ *
+ * @return the new chunk, NULL on failure.
+ */
+static cerializer_arena_chunk *
+arena_chunk_map(size_t size, int flags) {
+    cerializer_arena_chunk *chunk;
+    void *base = NULL;
+    size_t mapped = 0;
+    int backing = 0;
+
+#ifdef ARENA_USE_MMAP
+#ifdef MAP_HUGETLB
+    if (flags & CERIALIZER_ARENA_HUGETLB) {
+        mapped = arena_round_up(size, ARENA_HUGE_PAGE_SIZE);
+        base = mmap(NULL, mapped, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base == MAP_FAILED) {
+            base = NULL; /* no huge pages reserved, fall back */
+        } else {
+            backing = CERIALIZER_ARENA_HUGETLB;
+        }
+    }
+#endif
+    if (base == NULL && (flags & CERIALIZER_ARENA_THP)) {
+        /* over-map to align the chunk to a huge page boundary */
+        char *raw;
+        mapped = arena_round_up(size, ARENA_HUGE_PAGE_SIZE);
+        raw = (char *)mmap(NULL, mapped + ARENA_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw != (char *)MAP_FAILED) {
+            char *aligned = (char *)arena_round_up((uintptr_t)raw, ARENA_HUGE_PAGE_SIZE);
+            size_t head = aligned - raw;
+            if (head > 0) {
+                munmap(raw, head);
+            }
+            munmap(aligned + mapped, ARENA_HUGE_PAGE_SIZE - head);
+            base = aligned;
+#ifdef MADV_HUGEPAGE
+            if (madvise(base, mapped, MADV_HUGEPAGE) == 0) {
+                backing = CERIALIZER_ARENA_THP;
+            }
+#endif
+        }
+    }
+    if (base == NULL) {
+        mapped = arena_round_up(size, (size_t)sysconf(_SC_PAGESIZE));
+        base = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            return NULL;
+        }
+    }
+#else
+    mapped = size;
+    base = malloc(mapped);
+    if (base == NULL) {
+        return NULL;
+    }
+#endif
+
+    chunk = (cerializer_arena_chunk *)base;
+    chunk->next = NULL;
+    chunk->cursor = (char *)base + ARENA_CHUNK_HEADER_SIZE;
+    chunk->end = (char *)base + mapped;
+    chunk->base = base;
+    chunk->mapped = mapped;
+    chunk->backing = backing;
+    return chunk;
+}
+
+/**
+ * Release the memory of a chunk.
+ *
+ * @param chunk the chunk to release.
+ */
+static void
+arena_chunk_unmap(cerializer_arena_chunk *chunk) {
+#ifdef ARENA_USE_MMAP
+    munmap(chunk->base, chunk->mapped);
+#else
+    free(chunk->base);
+#endif
+}
+
+/**
+ * Carve memory out of a chunk.
+ *
+ * @param chunk the chunk to use.
+ * @param size amount of memory to allocate.
+ *
+ * @return pointer to allocated memory, NULL if the chunk is full.
+ */
+static void *
+arena_chunk_alloc(cerializer_arena_chunk *chunk, size_t size) {
+    /* small objects only need pointer alignment */
+    size_t alignment = size >= 16 ? 16 : 8;
+    char *ptr = (char *)arena_round_up((uintptr_t)chunk->cursor, alignment);
+    if (ptr > chunk->end || size > (size_t)(chunk->end - ptr)) {
+        return NULL;
+    }
+    chunk->cursor = ptr + size;
+    return ptr;
+}
+
+/**
+ * Arena `malloc` adapter.
+ *
+ * @param ctx the arena.
+ * @param size amount of memory to allocate.
+ *
+ * @return pointer to allocated memory, NULL on failure.
+ */
+static void *
+arena_alloc(void *ctx, size_t size) {
+    cerializer_arena *arena = (cerializer_arena *)ctx;
+    cerializer_arena_chunk *chunk = arena->chunks;
+    void *ptr = NULL;
+
+    if (chunk != NULL) {
+        ptr = arena_chunk_alloc(chunk, size);
+    }
+    if (ptr == NULL) {
+        if (size > arena->chunk_size / 4) {
+            /* large blocks get a dedicated chunk behind the current one */
+            chunk = arena_chunk_map(ARENA_CHUNK_HEADER_SIZE + size + 16, arena->flags);
+            if (chunk == NULL) {
+                return NULL;
+            }
+            if (arena->chunks != NULL) {
+                chunk->next = arena->chunks->next;
+                arena->chunks->next = chunk;
+            } else {
+                arena->chunks = chunk;
+            }
+            return arena_chunk_alloc(chunk, size);
+        }
+        chunk = arena_chunk_map(arena->chunk_size, arena->flags);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        ptr = arena_chunk_alloc(chunk, size);
+    }
+    arena->last = ptr;
+    return ptr;
+}
+
+/**
+ * Arena `realloc` adapter. The last allocation grows in place, other
+ * blocks are copied to a new allocation.
+ *
+ * @param ctx the arena.
+ * @param ptr pointer to memory to be re-allocated.
+ * @param size amount of memory to allocate.
+ *
+ * @return pointer to re-allocated memory, NULL on failure.
+ */
+static void *
+arena_realloc(void *ctx, void *ptr, size_t size) {
+    cerializer_arena *arena = (cerializer_arena *)ctx;
+    cerializer_arena_chunk *chunk;
+    size_t available = 0;
+    void *new_ptr;
+
+    if (ptr == NULL) {
+        return arena_alloc(ctx, size);
+    }
+    chunk = arena->chunks;
+    if (ptr == arena->last && size <= (size_t)(chunk->end - (char *)ptr)) {
+        chunk->cursor = (char *)ptr + size;
+        return ptr;
+    }
+    /* the old block size is unknown, but the block lies below the cursor
+     * of its chunk, so copying up to the cursor covers it */
+    while (chunk != NULL) {
+        if ((char *)ptr >= (char *)chunk->base && (char *)ptr < chunk->cursor) {
+            available = chunk->cursor - (char *)ptr;
+            break;
+        }
+        chunk = chunk->next;
+    }
+    new_ptr = arena_alloc(ctx, size);
+    if (new_ptr != NULL) {
+        memcpy(new_ptr, ptr, available < size ? available : size);
+    }
+    return new_ptr;
+}
+
+/**
+ * Arena `free` adapter. Only the last allocation is given back, all
+ * other memory is released when the arena is reset or destroyed.
+ *
+ * @param ctx the arena.
+ * @param ptr pointer to de-allocate.
+ */
+static void
+arena_free(void *ctx, void *ptr) {
+    cerializer_arena *arena = (cerializer_arena *)ctx;
+    if (ptr != NULL && ptr == arena->last) {
+        arena->chunks->cursor = (char *)ptr;
+        arena->last = NULL;
+    }
+}
+
+/**
+ * Create an arena.
+ *
+ * @param chunk_size size of the arena chunks (0 for the default size).
+ * @param flags CERIALIZER_ARENA_* flags. Huge pages are used only when
+ *        available, falling back to regular pages transparently.
+ *
+ * @return a new arena structure.
+ */
+extern cerializer_arena *
+cerializer_arena_create(size_t chunk_size, int flags) {
+    cerializer_arena *arena = (cerializer_arena *)SAFE_MALLOC(sizeof(cerializer_arena));
+    if (chunk_size == 0) {
+        chunk_size = CERIALIZER_ARENA_DEFAULT_CHUNK_SIZE;
+    }
+    arena->allocator.alloc = arena_alloc;
+    arena->allocator.realloc = arena_realloc;
+    arena->allocator.free = arena_free;
+    arena->allocator.ctx = arena;
+    arena->chunks = NULL;
+    arena->chunk_size = chunk_size;
+    arena->flags = flags;
+    arena->last = NULL;
+    return arena;
+}
+
+/**
+ * Get the allocator interface of an arena, to pass per message to
+ * dynmessage_init_with_allocator or dynmessage_deserialize_bin_with_allocator.
+ * It must not be installed with cerializer_set_allocator: resetting the
+ * arena would release memory that outlives the messages.
+ *
+ * @param arena arena structure.
+ *
+ * @return the allocator of the arena.
+ */
+extern const cerializer_allocator *
+cerializer_arena_allocator(cerializer_arena *arena) {
+    return arena != NULL ? &arena->allocator : NULL;
+}
+
+/**
+ * Release all memory allocated from the arena at once, keeping its
+ * first chunk for new allocations.
+ *
+ * @param arena arena structure.
+ */
+extern void
+cerializer_arena_reset(cerializer_arena *arena) {
+    if (arena != NULL && arena->chunks != NULL) {
+        cerializer_arena_chunk *it = arena->chunks->next;
+        while (it) {
+            cerializer_arena_chunk *next = it->next;
+            arena_chunk_unmap(it);
+            it = next;
+        }
+        arena->chunks->next = NULL;
+        arena->chunks->cursor = (char *)arena->chunks->base + ARENA_CHUNK_HEADER_SIZE;
+        arena->last = NULL;
+    }
+}
+
+/**
+ * Get the statistics of an arena.
+ *
+ * @param arena arena structure.
+ * @param stats structure to fill in.
+ */
+extern void
+cerializer_arena_get_stats(cerializer_arena *arena, cerializer_arena_stats *stats) {
+    if (stats != NULL) {
+        memset(stats, 0, sizeof(cerializer_arena_stats));
+        if (arena != NULL) {
+            cerializer_arena_chunk *it = arena->chunks;
+            while (it) {
+                stats->chunks++;
+                stats->mapped_bytes += it->mapped;
+                stats->used_bytes += it->cursor - (char *)it->base - ARENA_CHUNK_HEADER_SIZE;
+                if (it->backing == CERIALIZER_ARENA_HUGETLB) {
+                    stats->hugetlb_chunks++;
+                } else if (it->backing == CERIALIZER_ARENA_THP) {
+                    stats->thp_chunks++;
+                }
+                it = it->next;
+            }
+        }
+    }
+}
+
+/**
+ * Destroy the arena, releasing all its memory.
+ *
+ * @param arena arena structure.
+ */
+extern void
+cerializer_arena_destroy(cerializer_arena *arena) {
+    if (arena != NULL) {
+        cerializer_arena_chunk *it = arena->chunks;
+        while (it) {
+            cerializer_arena_chunk *next = it->next;
+            arena_chunk_unmap(it);
+            it = next;
+        }
+        SAFE_FREE(arena);
+    }
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Arena allocator for bulk de-serialization workloads. Memory is carved
+ * out of large chunks, optionally backed by huge pages, so that decoded
+ * messages are packed densely and need few TLB entries. Individual frees
+ * are (mostly) no-ops, all memory is released at once by resetting or
+ * destroying the arena. An arena must not be used by several threads
+ * concurrently.
+ */
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "stdlib_util.h"
+
+/* default size of an arena chunk (a multiple of the 2 MiB huge page size) */
+#define CERIALIZER_ARENA_DEFAULT_CHUNK_SIZE (32 * 1024 * 1024)
+
+/* try explicit huge pages (mmap with MAP_HUGETLB) for the chunks */
+#define CERIALIZER_ARENA_HUGETLB 0x1
+
+/* advise transparent huge pages (madvise with MADV_HUGEPAGE) for the chunks */
+#define CERIALIZER_ARENA_THP 0x2
+
+/* back the chunks by huge pages by any available means */
+#define CERIALIZER_ARENA_HUGEPAGES (CERIALIZER_ARENA_HUGETLB | CERIALIZER_ARENA_THP)
+
+/* Header of a memory chunk of an arena, stored at the start of the chunk. */
+typedef struct _cerializer_arena_chunk_struct {
+    struct _cerializer_arena_chunk_struct *next; /* next (older) chunk */
+    char *cursor; /* next free byte */
+    char *end; /* end of the usable chunk memory */
+    void *base; /* start of the mapping holding the chunk */
+    size_t mapped; /* size of the mapping holding the chunk */
+    int backing; /* CERIALIZER_ARENA_* flag that backs the chunk, 0 for none */
+} cerializer_arena_chunk;
+
+/* Structure to hold an arena. */
+typedef struct _cerializer_arena_struct {
+    cerializer_allocator allocator; /* allocator interface of the arena */
+    cerializer_arena_chunk *chunks; /* chunks, the current one first */
+    size_t chunk_size; /* size of a regular chunk */
+    int flags; /* CERIALIZER_ARENA_* flags */
+    void *last; /* last allocation of the current chunk (NULL if none) */
+} cerializer_arena;
+
+/* Structure to hold statistics of an arena. */
+typedef struct _cerializer_arena_stats_struct {
+    size_t chunks; /* number of chunks */
+    size_t mapped_bytes; /* bytes mapped for all chunks */
+    size_t used_bytes; /* bytes handed out (including alignment) */
+    size_t hugetlb_chunks; /* chunks backed by explicit huge pages */
+    size_t thp_chunks; /* chunks advised to use transparent huge pages */
+} cerializer_arena_stats;
+
+/**
+ * Create an arena.
+ *
+ * @param chunk_size size of the arena chunks (0 for the default size).
+ * @param flags CERIALIZER_ARENA_* flags. Huge pages are used only when
+ *        available, falling back to regular pages transparently.
+ *
+ * @return a new arena structure.
+ */
+extern cerializer_arena *
+cerializer_arena_create(size_t chunk_size, int flags);
+
+/**
+ * Get the allocator interface of an arena, to pass per message to
+ * dynmessage_init_with_allocator or dynmessage_deserialize_bin_with_allocator.
+ * It must not be installed with cerializer_set_allocator: resetting the
+ * arena would release memory that outlives the messages.
+ *
+ * @param arena arena structure.
+ *
+ * @return the allocator of the arena.
+ */
+extern const cerializer_allocator *
+cerializer_arena_allocator(cerializer_arena *arena);
+
+/**
+ * Release all memory allocated from the arena at once, keeping its
+ * first chunk for new allocations.
+ *
+ * @param arena arena structure.
+ */
+extern void
+cerializer_arena_reset(cerializer_arena *arena);
+
+/**
+ * Get the statistics of an arena.
+ *
+ * @param arena arena structure.
+ * @param stats structure to fill in.
+ */
+extern void
+cerializer_arena_get_stats(cerializer_arena *arena, cerializer_arena_stats *stats);
+
+/**
+ * Destroy the arena, releasing all its memory.
+ *
+ * @param arena arena structure.
+ */
+extern void
+cerializer_arena_destroy(cerializer_arena *arena);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* ARENA_H_ */
@@ -0,0 +1,380 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * C++ binding (header only, C++20) of the dynamic message.
+ *
+ * dyn::Message owns a dynamicmessage and all its contents: it can be moved
+ * but not copied, and releases the message when destroyed (also upon an
+ * exception). Field values are accessed with get<T>/set<T>, the field type
+ * following from T at compile time (see dyn::field_type_v). String values
+ * are read as std::string_view into the message, without copies, and
+ * messages are (de)serialized from/into buffers of the caller (std::span),
+ * so the binding adds no copies to those of the C library.
+ */
+
+#ifndef CERIALIZER_HPP_
+#define CERIALIZER_HPP_
+
+#if __cplusplus < 202002L
+#error "cerializer.hpp requires C++20"
+#endif
+
+#include <climits>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "cerializer.h"
+#include "dynmessage.h"
+#include "dynmessage_cerializer.h"
+
+namespace dyn {
+
+/**
+ * Get the dynamic message field type of a C++ type: enumerations,
+ * char (INT8_TYPE), integers by size and signedness, float, double and
+ * std::string_view (STRING_TYPE). NO_TYPE for any other type.
+ *
+ * @return dynamic message field type of T.
+ */
+template <typename T>
+constexpr dyn_field_type
+field_type_of() {
+    if constexpr (std::is_enum_v<T>) {
+        return ENUMERATION_TYPE;
+    } else if constexpr (std::is_same_v<T, char>) {
+        return INT8_TYPE;
+    } else if constexpr (std::is_same_v<T, bool> || !std::is_integral_v<T>) {
+        if constexpr (std::is_same_v<T, float>) {
+            return FLOAT32_TYPE;
+        } else if constexpr (std::is_same_v<T, double>) {
+            return FLOAT64_TYPE;
+        } else if constexpr (std::is_same_v<T, std::string_view>) {
+            return STRING_TYPE;
+        } else {
+            return NO_TYPE;
+        }
+    } else if constexpr (sizeof(T) == 1) {
+        return std::is_signed_v<T> ? INT8_TYPE : UNSIGNED_INT8_TYPE;
+    } else if constexpr (sizeof(T) == 2) {
+        return std::is_signed_v<T> ? INT16_TYPE : UNSIGNED_INT16_TYPE;
+    } else if constexpr (sizeof(T) == 4) {
+        return std::is_signed_v<T> ? INT32_TYPE : UNSIGNED_INT32_TYPE;
+    } else if constexpr (sizeof(T) == 8) {
+        return std::is_signed_v<T> ? INT64_TYPE : UNSIGNED_INT64_TYPE;
+    } else {
+        return NO_TYPE;
+    }
+}
+
+/* dynamic message field type of a C++ type (see field_type_of) */
+template <typename T>
+inline constexpr dyn_field_type field_type_v = field_type_of<T>();
+
+/* value type stored for a C++ type: strings (anything but arithmetic and
+ * enumeration types convertible to std::string_view) are stored as such */
+template <typename T>
+using field_value_t = std::conditional_t<
+    !std::is_arithmetic_v<T> && !std::is_enum_v<T> && std::is_convertible_v<const T &, std::string_view>,
+    std::string_view,
+    T>;
+
+namespace detail {
+
+/**
+ * Convert a field value to a C++ type.
+ *
+ * @param value the field value, of type field_type_v<T>.
+ *
+ * @return the value as T.
+ */
+template <typename T>
+inline T
+from_field_value(const dyn_field_value &value) {
+    constexpr dyn_field_type type = field_type_v<T>;
+    if constexpr (type == ENUMERATION_TYPE) {
+        return static_cast<T>(value.enum_value);
+    } else if constexpr (type == INT8_TYPE) {
+        return static_cast<T>(value.int8_value);
+    } else if constexpr (type == UNSIGNED_INT8_TYPE) {
+        return static_cast<T>(value.uint8_value);
+    } else if constexpr (type == INT16_TYPE) {
+        return static_cast<T>(value.int16_value);
+    } else if constexpr (type == UNSIGNED_INT16_TYPE) {
+        return static_cast<T>(value.uint16_value);
+    } else if constexpr (type == INT32_TYPE) {
+        return static_cast<T>(value.int32_value);
+    } else if constexpr (type == UNSIGNED_INT32_TYPE) {
+        return static_cast<T>(value.uint32_value);
+    } else if constexpr (type == INT64_TYPE) {
+        return static_cast<T>(value.int64_value);
+    } else if constexpr (type == UNSIGNED_INT64_TYPE) {
+        return static_cast<T>(value.uint64_value);
+    } else if constexpr (type == FLOAT32_TYPE) {
+        return value.float32_value;
+    } else if constexpr (type == FLOAT64_TYPE) {
+        return value.float64_value;
+    } else {
+        return std::string_view(value.string_value);
+    }
+}
+
+/**
+ * Convert a C++ value (but a string) to the C type the dynamic message
+ * expects for its field type (see dynmessage_put_field_and_value).
+ *
+ * @param value the value.
+ *
+ * @return the value as the C type of field_type_v<T>.
+ */
+template <typename T>
+inline auto
+to_c_value(T value) {
+    constexpr dyn_field_type type = field_type_v<T>;
+    if constexpr (type == ENUMERATION_TYPE) {
+        return static_cast<unsigned int>(value);
+    } else if constexpr (type == INT8_TYPE) {
+        return static_cast<char>(value);
+    } else if constexpr (type == UNSIGNED_INT8_TYPE) {
+        return static_cast<unsigned char>(value);
+    } else if constexpr (type == INT16_TYPE) {
+        return static_cast<int>(value);
+    } else if constexpr (type == UNSIGNED_INT16_TYPE) {
+        return static_cast<unsigned int>(value);
+    } else if constexpr (type == INT32_TYPE) {
+        return static_cast<long>(value);
+    } else if constexpr (type == UNSIGNED_INT32_TYPE) {
+        return static_cast<unsigned long>(value);
+    } else if constexpr (type == INT64_TYPE) {
+        return static_cast<long long>(value);
+    } else if constexpr (type == UNSIGNED_INT64_TYPE) {
+        return static_cast<unsigned long long>(value);
+    } else {
+        return value; /* float, double */
+    }
+}
+
+} /* namespace detail */
+
+/**
+ * Dynamic message owning its contents (move only). A moved from message
+ * may only be assigned to or destroyed.
+ */
+class Message {
+public:
+    /**
+     * Create an empty dynamic message.
+     *
+     * @param name name of the message(not NULL).
+     * @param allocator allocator of the message contents (NULL for the global allocator).
+     */
+    explicit Message(const char *name, const cerializer_allocator *allocator = nullptr)
+        : message_(dynmessage_create()) {
+        dynmessage_init_with_allocator(message_, const_cast<char *>(name), allocator);
+    }
+
+    /**
+     * Take ownership of a dynamic message (e.g. returned by dynmessage_deserialize_bin).
+     *
+     * @param message the dynamic message(not NULL), released with dynmessage_destroy.
+     */
+    explicit Message(dynamicmessage *message) noexcept : message_(message) {}
+
+    Message(const Message &) = delete;
+    Message &operator=(const Message &) = delete;
+
+    Message(Message &&other) noexcept : message_(std::exchange(other.message_, nullptr)) {}
+
+    Message &
+    operator=(Message &&other) noexcept {
+        if (this != &other) {
+            reset();
+            message_ = std::exchange(other.message_, nullptr);
+        }
+        return *this;
+    }
+
+    ~Message() {
+        reset();
+    }
+
+    /**
+     * De-serialize a dynamic message.
+     *
+     * @param data the serialized dynamic message (possibly preceded by its
+     *        schema fingerprint).
+     * @param allocator allocator of the message contents (NULL for the global allocator).
+     *
+     * @return the dynamic message, none if the data is not a serialized dynamic message.
+     */
+    static std::optional<Message>
+    deserialize(std::span<const std::byte> data, const cerializer_allocator *allocator = nullptr) {
+        std::optional<Message> result;
+        if (data.size() <= static_cast<std::size_t>(INT_MAX)) {
+            void *message = dynmessage_deserialize_bin_with_allocator(
+                const_cast<unsigned char *>(reinterpret_cast<const unsigned char *>(data.data())),
+                static_cast<int>(data.size()),
+                allocator);
+            if (message != nullptr) {
+                result.emplace(static_cast<dynamicmessage *>(message));
+            }
+        }
+        return result;
+    }
+
+    /* whether the message was not moved from */
+    explicit operator bool() const noexcept {
+        return message_ != nullptr;
+    }
+
+    /* name of the message */
+    std::string_view
+    name() const noexcept {
+        return message_->name;
+    }
+
+    /* number of fields of the message */
+    int
+    field_count() const noexcept {
+        return message_->field_count;
+    }
+
+    /* schema fingerprint of the message (see dynmessage_fingerprint) */
+    unsigned long long
+    fingerprint() const {
+        return dynmessage_fingerprint(message_);
+    }
+
+    /**
+     * Test whether the message has a field.
+     *
+     * @param name name of the field(not NULL).
+     *
+     * @return true if the message has the field, false otherwise.
+     */
+    bool
+    has(const char *name) const {
+        dyn_field field;
+        dynmessage_get_field(message_, const_cast<char *>(name), &field);
+        return field.seq != -1;
+    }
+
+    /**
+     * Get the value of a field. String values (std::string_view) refer to
+     * the message and are valid until the field is set or the message is
+     * destroyed.
+     *
+     * @param name name of the field(not NULL).
+     *
+     * @return the field value, none if the message has no such field of
+     *         type field_type_v<T>.
+     */
+    template <typename T>
+    std::optional<T>
+    get(const char *name) const {
+        static_assert(field_type_v<T> != NO_TYPE, "no dynamic message field type for T");
+        std::optional<T> result;
+        dyn_field field;
+        dynmessage_get_field(message_, const_cast<char *>(name), &field);
+        if (field.seq != -1 && field.type == field_type_v<T> && field.value != nullptr) {
+            result = detail::from_field_value<T>(*field.value);
+        }
+        return result;
+    }
+
+    /**
+     * Add a field, or update the value of a field, of type field_type_v of
+     * the (stored) value type (see field_value_t).
+     *
+     * @param name name of the field(not NULL).
+     * @param value the field value.
+     *
+     * @return true upon success, false if the message has the field with another type.
+     */
+    template <typename T>
+    bool
+    set(const char *name, const T &value) {
+        using value_type = field_value_t<T>;
+        constexpr dyn_field_type type = field_type_v<value_type>;
+        static_assert(type != NO_TYPE, "no dynamic message field type for T");
+        if constexpr (type == STRING_TYPE) {
+            const std::string_view string_value(value);
+            return dynmessage_put_string_field_value_len(
+                message_, const_cast<char *>(name), string_value.data(), string_value.size()) != 0;
+        } else {
+            dyn_field field;
+            dynmessage_get_field(message_, const_cast<char *>(name), &field);
+            if (field.seq != -1 && field.type != type) {
+                return false;
+            }
+            auto c_value = detail::to_c_value<value_type>(value);
+            dynmessage_put_field_and_value(message_, const_cast<char *>(name), type, &c_value);
+            return true;
+        }
+    }
+
+    /* length of the serialized message, zero if the message has no fields */
+    std::size_t
+    serialized_size() const {
+        return dynmessage_serialized_len(message_);
+    }
+
+    /**
+     * Serialize the message into a buffer.
+     *
+     * @param buffer the buffer (of at least serialized_size() bytes).
+     *
+     * @return the serialized message (the start of the buffer), empty if
+     *         the buffer is too small or the message has no fields.
+     */
+    std::span<const std::byte>
+    serialize_into(std::span<std::byte> buffer) const {
+        std::size_t length = dynmessage_serialize_bin_into(
+            message_, reinterpret_cast<unsigned char *>(buffer.data()), buffer.size());
+        return buffer.first(length);
+    }
+
+    /* the dynamic message (still owned) */
+    dynamicmessage *
+    c_message() const noexcept {
+        return message_;
+    }
+
+    /* give up ownership of the dynamic message (to be destroyed with dynmessage_destroy) */
+    dynamicmessage *
+    release() noexcept {
+        return std::exchange(message_, nullptr);
+    }
+
+private:
+    void
+    reset() noexcept {
+        if (message_ != nullptr) {
+            dynmessage_destroy(message_);
+            message_ = nullptr;
+        }
+    }
+
+    dynamicmessage *message_; /* the owned dynamic message */
+};
+
+} /* namespace dyn */
+
+#endif /* CERIALIZER_HPP_ */
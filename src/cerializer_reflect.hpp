@@ -0,0 +1,597 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * C++ (header only, C++20) codec of structures declaring their fields at
+ * compile time, writing and reading the serialized dynamic message format
+ * the way cerializertool generated functions do, without generated code.
+ *
+ * A structure declares its message name and fields (member pointers and
+ * field names) once:
+ *
+ *   struct heartbeat {
+ *       int id;
+ *       double load;
+ *       std::string host;
+ *   };
+ *   CERIALIZER_REFLECT(heartbeat, "heartbeat",
+ *       CERIALIZER_FIELD(heartbeat, id),
+ *       CERIALIZER_FIELD(heartbeat, load),
+ *       cerializer::field("host name", &heartbeat::host));
+ *
+ * Member types are those of dyn::field_type_v (see cerializer.hpp), with
+ * std::string for STRING_TYPE fields. The serialized message with empty
+ * strings, the offsets of all field values and the schema fingerprint are
+ * computed at compile time: cerializer::encode copies the constant bytes
+ * and stores the values, cerializer::decode compares the constant bytes
+ * and loads the values, falling back to the generic de-serialization for
+ * messages laid out otherwise.
+ */
+
+#ifndef CERIALIZER_REFLECT_HPP_
+#define CERIALIZER_REFLECT_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "cerializer.hpp"
+
+namespace cerializer {
+
+/**
+ * Message name and fields of a structure, to be specialized (see
+ * CERIALIZER_REFLECT) with
+ *
+ *   static constexpr std::string_view name;  name of the message
+ *   static constexpr auto fields;            tuple of cerializer::field
+ */
+template <typename T>
+struct reflect;
+
+/* field of a structure: field name and member pointer */
+template <typename C, typename M>
+struct field_info {
+    using member_type = M;
+    std::string_view name; /* name of the field */
+    M C::*member; /* member holding the field value */
+};
+
+/**
+ * Declare a field of a structure.
+ *
+ * @param name name of the field.
+ * @param member member holding the field value.
+ *
+ * @return the field.
+ */
+template <typename C, typename M>
+constexpr field_info<C, M>
+field(std::string_view name, M C::*member) {
+    return field_info<C, M>{name, member};
+}
+
+/* declare a field of a structure, named after its member */
+#define CERIALIZER_FIELD(type, member) ::cerializer::field(#member, &type::member)
+
+/* declare the message name and fields of a structure (at global namespace scope) */
+#define CERIALIZER_REFLECT(type, message_name, ...) \
+    template <> \
+    struct cerializer::reflect<type> { \
+        static constexpr std::string_view name = message_name; \
+        static constexpr auto fields = std::make_tuple(__VA_ARGS__); \
+    }
+
+namespace detail {
+
+/* 'Dynamic Message Start' identifiers (see dynmessage_cerializer.c) */
+inline constexpr unsigned long message_start = 1044266557UL;
+inline constexpr unsigned long message_start_fingerprint = 1044266566UL;
+
+/* lengths of the serialized message and field parts but names and values */
+inline constexpr std::size_t message_head_fixed_len = 16;
+inline constexpr std::size_t field_head_fixed_len = 16;
+
+/* dynamic message field type of a member type */
+template <typename M>
+constexpr dyn_field_type
+wire_type() {
+    if constexpr (std::is_same_v<M, std::string>) {
+        return STRING_TYPE;
+    } else {
+        return dyn::field_type_v<M>;
+    }
+}
+
+/* length of a serialized field value of a type, zero for strings */
+constexpr std::size_t
+value_size(dyn_field_type type) {
+    switch (type) {
+    case INT8_TYPE:
+    case UNSIGNED_INT8_TYPE:
+        return 1;
+    case INT16_TYPE:
+    case UNSIGNED_INT16_TYPE:
+        return 2;
+    case ENUMERATION_TYPE:
+    case INT32_TYPE:
+    case UNSIGNED_INT32_TYPE:
+    case FLOAT32_TYPE:
+        return 4;
+    case INT64_TYPE:
+    case UNSIGNED_INT64_TYPE:
+    case FLOAT64_TYPE:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+/* member type of a field */
+template <typename F>
+using member_type_t = typename std::remove_cvref_t<F>::member_type;
+
+/* number of fields of a structure */
+template <typename T>
+inline constexpr std::size_t field_count = std::tuple_size_v<std::remove_const_t<decltype(reflect<T>::fields)>>;
+
+/**
+ * Apply a function to each field of a structure, in declaration order.
+ *
+ * @param f function of the field and of its index (std::integral_constant).
+ */
+template <typename T, typename F>
+constexpr void
+for_each_field(F &&f) {
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (f(std::get<I>(reflect<T>::fields), std::integral_constant<std::size_t, I>{}), ...);
+    }(std::make_index_sequence<field_count<T>>{});
+}
+
+/* length of the serialized message of a structure with empty strings */
+template <typename T>
+constexpr std::size_t
+fixed_len() {
+    std::size_t len = message_head_fixed_len + reflect<T>::name.size();
+    for_each_field<T>([&](const auto &f, auto) {
+        static_assert(wire_type<member_type_t<decltype(f)>>() != NO_TYPE, "no dynamic message field type for member");
+        len += field_head_fixed_len + f.name.size() + value_size(wire_type<member_type_t<decltype(f)>>());
+    });
+    return len;
+}
+
+/* whether a structure has no string fields */
+template <typename T>
+constexpr bool
+is_fixed() {
+    bool fixed = true;
+    for_each_field<T>([&](const auto &f, auto) {
+        fixed = fixed && wire_type<member_type_t<decltype(f)>>() != STRING_TYPE;
+    });
+    return fixed;
+}
+
+/**
+ * Compute the offsets of the fields (start of fields, or of their values)
+ * in the serialized message of a structure with empty strings.
+ *
+ * @param values true for the offsets of the field values.
+ *
+ * @return offset of each field.
+ */
+template <typename T>
+constexpr std::array<std::size_t, field_count<T>>
+offsets(bool values) {
+    std::array<std::size_t, field_count<T>> result{};
+    std::size_t pos = message_head_fixed_len + reflect<T>::name.size();
+    for_each_field<T>([&](const auto &f, auto i) {
+        std::size_t head = field_head_fixed_len + f.name.size();
+        result[i] = values ? pos + head : pos;
+        pos += head + value_size(wire_type<member_type_t<decltype(f)>>());
+    });
+    return result;
+}
+
+/* serialized message of a structure with empty strings and all values zero */
+template <typename T>
+constexpr std::array<unsigned char, fixed_len<T>()>
+message_template() {
+    std::array<unsigned char, fixed_len<T>()> bytes{};
+    std::size_t pos = 0;
+    auto put32 = [&](unsigned long value) {
+        bytes[pos++] = (unsigned char)(value >> 24);
+        bytes[pos++] = (unsigned char)(value >> 16);
+        bytes[pos++] = (unsigned char)(value >> 8);
+        bytes[pos++] = (unsigned char)value;
+    };
+    auto put_name = [&](std::string_view name) {
+        put32(name.size());
+        for (char c : name) {
+            bytes[pos++] = (unsigned char)c;
+        }
+    };
+    put32(message_start);
+    put32(fixed_len<T>());
+    put_name(reflect<T>::name);
+    put32(field_count<T>);
+    for_each_field<T>([&](const auto &f, auto) {
+        constexpr dyn_field_type type = wire_type<member_type_t<decltype(f)>>();
+        put32(field_head_fixed_len + f.name.size() + value_size(type));
+        put_name(f.name);
+        put32(type);
+        put32(value_size(type));
+        pos += value_size(type);
+    });
+    return bytes;
+}
+
+/* schema fingerprint of a structure (as dynmessage_fingerprint calculates it) */
+template <typename T>
+constexpr unsigned long long
+fingerprint() {
+    unsigned long long hash = 14695981039346656037ULL;
+    auto add32 = [&](unsigned long value) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            hash ^= (unsigned char)(value >> shift);
+            hash *= 1099511628211ULL;
+        }
+    };
+    auto add_name = [&](std::string_view name) {
+        add32(name.size());
+        for (char c : name) {
+            hash ^= (unsigned char)c;
+            hash *= 1099511628211ULL;
+        }
+    };
+    add_name(reflect<T>::name);
+    hash = hash != 0 ? hash : 1;
+    for_each_field<T>([&](const auto &f, auto) {
+        add_name(f.name);
+        add32(wire_type<member_type_t<decltype(f)>>());
+        hash = hash != 0 ? hash : 1;
+    });
+    return hash;
+}
+
+/* compile time layout of the serialized message of a structure */
+template <typename T>
+struct layout {
+    static constexpr std::size_t len = fixed_len<T>(); /* length with empty strings */
+    static constexpr std::size_t head_len = message_head_fixed_len + reflect<T>::name.size();
+    static constexpr bool fixed = is_fixed<T>(); /* no string fields */
+    static constexpr std::array<std::size_t, field_count<T>> field_offsets = offsets<T>(false);
+    static constexpr std::array<std::size_t, field_count<T>> value_offsets = offsets<T>(true);
+    static constexpr std::array<unsigned char, len> bytes = message_template<T>();
+    static constexpr unsigned long long fingerprint = detail::fingerprint<T>();
+};
+
+/* store an integer (big endian) */
+template <std::size_t N>
+inline void
+store_be(unsigned char *data, unsigned long long value) {
+    for (std::size_t i = 0; i < N; i++) {
+        data[i] = (unsigned char)(value >> (8 * (N - 1 - i)));
+    }
+}
+
+/* load an integer (big endian) */
+template <std::size_t N>
+inline unsigned long long
+load_be(const unsigned char *data) {
+    unsigned long long value = 0;
+    for (std::size_t i = 0; i < N; i++) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+/* store a field value (but a string) */
+template <typename M>
+inline void
+store_value(unsigned char *data, const M &value) {
+    constexpr dyn_field_type type = wire_type<M>();
+    if constexpr (type == FLOAT32_TYPE) {
+        serialize_float32(data, value);
+    } else if constexpr (type == FLOAT64_TYPE) {
+        serialize_float64(data, value);
+    } else {
+        store_be<value_size(type)>(data, static_cast<unsigned long long>(value));
+    }
+}
+
+/* load a field value (but a string) */
+template <typename M>
+inline M
+load_value(const unsigned char *data) {
+    constexpr dyn_field_type type = wire_type<M>();
+    constexpr std::size_t size = value_size(type);
+    if constexpr (type == FLOAT32_TYPE) {
+        return deserialize_float32(const_cast<unsigned char *>(data));
+    } else if constexpr (type == FLOAT64_TYPE) {
+        return deserialize_float64(const_cast<unsigned char *>(data));
+    } else if constexpr (type == INT8_TYPE) {
+        return static_cast<M>(static_cast<signed char>(data[0]));
+    } else if constexpr (type == INT16_TYPE) {
+        return static_cast<M>(static_cast<short>(load_be<size>(data)));
+    } else if constexpr (type == INT32_TYPE) {
+        return static_cast<M>(static_cast<int>(load_be<size>(data)));
+    } else if constexpr (type == INT64_TYPE) {
+        return static_cast<M>(static_cast<long long>(load_be<size>(data)));
+    } else {
+        return static_cast<M>(load_be<size>(data));
+    }
+}
+
+/**
+ * Decode a serialized message laid out as encode does.
+ *
+ * @param data the serialized message.
+ * @param data_len length in bytes of the data.
+ * @param trusted true if the schema fingerprint of the data matched, in
+ *        which case field names and types are not compared.
+ * @param object the decoded structure, only modified upon success.
+ *
+ * @return true upon success, false if the data is not laid out as expected.
+ */
+template <typename T>
+bool
+decode_layout(const unsigned char *data, std::size_t data_len, bool trusted, T &object) {
+    using L = layout<T>;
+    std::array<std::size_t, field_count<T>> value_pos{};
+    std::array<std::size_t, field_count<T>> value_len{};
+    bool ok = true;
+    if constexpr (L::fixed) {
+        /* constant layout: compare the bytes between the values */
+        std::size_t pos = 0;
+        if (data_len < L::len) {
+            return false;
+        }
+        for_each_field<T>([&](const auto &f, auto i) {
+            ok = ok && (trusted || std::memcmp(data + pos, L::bytes.data() + pos, L::value_offsets[i] - pos) == 0);
+            pos = L::value_offsets[i] + value_size(wire_type<member_type_t<decltype(f)>>());
+        });
+        value_pos = L::value_offsets;
+    } else {
+        std::size_t length, offset = L::head_len;
+        /* message header (but the message length) */
+        if (data_len < L::head_len
+            || (!trusted
+                && (std::memcmp(data, L::bytes.data(), 4) != 0
+                    || std::memcmp(data + 8, L::bytes.data() + 8, L::head_len - 8) != 0))) {
+            return false;
+        }
+        length = load_be<4>(data + 4);
+        if (length > data_len) {
+            return false;
+        }
+        for_each_field<T>([&](const auto &f, auto i) {
+            constexpr dyn_field_type type = wire_type<member_type_t<decltype(f)>>();
+            constexpr std::size_t head = L::value_offsets[decltype(i)::value] - L::field_offsets[decltype(i)::value];
+            const unsigned char *field_head = L::bytes.data() + L::field_offsets[i];
+            std::size_t len = value_size(type);
+            if (!ok) {
+                return;
+            }
+            if constexpr (type == STRING_TYPE) {
+                /* field head but the lengths */
+                if (offset + head > length
+                    || (!trusted && std::memcmp(data + offset + 4, field_head + 4, head - 8) != 0)) {
+                    ok = false;
+                    return;
+                }
+                len = load_be<4>(data + offset + head - 4);
+                if (len > length - offset - head || load_be<4>(data + offset) != head + len) {
+                    ok = false;
+                    return;
+                }
+            } else if (offset + head + len > length
+                || (!trusted && std::memcmp(data + offset, field_head, head) != 0)) {
+                ok = false;
+                return;
+            }
+            value_pos[i] = offset + head;
+            value_len[i] = len;
+            offset = value_pos[i] + len;
+        });
+    }
+    if (!ok) {
+        return false;
+    }
+    for_each_field<T>([&](const auto &f, auto i) {
+        using M = member_type_t<decltype(f)>;
+        if constexpr (wire_type<M>() == STRING_TYPE) {
+            (object.*f.member).assign(reinterpret_cast<const char *>(data) + value_pos[i], value_len[i]);
+        } else {
+            object.*f.member = load_value<M>(data + value_pos[i]);
+        }
+    });
+    return true;
+}
+
+/**
+ * Decode a serialized message of any field order through a dynamic message.
+ *
+ * @param data the serialized message.
+ * @param object the decoded structure, only modified upon success.
+ *
+ * @return true upon success, false if the data is not a message of the structure.
+ */
+template <typename T>
+bool
+decode_dynmessage(std::span<const std::byte> data, T &object) {
+    std::optional<dyn::Message> message = dyn::Message::deserialize(data);
+    bool ok = message.has_value()
+        && message->name() == reflect<T>::name
+        && message->field_count() == (int)field_count<T>;
+    /* field values are stored as such, string values as std::string_view */
+    auto get = [&](const auto &f) {
+        using M = member_type_t<decltype(f)>;
+        using V = std::conditional_t<wire_type<M>() == STRING_TYPE, std::string_view, M>;
+        return message->template get<V>(std::string(f.name).c_str());
+    };
+    if (ok) {
+        for_each_field<T>([&](const auto &f, auto) {
+            ok = ok && get(f).has_value();
+        });
+    }
+    if (ok) {
+        for_each_field<T>([&](const auto &f, auto) {
+            object.*f.member = member_type_t<decltype(f)>(*get(f));
+        });
+    }
+    return ok;
+}
+
+} /* namespace detail */
+
+/* length of the serialized message of a structure without strings */
+template <typename T>
+inline constexpr std::size_t fixed_encoded_size = detail::layout<T>::len;
+
+/* schema fingerprint of a structure (see dynmessage_fingerprint) */
+template <typename T>
+inline constexpr unsigned long long fingerprint_v = detail::layout<T>::fingerprint;
+
+/**
+ * Get the length of the serialized message of a structure.
+ *
+ * @param object the structure.
+ *
+ * @return length of the serialized message.
+ */
+template <typename T>
+inline std::size_t
+encoded_size(const T &object) {
+    std::size_t len = detail::layout<T>::len;
+    if constexpr (!detail::layout<T>::fixed) {
+        detail::for_each_field<T>([&](const auto &f, auto) {
+            if constexpr (detail::wire_type<detail::member_type_t<decltype(f)>>() == STRING_TYPE) {
+                len += (object.*f.member).size();
+            }
+        });
+    }
+    return len;
+}
+
+/**
+ * Encode a structure as a serialized dynamic message (fields in
+ * declaration order), as cerializertool generated functions do.
+ *
+ * @param object the structure.
+ * @param buffer the buffer (of at least encoded_size(object) bytes).
+ *
+ * @return the serialized message (the start of the buffer), empty if the
+ *         buffer is too small.
+ */
+template <typename T>
+std::span<const std::byte>
+encode(const T &object, std::span<std::byte> buffer) {
+    using L = detail::layout<T>;
+    unsigned char *data = reinterpret_cast<unsigned char *>(buffer.data());
+    std::size_t length = encoded_size(object);
+    if (length > buffer.size() || length > 0xffffffffUL) {
+        return buffer.first(0);
+    }
+    if constexpr (L::fixed) {
+        /* constant layout: copy the constant bytes, store the values */
+        std::memcpy(data, L::bytes.data(), L::len);
+        detail::for_each_field<T>([&](const auto &f, auto i) {
+            detail::store_value(data + L::value_offsets[i], object.*f.member);
+        });
+    } else {
+        std::size_t offset = L::head_len;
+        std::memcpy(data, L::bytes.data(), L::head_len);
+        detail::store_be<4>(data + 4, length);
+        detail::for_each_field<T>([&](const auto &f, auto i) {
+            using M = detail::member_type_t<decltype(f)>;
+            constexpr std::size_t head = L::value_offsets[decltype(i)::value] - L::field_offsets[decltype(i)::value];
+            std::memcpy(data + offset, L::bytes.data() + L::field_offsets[i], head);
+            offset += head;
+            if constexpr (detail::wire_type<M>() == STRING_TYPE) {
+                const std::string &value = object.*f.member;
+                /* field and value lengths */
+                detail::store_be<4>(data + offset - head, head + value.size());
+                detail::store_be<4>(data + offset - 4, value.size());
+                std::memcpy(data + offset, value.data(), value.size());
+                offset += value.size();
+            } else {
+                detail::store_value(data + offset, object.*f.member);
+                offset += detail::value_size(detail::wire_type<M>());
+            }
+        });
+    }
+    return buffer.first(length);
+}
+
+/**
+ * Encode a structure as a serialized dynamic message, preceded by its
+ * schema fingerprint (fingerprint_v).
+ *
+ * @param object the structure.
+ * @param buffer the buffer (of at least DYN_MSG_FINGERPRINT_LEN + encoded_size(object) bytes).
+ *
+ * @return the serialized message (the start of the buffer), empty if the
+ *         buffer is too small.
+ */
+template <typename T>
+std::span<const std::byte>
+encode_with_fingerprint(const T &object, std::span<std::byte> buffer) {
+    if (buffer.size() < DYN_MSG_FINGERPRINT_LEN
+        || encode(object, buffer.subspan(DYN_MSG_FINGERPRINT_LEN)).empty()) {
+        return buffer.first(0);
+    }
+    unsigned char *data = reinterpret_cast<unsigned char *>(buffer.data());
+    detail::store_be<4>(data, detail::message_start_fingerprint);
+    detail::store_be<8>(data + 4, fingerprint_v<T>);
+    return buffer.first(DYN_MSG_FINGERPRINT_LEN + encoded_size(object));
+}
+
+/**
+ * Decode a serialized dynamic message (possibly preceded by its schema
+ * fingerprint) into a structure. Messages laid out as encode does are
+ * decoded directly, any others through a dynamic message.
+ *
+ * @param data the serialized message.
+ * @param object the decoded structure, only modified upon success.
+ *
+ * @return true upon success, false if the data is not a message of the structure.
+ */
+template <typename T>
+bool
+decode(std::span<const std::byte> data, T &object) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data.data());
+    std::size_t len = data.size();
+    bool trusted = false;
+    /* schema fingerprint (if any): a match vouches for the field layout */
+    if (len >= DYN_MSG_FINGERPRINT_LEN && detail::load_be<4>(bytes) == detail::message_start_fingerprint) {
+        trusted = detail::load_be<8>(bytes + 4) == fingerprint_v<T>;
+        bytes += DYN_MSG_FINGERPRINT_LEN;
+        len -= DYN_MSG_FINGERPRINT_LEN;
+    }
+    return detail::decode_layout(bytes, len, trusted, object)
+        || detail::decode_dynmessage(data, object);
+}
+
+} /* namespace cerializer */
+
+#endif /* CERIALIZER_REFLECT_HPP_ */
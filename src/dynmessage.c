@@ -24,7 +24,8 @@
 #include "dynmessage.h"
 #include "log.h"
 #include "hashmap.h"
-#include "slinkedlist.h"
+#include "intern.h"
+#include "pvec.h"
 #include "stdlib_util.h"
 #include "string_util.h"
 
@@ -67,10 +68,11 @@ update_field_value(
     dyn_field_value * value_to_store = field->value;
 
     if (value_to_store == NULL) {
-        value_to_store = (dyn_field_value *)SAFE_MALLOC(sizeof(dyn_field_value));
+        value_to_store =
+            (dyn_field_value *)SAFE_SLAB_ALLOC_WITH(message->allocator, sizeof(dyn_field_value));
     } else {
         if (field->type == STRING_TYPE) { /* clear it to be replaced with the new one */
-            free(value_to_store->string_value);
+            SAFE_FREE_WITH(message->allocator, value_to_store->string_value);
         }
     }
     /* add the new value */
@@ -109,7 +111,7 @@ update_field_value(
         value_to_store->float64_value = *(double *)value;
         break;
     case STRING_TYPE:
-        value_to_store->string_value = strdup((char *) value);
+        value_to_store->string_value = SAFE_STRDUP_WITH(message->allocator, (char *) value);
         break;
     case NO_TYPE:
         break;
@@ -119,6 +121,45 @@ update_field_value(
     hashmap_put(fields_info, name, field);
 }
 
+/**
+ * Function to add a field (without value) to a dynamic message, taking
+ * over a reference to its interned name.
+ *
+ * @param message dynamic message structure(not NULL).
+ * @param interned interned name of the field(not NULL), not present in the message.
+ * @param type type of the field.
+ *
+ * @return the added field.
+ */
+static dyn_field *
+add_interned_field(dynamicmessage *message, const char *interned, dyn_field_type type) {
+    hashmap *fields_info = (hashmap *) message->fields_info; /* use field_info as a hashmap */
+    /* create dynamic field */
+    dyn_field *field = (dyn_field *) SAFE_SLAB_ALLOC_WITH(message->allocator, sizeof(dyn_field));
+    field->name = (char *)interned;
+    field->type = type;
+    field->value = NULL;
+    field->seq = message->field_count+1;
+    message->field_count++;
+    message->fingerprint = 0; /* schema changed */
+    hashmap_put(fields_info, field->name, field);
+    return field;
+}
+
+/**
+ * Function to add a field (without value) to a dynamic message.
+ *
+ * @param message dynamic message structure(not NULL).
+ * @param name name of the field(not NULL), not present in the message.
+ * @param type type of the field.
+ *
+ * @return the added field.
+ */
+static dyn_field *
+add_field(dynamicmessage *message, char *name, dyn_field_type type) {
+    return add_interned_field(message, cerializer_intern(name), type);
+}
+
 /**
  * Allocates memory for the dynamic message structure.
  *
@@ -139,17 +180,53 @@ dynmessage_create(void) {
  */
 extern void
 dynmessage_init(dynamicmessage *message, char *name) {
-    /* use dynamic message field_info as a hashmap */
-    hashmap * field_info;
+    dynmessage_init_with_allocator(message, name, NULL);
+}
+
+/**
+ * Initialize the dynamic message, allocating all message contents
+ * through the provided allocator. Message and field names are interned
+ * (see intern.h) and thus shared by all messages.
+ *
+ * @param message dynamic message structure(not NULL).
+ * @param name name of the message(not NULL).
+ * @param allocator allocator to use (NULL for the global allocator).
+ */
+extern void
+dynmessage_init_with_allocator(
+    dynamicmessage *message,
+    char *name,
+    const cerializer_allocator *allocator) {
     if (message != NULL && name != NULL) {
-        field_info = (hashmap *)SAFE_MALLOC(sizeof(hashmap));
-        message->name = strdup(name);
-        hashmap_init(field_info, 17, test_string_equal, NULL);
-        message->fields_info = (void *)field_info;
-        message->field_count = 0;
+        dynmessage_init_with_interned_name(message, cerializer_intern(name), allocator);
     }
 }
 
+/**
+ * Initialize the dynamic message out of a message name interned by the
+ * caller (see intern.h), e.g. while de-serializing. The message takes
+ * over the caller's reference to the name.
+ *
+ * @param message dynamic message structure(not NULL).
+ * @param name interned name of the message(not NULL).
+ * @param allocator allocator to use (NULL for the global allocator).
+ */
+extern void
+dynmessage_init_with_interned_name(
+    dynamicmessage *message,
+    const char *name,
+    const cerializer_allocator *allocator) {
+    /* use dynamic message field_info as a hashmap */
+    hashmap * field_info;
+    message->allocator = allocator;
+    field_info = (hashmap *)SAFE_MALLOC_WITH(allocator, sizeof(hashmap));
+    message->name = (char *)name;
+    hashmap_init_with_allocator(field_info, 17, test_string_equal, string_hash, allocator);
+    message->fields_info = (void *)field_info;
+    message->field_count = 0;
+    message->fingerprint = 0;
+}
+
 /**
  * Function to add/update a field and/or value to a dynamic message.
  *
@@ -177,21 +254,91 @@ dynmessage_put_field_and_value(
     }
     /* check if field is already present */
     if (!hashmap_contains_key(field_info, name)) {
-        /* add field to dynamic message */
-        dyn_field *field = (dyn_field *) SAFE_MALLOC(sizeof(dyn_field)); /* create dynamic field */
-        /* add a new field */
-        field->name = strdup(name);
-        field->type = type;
-        field->value = NULL;
-        field->seq = message->field_count+1;
-        message->field_count++;
-        hashmap_put(field_info, field->name, field);
+        add_field(message, name, type);
     }
     if (value != NULL) {
         update_field_value(message, name, value);
     }
 }
 
+/**
+ * Function to add a field (without value) to a dynamic message out of a
+ * field name interned by the caller (see intern.h), e.g. while
+ * de-serializing. The message takes over the caller's reference to the
+ * name when it adds the field.
+ *
+ * @param message dynamic message structure reference(not NULL).
+ * @param name interned name of the field(not NULL).
+ * @param type type of the field.
+ *
+ * @return Non-zero if the field was added (taking over the reference),
+ *         zero otherwise (field present or invalid type).
+ */
+extern int
+dynmessage_put_interned_field(
+    dynamicmessage *message,
+    const char *name,
+    dyn_field_type type) {
+
+    int result = 0;
+    if (dynmessage_initialized(message) && name != NULL
+        && type >= ENUMERATION_TYPE && type <= STRING_TYPE
+        && !hashmap_contains_key((hashmap *)message->fields_info, (void *)name)) {
+        add_interned_field(message, name, type);
+        result++;
+    }
+    return (result);
+}
+
+/**
+ * Function to add/update a string field and its value to a dynamic message,
+ * out of a string that need not be null terminated.
+ *
+ * @param message dynamic message structure reference(not NULL).
+ * @param name name of the field(not NULL).
+ * @param value characters of the value(not NULL, unless len is zero).
+ * @param len number of characters of the value.
+ *
+ * @return Non-zero upon success, zero if the field is present with another type.
+ */
+extern int
+dynmessage_put_string_field_value_len(
+    dynamicmessage *message,
+    char *name,
+    const char *value,
+    size_t len) {
+
+    hashmap *field_info = NULL;
+    dyn_field *field = NULL;
+    int result = 0;
+    /* sanity check */
+    if (!dynmessage_initialized(message) || name == NULL || (value == NULL && len > 0)) {
+        return (result);
+    }
+
+    field_info = (hashmap *) message->fields_info; /* use field_info as a hashmap */
+    field = hashmap_get(field_info, name);
+    if (field == NULL) {
+        field = add_field(message, name, STRING_TYPE);
+    }
+    if (field->type == STRING_TYPE) {
+        char *string_value = (char *)SAFE_MALLOC_WITH(message->allocator, len + 1);
+        if (len > 0) {
+            memcpy(string_value, value, len);
+        }
+        string_value[len] = '\0';
+        if (field->value == NULL) {
+            field->value =
+                (dyn_field_value *)SAFE_SLAB_ALLOC_WITH(message->allocator, sizeof(dyn_field_value));
+        } else { /* clear it to be replaced with the new one */
+            SAFE_FREE_WITH(message->allocator, field->value->string_value);
+        }
+        field->value->string_value = string_value;
+        result++;
+    }
+    return (result);
+}
+
 /**
  * Function to retrieve the value of a dynamic message field.
  *
@@ -256,15 +403,15 @@ dynmessage_get_fields(dynamicmessage *message) {
             } else {
                 /* iterate hash map and add all entries */
                 hashmap *fields_info = NULL;
-                slinkedlist *field_keys = NULL;
-                slinkedlist_node_t *field_keys_it = NULL;
+                pvec field_keys;
+                size_t i;
 
                 fields_info = message->fields_info;
-                field_keys = hashmap_keys(fields_info);
-                field_keys_it = field_keys->head;
+                pvec_init(&field_keys);
+                hashmap_keys_to_pvec(fields_info, &field_keys);
 
-                while (field_keys_it) {
-                    char *name = (char *) field_keys_it->data;
+                for (i = 0; i < field_keys.size; i++) {
+                    char *name = (char *) field_keys.data[i];
                     dyn_field *field =(dyn_field *)malloc(sizeof(dyn_field));
                     if (field == NULL) {
                         log_function_error_message(
@@ -274,11 +421,8 @@ dynmessage_get_fields(dynamicmessage *message) {
                     }
                     dynmessage_get_field(message, name, field);
                     temp_array[field->seq-1] = field;
-
-                    field_keys_it = field_keys_it->next;
                 }
-                slinkedlist_free(field_keys, NULL);
-                SAFE_FREE(field_keys);
+                pvec_free(&field_keys, NULL);
 
                 ret->list = temp_array;
                 ret->list_length = message->field_count;
@@ -299,47 +443,40 @@ dynmessage_get_fields(dynamicmessage *message) {
 extern void
 dynmessage_free(dynamicmessage *message) {
     hashmap *fields_info = NULL;
-    slinkedlist *field_keys = NULL;
-    slinkedlist_node_t *field_keys_it = NULL;
+    pvec field_keys;
+    size_t i;
 
     /* sanity check */
     if (dynmessage_initialized(message)) {
         fields_info = message->fields_info;
-        field_keys = hashmap_keys(fields_info);
     } else {
         return;
     }
     /* get all keys */
-    if (!slinkedlist_empty(field_keys)) {
-        field_keys_it = field_keys->head;
-    }
+    pvec_init(&field_keys);
+    hashmap_keys_to_pvec(fields_info, &field_keys);
 
     /* remove all elements of field_info, field_values
      *  one by one freeing related allocated memory */
-    while (field_keys_it) {
-        char *name = (char *) field_keys_it->data;
+    for (i = 0; i < field_keys.size; i++) {
+        char *name = (char *) field_keys.data[i];
         hashmap_entry * entry = (hashmap_entry *) hashmap_remove(fields_info, name);
 
         if (entry != NULL) {
             dyn_field * field = (dyn_field *)entry->value;
             /* free related info hashmap entry */
-            free(field->name);
+            cerializer_intern_release(field->name);
             if (field->type == STRING_TYPE) {
-                free(field->value->string_value);
+                SAFE_FREE_WITH(message->allocator, field->value->string_value);
             }
-            SAFE_FREE(field->value);
-            SAFE_FREE(field);
+            SAFE_SLAB_FREE_WITH(message->allocator, field->value, sizeof(dyn_field_value));
+            SAFE_SLAB_FREE_WITH(message->allocator, field, sizeof(dyn_field));
             SAFE_FREE(entry);
         }
-
-        field_keys_it = field_keys_it->next;
-    }
-    if (!slinkedlist_empty(field_keys)) {
-        slinkedlist_free(field_keys, NULL);
-        SAFE_FREE(field_keys);
     }
+    pvec_free(&field_keys, NULL);
     hashmap_free(fields_info);
-    free(message->name);
+    cerializer_intern_release(message->name);
     message->field_count = 0;
 }
 
@@ -25,6 +25,8 @@
 extern "C" {
 #endif
 
+#include "stdlib_util.h"
+
 /* Useful macros */
 #define dynmessage_put_field(message, name, type) dynmessage_put_field_and_value(message, name, type, NULL)
 #define dynmessage_put_enum_field_value(message, name, value) dynmessage_put_field_and_value(message, name, ENUMERATION_TYPE, value)
@@ -77,7 +79,7 @@ typedef union _dyn_field_value_union {
 
 /* Structure to hold dynamic message field information. */
 typedef struct _dyn_field_struct {
-    char *name; /* name of field */
+    char *name; /* name of field (interned) */
     dyn_field_type type; /* type of field */
     dyn_field_value  *value; /* field value */
     int seq; /* dynamic field sequence order */
@@ -91,9 +93,11 @@ typedef struct _dyn_field_list {
 
 /* Structure to hold dynamic message information. */
 typedef struct _dynamicmessage_struct {
-    char *name; /* name of message */
+    char *name; /* name of message (interned) */
     void *fields_info; /* dynamic field information */
     int field_count; /* number of dynamic fields present */
+    const cerializer_allocator *allocator; /* allocator of message contents */
+    unsigned long long fingerprint; /* schema fingerprint (zero until calculated) */
 } dynamicmessage;
 
 /**
@@ -113,6 +117,36 @@ dynmessage_create(void);
 extern void
 dynmessage_init(dynamicmessage *message, char *name);
 
+/**
+ * Initialize the dynamic message, allocating all message contents
+ * through the provided allocator. Message and field names are interned
+ * (see intern.h) and thus shared by all messages.
+ *
+ * @param message dynamic message structure(not NULL).
+ * @param name name of the message(not NULL).
+ * @param allocator allocator to use (NULL for the global allocator).
+ */
+extern void
+dynmessage_init_with_allocator(
+    dynamicmessage *message,
+    char *name,
+    const cerializer_allocator *allocator);
+
+/**
+ * Initialize the dynamic message out of a message name interned by the
+ * caller (see intern.h), e.g. while de-serializing. The message takes
+ * over the caller's reference to the name.
+ *
+ * @param message dynamic message structure(not NULL).
+ * @param name interned name of the message(not NULL).
+ * @param allocator allocator to use (NULL for the global allocator).
+ */
+extern void
+dynmessage_init_with_interned_name(
+    dynamicmessage *message,
+    const char *name,
+    const cerializer_allocator *allocator);
+
 /**
  * Function to add/update a field and/or value to a dynamic message.
  *
@@ -128,6 +162,41 @@ dynmessage_put_field_and_value(
     dyn_field_type type,
     void *value);
 
+/**
+ * Function to add a field (without value) to a dynamic message out of a
+ * field name interned by the caller (see intern.h), e.g. while
+ * de-serializing. The message takes over the caller's reference to the
+ * name when it adds the field.
+ *
+ * @param message dynamic message structure reference(not NULL).
+ * @param name interned name of the field(not NULL).
+ * @param type type of the field.
+ *
+ * @return Non-zero if the field was added (taking over the reference),
+ *         zero otherwise (field present or invalid type).
+ */
+extern int
+dynmessage_put_interned_field(
+    dynamicmessage *message,
+    const char *name,
+    dyn_field_type type);
+
+/**
+ * Function to add/update a string field and its value to a dynamic message,
+ * out of a string that need not be null terminated.
+ * @param message dynamic message structure reference(not NULL).
+ * @param name name of the field(not NULL).
+ * @param value characters of the value(not NULL, unless len is zero).
+ * @param len number of characters of the value.
+ * @return Non-zero upon success, zero if the field is present with another type.
+ */
+extern int
+dynmessage_put_string_field_value_len(
+    dynamicmessage *message,
+    char *name,
+    const char *value,
+    size_t len);
+
 /**
  * Function to retrieve the value of a dynamic message field.
  *
@@ -141,6 +210,8 @@ dynmessage_get_field(
 
 /**
  * Return list(dynamic array) of all fields of a dynamic message.
+ * The list, its array and all its fields are allocated with the standard
+ * library `malloc` function and should be released with `free`.
  *
  * @param message dynamic message structure reference(not NULL).
  *
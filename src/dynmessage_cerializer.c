@@ -23,6 +23,7 @@
 
 #include "dynmessage_cerializer.h"
 #include "dynmessage.h"
+#include "intern.h"
 #include "stdlib_util.h"
 #include "log.h"
 
@@ -30,9 +31,14 @@
 #define DYN_FIELD_FIXED_LEN 16
 #define DYN_MSG_MIN_LEN 32
 #define DYN_MSG_START 1044266557
+#define DYN_MSG_START_FINGERPRINT 1044266566
 #define BYTES_4 4
 #define BYTES_8 8
 
+/* FNV-1a (64 bit) parameters of the schema fingerprint */
+#define FINGERPRINT_OFFSET_BASIS 14695981039346656037ULL
+#define FINGERPRINT_PRIME 1099511628211ULL
+
 /**
  *  SERIALIZED DYNAMIC MESSAGE BINARY FORMAT
  *
@@ -50,6 +56,13 @@
  *  |   field value length                 4 bytes
  *  |   field value                        l bytes
  *  --->
+ *
+ *  A serialized dynamic message may be preceded by its schema fingerprint
+ *  (see dynmessage_fingerprint):
+ *
+ *  dynamic message start (fingerprint)    4 bytes
+ *  schema fingerprint                     8 bytes
+ *  serialized dynamic message             (as above)
  */
 
 /* sizes to use for serialized field values (fixed for now) */
@@ -104,6 +117,142 @@ calc_dynmessage_serialized_len(dynamicmessage *message) {
     return result;
 }
 
+/**
+ * Function to add a sequence of bytes to a schema fingerprint.
+ *
+ * @param fingerprint schema fingerprint so far.
+ * @param bytes the sequence of bytes.
+ * @param len length of the sequence of bytes.
+ *
+ * @return updated schema fingerprint.
+ */
+static unsigned long long
+fingerprint_bytes(unsigned long long fingerprint, const unsigned char *bytes, size_t len) {
+    size_t i;
+    for (i = 0; i < len; i++) {
+        fingerprint ^= bytes[i];
+        fingerprint *= FINGERPRINT_PRIME;
+    }
+    return fingerprint;
+}
+
+/**
+ * Function to add a name (length and characters, as on the wire) to a
+ * schema fingerprint.
+ *
+ * @param fingerprint schema fingerprint so far.
+ * @param name the name.
+ * @param len length of the name.
+ *
+ * @return updated schema fingerprint.
+ */
+static unsigned long long
+fingerprint_name(unsigned long long fingerprint, const char *name, size_t len) {
+    unsigned char buffer4[4];
+    serialize_int32(buffer4, (long)len);
+    fingerprint = fingerprint_bytes(fingerprint, buffer4, BYTES_4);
+    return fingerprint_bytes(fingerprint, (const unsigned char *)name, len);
+}
+
+/**
+ * Function to start the schema fingerprint of a message.
+ *
+ * @param name name of the message.
+ * @param len length of the name of the message.
+ *
+ * @return schema fingerprint of the message without fields (never zero).
+ */
+extern unsigned long long
+dynmessage_fingerprint_start(const char *name, size_t len) {
+    unsigned long long fingerprint = fingerprint_name(FINGERPRINT_OFFSET_BASIS, name, len);
+    return fingerprint != 0 ? fingerprint : 1;
+}
+
+/**
+ * Function to add a field to the schema fingerprint of a message.
+ *
+ * @param fingerprint schema fingerprint of the message fields so far.
+ * @param name name of the field.
+ * @param len length of the name of the field.
+ * @param type type of the field.
+ *
+ * @return schema fingerprint including the field (never zero).
+ */
+extern unsigned long long
+dynmessage_fingerprint_field(
+    unsigned long long fingerprint,
+    const char *name,
+    size_t len,
+    dyn_field_type type) {
+    unsigned char buffer4[4];
+    fingerprint = fingerprint_name(fingerprint, name, len);
+    serialize_int32(buffer4, (long)type);
+    fingerprint = fingerprint_bytes(fingerprint, buffer4, BYTES_4);
+    return fingerprint != 0 ? fingerprint : 1;
+}
+
+/**
+ * Function to calculate the schema fingerprint of a dynamic message: a
+ * 64 bit hash of its name and of the ordered list of its field names and
+ * types. The fingerprint is kept in the message until a field is added.
+ *
+ * @param message reference to the dynamic message object.
+ *
+ * @return schema fingerprint of the dynamic message (never zero).
+ */
+extern unsigned long long
+dynmessage_fingerprint(dynamicmessage *message) {
+    if (message->fingerprint == 0) {
+        int i;
+        unsigned long long fingerprint = dynmessage_fingerprint_start(message->name, strlen(message->name));
+        dyn_field_list * field_list = dynmessage_get_fields(message);
+        for (i=0; i<field_list->list_length;i++) {
+            dyn_field *field = field_list->list[i];
+            fingerprint = dynmessage_fingerprint_field(fingerprint, field->name, strlen(field->name), field->type);
+            free(field); /* done with this field */
+        }
+        if (field_list->list_length > 0) {
+            free(field_list->list); /* done with the field list */
+        }
+        free(field_list); /* done with the whole list */
+        message->fingerprint = fingerprint;
+    }
+    return message->fingerprint;
+}
+
+/**
+ * Function to get the schema fingerprint preceding a serialized dynamic
+ * message, if any.
+ *
+ * @param data the sequence of bytes representing a serialized dynamic message instance.
+ * @param data_len length in bytes of the data byte sequence.
+ *
+ * @return schema fingerprint, zero if the serialized dynamic message is not
+ *         preceded by one.
+ */
+extern unsigned long long
+dynmessage_get_fingerprint(const unsigned char *data, size_t data_len) {
+    unsigned long long fingerprint = 0;
+    if (data != NULL && data_len >= DYN_MSG_FINGERPRINT_LEN
+        && deserialize_uint32((unsigned char *)data) == DYN_MSG_START_FINGERPRINT) {
+        fingerprint = deserialize_uint64((unsigned char *)data + BYTES_4);
+    }
+    return fingerprint;
+}
+
+/**
+ * Function to write the schema fingerprint preceding a serialized dynamic
+ * message.
+ *
+ * @param data buffer of DYN_MSG_FINGERPRINT_LEN bytes(not NULL).
+ * @param fingerprint schema fingerprint of the message.
+ */
+extern void
+dynmessage_put_fingerprint(unsigned char *data, unsigned long long fingerprint) {
+    serialize_int32(data, DYN_MSG_START_FINGERPRINT);
+    serialize_int64(data + BYTES_4, fingerprint);
+}
+
 /**
  * Function to verify that a sequence of bytes start with a serialized dynamic message instance.
  *
@@ -147,7 +296,8 @@ get_encoded_dynmessage_length(unsigned char *data, int data_len) {
 }
 
 /**
- * Function to verify that a sequence of bytes contain a full serialized dynamic message instance.
+ * Function to verify that a sequence of bytes contain a full serialized dynamic message
+ * instance, not preceded by a schema fingerprint.
  *
  * @param data the sequence of bytes representing a full serialized dynamic message instance.
  * @param data_len length in bytes of the data byte sequence.
@@ -155,18 +305,37 @@ get_encoded_dynmessage_length(unsigned char *data, int data_len) {
  * @return Non-zero if the sequence of bytes contain a full serialized dynamic message
  *         instance, zero otherwise.
  */
-extern int
-verify_full_dynmessage(unsigned char *data, int data_len) {
+static int
+verify_full_plain_dynmessage(unsigned char *data, int data_len) {
     int verified = 0;
     /* verify that the 'Dynamic Message Start' identifier is present. */
     if (verify_dynmessage_start(data, data_len)) {
         /* verify that all dynamic message data bytes are present. */
         int dynmessage_length = get_encoded_dynmessage_length(data, data_len);
-        verified = dynmessage_length <= data_len;
+        verified = dynmessage_length >= BYTES_8 && dynmessage_length <= data_len;
     }
     return verified;
 }
 
+/**
+ * Function to verify that a sequence of bytes contain a full serialized dynamic message instance.
+ *
+ * @param data the sequence of bytes representing a full serialized dynamic message instance.
+ * @param data_len length in bytes of the data byte sequence.
+ *
+ * @return Non-zero if the sequence of bytes contain a full serialized dynamic message
+ *         instance, zero otherwise.
+ */
+extern int
+verify_full_dynmessage(unsigned char *data, int data_len) {
+    /* skip the schema fingerprint, if any */
+    if (dynmessage_get_fingerprint(data, data_len) != 0) {
+        data += DYN_MSG_FINGERPRINT_LEN;
+        data_len -= DYN_MSG_FINGERPRINT_LEN;
+    }
+    return verify_full_plain_dynmessage(data, data_len);
+}
+
 /**
  * Function to de-serialize the data of sequence of bytes into a
  * dynamic message structure (binary version).
@@ -178,12 +347,38 @@ verify_full_dynmessage(unsigned char *data, int data_len) {
  */
 extern void *
 dynmessage_deserialize_bin(unsigned char *data, int data_len) {
+    return dynmessage_deserialize_bin_with_allocator(data, data_len, NULL);
+}
+
+/**
+ * Function to de-serialize the data of sequence of bytes into a
+ * dynamic message structure (binary version), allocating all message
+ * contents through the provided allocator.
+ *
+ * @param data the sequence of bytes representing the data.
+ * @param data_len length in bytes of the byte sequence.
+ * @param allocator allocator to use (NULL for the global allocator).
+ *
+ * @return reference to the de-serialized dynamic message structure.
+ */
+extern void *
+dynmessage_deserialize_bin_with_allocator(
+    unsigned char *data,
+    int data_len,
+    const cerializer_allocator *allocator) {
     size_t start_idx = 0;
     dynamicmessage *dyn_message = NULL;
-    if (verify_full_dynmessage(data, data_len)) {
+    /* skip the schema fingerprint, if any (it is calculated out of the fields instead) */
+    if (dynmessage_get_fingerprint(data, data_len) != 0) {
+        data += DYN_MSG_FINGERPRINT_LEN;
+        data_len -= DYN_MSG_FINGERPRINT_LEN;
+    }
+    /* a single fingerprint only: the message itself must follow */
+    if (verify_full_plain_dynmessage(data, data_len)) {
         int i, len, field_count;
         unsigned char buffer4[4];
-        unsigned char *message_name = NULL;
+        const char *message_name = NULL;
+        unsigned long long fingerprint;
         /* skip 'Dynamic Message Start' and dynamic message length bytes */
         start_idx = BYTES_8;
         /* dynamic message name length (4 bytes) */
@@ -191,13 +386,11 @@ dynmessage_deserialize_bin(unsigned char *data, int data_len) {
         len = (int)deserialize_int32(buffer4);
         start_idx = start_idx + BYTES_4;
         /* dynamic message name (m bytes) */
-        message_name =
-            (unsigned char *)SAFE_MALLOC((len +1)*sizeof(unsigned char));/* +1 for \0 */
-        strslice(message_name, data, start_idx, len);
-        message_name[len] = '\0';
+        message_name = cerializer_intern_len((const char *)data + start_idx, len);
+        fingerprint = dynmessage_fingerprint_start(message_name, len);
         dyn_message = dynmessage_create();
-        dynmessage_init(dyn_message, (char *)message_name);
-        SAFE_FREE(message_name);
+        /* the message takes over the reference to its name */
+        dynmessage_init_with_interned_name(dyn_message, message_name, allocator);
         start_idx = start_idx + len;
         /* dynamic message number of fields (n) (4 bytes) */
         strslice(buffer4, data, start_idx, BYTES_4);
@@ -206,12 +399,12 @@ dynmessage_deserialize_bin(unsigned char *data, int data_len) {
         /* de-serialize all dynamic fields */
         if (field_count > 0) {
           for (i = 0; i<field_count; i++) {
-              unsigned char *field_name = NULL;
+              const char *field_name = NULL;
+              int field_name_taken;
               dyn_field_type field_type;
               unsigned char *field_value_buffer = NULL;
               char char_value;
               unsigned char uchar_value;
-              short short_value;
               int int_value;
               long long_value;
               long long long_long_value;
@@ -228,19 +421,18 @@ dynmessage_deserialize_bin(unsigned char *data, int data_len) {
               len = (int)deserialize_int32(buffer4);
               start_idx = start_idx + BYTES_4;
               /* field name (k bytes) */
-              field_name = 
-                  (unsigned char *)SAFE_MALLOC((len +1)*sizeof(unsigned char));/* +1 for \0 */
-              strslice(field_name, data, start_idx, len);
-              field_name[len] = '\0';
+              field_name = cerializer_intern_len((const char *)data + start_idx, len);
               start_idx = start_idx + len;
               /* field type (4 bytes) */
               strslice(buffer4, data, start_idx, BYTES_4);
               field_type = (int)deserialize_int32(buffer4);
               start_idx = start_idx + BYTES_4;
+              fingerprint = dynmessage_fingerprint_field(fingerprint, field_name, strlen(field_name), field_type);
               /* field value length (4 bytes) */
               strslice(buffer4, data, start_idx, BYTES_4);
               len = (int)deserialize_int32(buffer4);
-              dynmessage_put_field(dyn_message, (char*)field_name, field_type);
+              /* the message takes over the reference to the field name */
+              field_name_taken = dynmessage_put_interned_field(dyn_message, field_name, field_type);
               start_idx = start_idx + BYTES_4;
               /* field value (l bytes) */
               field_value_buffer =
@@ -260,8 +452,8 @@ dynmessage_deserialize_bin(unsigned char *data, int data_len) {
                   dynmessage_put_uint8_field_value(dyn_message, (char *)field_name, &uchar_value);
                   break;
               case INT16_TYPE: /* 2 bytes */
-                  short_value = deserialize_int16(field_value_buffer);
-                  dynmessage_put_int16_field_value(dyn_message, (char *)field_name, &short_value);
+                  int_value = deserialize_int16(field_value_buffer);
+                  dynmessage_put_int16_field_value(dyn_message, (char *)field_name, &int_value);
                   break;
               case UNSIGNED_INT16_TYPE: /* 2 bytes */
                   int_value = deserialize_uint16(field_value_buffer);
@@ -303,127 +495,211 @@ dynmessage_deserialize_bin(unsigned char *data, int data_len) {
                   break;
               }
               start_idx = start_idx + len;
-              SAFE_FREE(field_name); /* done with this variable */
+              if (!field_name_taken) {
+                  cerializer_intern_release(field_name); /* done with this variable */
+              }
               SAFE_FREE(field_value_buffer); /* done with this variable */
           }
+          /* keep the schema fingerprint unless fields were dropped */
+          if (dyn_message->field_count == field_count) {
+              dyn_message->fingerprint = fingerprint;
+          }
         } else {
-          log_error_format(
-            "dynamicmessage_deserialize_bin: empty message %s\n", message_name);
+          CLOG_ERROR(
+            "dynamicmessage_deserialize_bin: empty message %s\n", dyn_message->name);
         }
     }
     return (void *)dyn_message;
 }
 
 /**
- * Function to serialize a dynamic message object into a sequence of bytes
+ * Function to write a serialized dynamic message object into a buffer
  * (binary version).
  *
- * @param object the dynamic message to serialize.
- * @param serdi serialized_data_info structure to store the
- *              serialized dynamic message object.
+ * @param message the dynamic message to serialize.
+ * @param data buffer of message_length bytes(not NULL).
+ * @param message_length length of the serialized dynamic message
+ *        (see calc_dynmessage_serialized_len).
  */
-extern void
-dynmessage_serialize_bin(void *object, serialized_data_info *serdi) {
+static void
+write_dynmessage(dynamicmessage *message, unsigned char *data, int message_length) {
     int i, len;
-    unsigned char * data;
-    dynamicmessage *message = (dynamicmessage *)object;
     dyn_field_list * field_list;
-    int message_length = calc_dynmessage_serialized_len(message);
-
-    if (message_length > DYN_MSG_MIN_LEN) {
-      serdi->ser_data_len = message_length;
-      serdi->ser_data = (unsigned char *)SAFE_MALLOC(message_length * sizeof(unsigned char));
-      /* use a local variable instead of modifying the actual one */
-      data = serdi->ser_data;
-      /* 'Dynamic Message Start' (4 bytes) */
-      serialize_int32(data, DYN_MSG_START);
-      data += BYTES_4;
-      /* dynamic message length (total) (4 bytes) */
-      serialize_int32(data, message_length);
+    /* 'Dynamic Message Start' (4 bytes) */
+    serialize_int32(data, DYN_MSG_START);
+    data += BYTES_4;
+    /* dynamic message length (total) (4 bytes) */
+    serialize_int32(data, message_length);
+    data += BYTES_4;
+    /* dynamic message name length (4 bytes) */
+    len = strlen(message->name);
+    serialize_int32(data, len);
+    data += BYTES_4;
+    /* dynamic message name (m bytes) */
+    memcpy(data, message->name, len);
+    data += len;
+    /* dynamic message number of fields (n) (4 bytes) */
+    serialize_int32(data, message->field_count);
+    data += BYTES_4;
+    /* get a list of all dynamic message fields */
+    field_list = dynmessage_get_fields(message);
+    /* serialize all dynamic fields */
+    for (i=0; i<field_list->list_length;i++) {
+      dyn_field *field = field_list->list[i]; /* save field info */
+      /* determine field size */
+      int value_size = DYN_FIELD_TYPE_SER_SIZE[field->type];
+      if (field->type == STRING_TYPE) {
+          value_size = strlen(field->value->string_value);
+      }
+      /* field length (total) (4 bytes) */
+      len = DYN_FIELD_FIXED_LEN + strlen(field->name) + value_size;
+      serialize_int32(data, len);
       data += BYTES_4;
-      /* dynamic message name length (4 bytes) */
-      len = strlen(message->name);
+      /* field name length (4 bytes) */
+      len = strlen(field->name);
       serialize_int32(data, len);
       data += BYTES_4;
-      /* dynamic message name (m bytes) */
-      memcpy(data, message->name, len);
+      /* field name (k bytes) */
+      memcpy(data, field->name, len);
       data += len;
-      /* dynamic message number of fields (n) (4 bytes) */
-      serialize_int32(data, message->field_count);
+      /* field type (4 bytes) */
+      serialize_int32(data, field->type);
       data += BYTES_4;
-      /* get a list of all dynamic message fields */
-      field_list = dynmessage_get_fields(message);
-      /* serialize all dynamic fields */
-      for (i=0; i<field_list->list_length;i++) {
-        dyn_field *field = field_list->list[i]; /* save field info */
-        /* determine field size */
-        int value_size = DYN_FIELD_TYPE_SER_SIZE[field->type];
-        if (field->type == STRING_TYPE) {
-            value_size = strlen(field->value->string_value);
-        }
-        /* field length (total) (4 bytes) */
-        len = DYN_FIELD_FIXED_LEN + strlen(field->name) + value_size;
-        serialize_int32(data, len);
-        data += BYTES_4;
-        /* field name length (4 bytes) */
-        len = strlen(field->name);
-        serialize_int32(data, len);
-        data += BYTES_4;
-        /* field name (k bytes) */
-        memcpy(data, field->name, len);
-        data += len;
-        /* field type (4 bytes) */
-        serialize_int32(data, field->type);
-        data += BYTES_4;
-        /* field value length (4 bytes) */
-        serialize_int32(data, value_size);
-        data += BYTES_4;
-        /* field value (l bytes) */
-        switch(field->type) {
-        case ENUMERATION_TYPE: /* 4 bytes */
-            serialize_int32(data, (field->value->enum_value));
-            break;
-        case INT8_TYPE: /* 1 byte */
-        	*data = (unsigned char)field->value->int8_value;
-            break;
-        case UNSIGNED_INT8_TYPE: /* 1 byte */
-        	*data = field->value->uint8_value;
-            break;
-        case INT16_TYPE: /* 2 bytes */
-            serialize_int16(data, (field->value->int16_value));
-            break;
-        case UNSIGNED_INT16_TYPE: /* 2 bytes */
-            serialize_int16(data, (field->value->uint16_value));
-            break;
-        case INT32_TYPE: /* 4 bytes */
-            serialize_int32(data, (field->value->int32_value));
-            break;
-        case UNSIGNED_INT32_TYPE: /* 4 bytes */
-            serialize_int32(data, (unsigned long int)(field->value->uint32_value));
-            break;
-        case INT64_TYPE: /* 8 bytes */
-            serialize_int64(data, (long long int)(field->value->int64_value));
-            break;
-        case UNSIGNED_INT64_TYPE: /* 8 bytes */
-            serialize_int64(data, (unsigned long long int)(field->value->uint64_value));
-            break;
-        case FLOAT32_TYPE: /* 4 bytes */
-            serialize_float32(data, field->value->float32_value);
-            break;
-        case FLOAT64_TYPE: /* 8 bytes */
-            serialize_float64(data, field->value->float64_value);
-            break;
-        case STRING_TYPE: /* n bytes */
-            memcpy(data, field->value->string_value, value_size);
-            break;
-        case NO_TYPE: /* 0 bytes */
-            break;
-        }
-        data += value_size;
-        free(field); /* done with this field */
+      /* field value length (4 bytes) */
+      serialize_int32(data, value_size);
+      data += BYTES_4;
+      /* field value (l bytes) */
+      switch(field->type) {
+      case ENUMERATION_TYPE: /* 4 bytes */
+          serialize_int32(data, (field->value->enum_value));
+          break;
+      case INT8_TYPE: /* 1 byte */
+      	*data = (unsigned char)field->value->int8_value;
+          break;
+      case UNSIGNED_INT8_TYPE: /* 1 byte */
+      	*data = field->value->uint8_value;
+          break;
+      case INT16_TYPE: /* 2 bytes */
+          serialize_int16(data, (field->value->int16_value));
+          break;
+      case UNSIGNED_INT16_TYPE: /* 2 bytes */
+          serialize_int16(data, (field->value->uint16_value));
+          break;
+      case INT32_TYPE: /* 4 bytes */
+          serialize_int32(data, (field->value->int32_value));
+          break;
+      case UNSIGNED_INT32_TYPE: /* 4 bytes */
+          serialize_int32(data, (unsigned long int)(field->value->uint32_value));
+          break;
+      case INT64_TYPE: /* 8 bytes */
+          serialize_int64(data, (long long int)(field->value->int64_value));
+          break;
+      case UNSIGNED_INT64_TYPE: /* 8 bytes */
+          serialize_int64(data, (unsigned long long int)(field->value->uint64_value));
+          break;
+      case FLOAT32_TYPE: /* 4 bytes */
+          serialize_float32(data, field->value->float32_value);
+          break;
+      case FLOAT64_TYPE: /* 8 bytes */
+          serialize_float64(data, field->value->float64_value);
+          break;
+      case STRING_TYPE: /* n bytes */
+          memcpy(data, field->value->string_value, value_size);
+          break;
+      case NO_TYPE: /* 0 bytes */
+          break;
       }
-      free(field_list->list); /* done with the field list */
+      data += value_size;
+      free(field); /* done with this field */
+    }
+    free(field_list->list); /* done with the field list */
+
+    free(field_list); /* done with the whole list */
+}
+
+/**
+ * Function to serialize a dynamic message object into a sequence of bytes
+ * (binary version), optionally preceded by its schema fingerprint.
+ *
+ * @param message the dynamic message to serialize.
+ * @param serdi serialized_data_info structure to store the
+ *              serialized dynamic message object.
+ * @param with_fingerprint non-zero to precede the message by its schema fingerprint.
+ */
+static void
+serialize_dynmessage(dynamicmessage *message, serialized_data_info *serdi, int with_fingerprint) {
+    int message_length = calc_dynmessage_serialized_len(message);
 
-      free(field_list); /* done with the whole list */
+    if (message_length > DYN_MSG_MIN_LEN) {
+      int prefix_length = with_fingerprint ? DYN_MSG_FINGERPRINT_LEN : 0;
+      serdi->ser_data_len = prefix_length + message_length;
+      serdi->ser_data = (unsigned char *)SAFE_MALLOC(serdi->ser_data_len * sizeof(unsigned char));
+      if (with_fingerprint) {
+        /* schema fingerprint (12 bytes) */
+        dynmessage_put_fingerprint(serdi->ser_data, dynmessage_fingerprint(message));
+      }
+      write_dynmessage(message, serdi->ser_data + prefix_length, message_length);
+    }
+}
+
+/**
+ * Function to serialize a dynamic message object into a sequence of bytes
+ * (binary version).
+ *
+ * @param object the dynamic message to serialize.
+ * @param serdi serialized_data_info structure to store the
+ *              serialized dynamic message object.
+ */
+extern void
+dynmessage_serialize_bin(void *object, serialized_data_info *serdi) {
+    serialize_dynmessage((dynamicmessage *)object, serdi, 0);
+}
+
+/**
+ * Function to serialize a dynamic message object into a sequence of bytes
+ * (binary version), preceded by its schema fingerprint.
+ *
+ * @param object the dynamic message to serialize.
+ * @param serdi serialized_data_info structure to store the
+ *              serialized dynamic message object.
+ */
+extern void
+dynmessage_serialize_bin_with_fingerprint(void *object, serialized_data_info *serdi) {
+    serialize_dynmessage((dynamicmessage *)object, serdi, 1);
+}
+
+/**
+ * Function to calculate the length, in bytes, of a serialized dynamic message.
+ *
+ * @param message reference to the dynamic message object.
+ *
+ * @return length of the serialized dynamic message object, zero if the
+ *         message has no fields (and cannot be serialized).
+ */
+extern size_t
+dynmessage_serialized_len(dynamicmessage *message) {
+    int message_length = calc_dynmessage_serialized_len(message);
+    return message_length > DYN_MSG_MIN_LEN ? (size_t)message_length : 0;
+}
+
+/**
+ * Function to serialize a dynamic message object into a buffer provided
+ * by the caller (binary version).
+ *
+ * @param object the dynamic message to serialize.
+ * @param data buffer to store the serialized dynamic message object(not NULL).
+ * @param data_len length in bytes of the buffer.
+ *
+ * @return length of the serialized dynamic message object, zero if the
+ *         buffer is too small or the message has no fields.
+ */
+extern size_t
+dynmessage_serialize_bin_into(void *object, unsigned char *data, size_t data_len) {
+    dynamicmessage *message = (dynamicmessage *)object;
+    size_t message_length = dynmessage_serialized_len(message);
+    if (message_length == 0 || message_length > data_len) {
+        return 0;
     }
+    write_dynmessage(message, data, (int)message_length);
+    return message_length;
 }
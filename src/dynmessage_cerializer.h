@@ -25,9 +25,14 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
+
 #include <cerializer.h>
 #include <dynmessage.h>
 
+/* length of the schema fingerprint preceding a serialized dynamic message */
+#define DYN_MSG_FINGERPRINT_LEN 12
+
 /**
  * Function to de-serialize the data of sequence of bytes into a
  * dynamic message structure (binary version).
@@ -40,6 +45,23 @@ extern "C" {
 extern void *
 dynmessage_deserialize_bin(unsigned char *data, int data_len);
 
+/**
+ * Function to de-serialize the data of sequence of bytes into a
+ * dynamic message structure (binary version), allocating all message
+ * contents through the provided allocator.
+ *
+ * @param data the sequence of bytes representing the data.
+ * @param data_len length in bytes of the byte sequence.
+ * @param allocator allocator to use (NULL for the global allocator).
+ *
+ * @return reference to the de-serialized dynamic message structure.
+ */
+extern void *
+dynmessage_deserialize_bin_with_allocator(
+    unsigned char *data,
+    int data_len,
+    const cerializer_allocator *allocator);
+
 /**
  * Function to serialize a dynamic message object into a sequence of bytes
  * (binary version).
@@ -51,6 +73,107 @@ dynmessage_deserialize_bin(unsigned char *data, int data_len);
 extern void
 dynmessage_serialize_bin(void *object, serialized_data_info *serdi);
 
+/**
+ * Function to serialize a dynamic message object into a sequence of bytes
+ * (binary version), preceded by its schema fingerprint. Readers comparing
+ * the fingerprint against an expected one check the message type and the
+ * layout of its fields at once.
+ *
+ * @param object the dynamic message to serialize.
+ * @param serdi serialized_data_info structure to store the
+ *              serialized dynamic message object.
+ */
+extern void
+dynmessage_serialize_bin_with_fingerprint(void *object, serialized_data_info *serdi);
+
+/**
+ * Function to calculate the length, in bytes, of a serialized dynamic message.
+ *
+ * @param message reference to the dynamic message object.
+ *
+ * @return length of the serialized dynamic message object, zero if the
+ *         message has no fields (and cannot be serialized).
+ */
+extern size_t
+dynmessage_serialized_len(dynamicmessage *message);
+
+/**
+ * Function to serialize a dynamic message object into a buffer provided
+ * by the caller (binary version).
+ *
+ * @param object the dynamic message to serialize.
+ * @param data buffer to store the serialized dynamic message object(not NULL).
+ * @param data_len length in bytes of the buffer.
+ *
+ * @return length of the serialized dynamic message object, zero if the
+ *         buffer is too small or the message has no fields.
+ */
+extern size_t
+dynmessage_serialize_bin_into(void *object, unsigned char *data, size_t data_len);
+
+/**
+ * Function to start the schema fingerprint of a message.
+ *
+ * @param name name of the message.
+ * @param len length of the name of the message.
+ *
+ * @return schema fingerprint of the message without fields (never zero).
+ */
+extern unsigned long long
+dynmessage_fingerprint_start(const char *name, size_t len);
+
+/**
+ * Function to add a field to the schema fingerprint of a message.
+ *
+ * @param fingerprint schema fingerprint of the message fields so far.
+ * @param name name of the field.
+ * @param len length of the name of the field.
+ * @param type type of the field.
+ *
+ * @return schema fingerprint including the field (never zero).
+ */
+extern unsigned long long
+dynmessage_fingerprint_field(
+    unsigned long long fingerprint,
+    const char *name,
+    size_t len,
+    dyn_field_type type);
+
+/**
+ * Function to calculate the schema fingerprint of a dynamic message: a
+ * 64 bit hash of its name and of the ordered list of its field names and
+ * types. The fingerprint is kept in the message until a field is added.
+ *
+ * @param message reference to the dynamic message object.
+ *
+ * @return schema fingerprint of the dynamic message (never zero).
+ */
+extern unsigned long long
+dynmessage_fingerprint(dynamicmessage *message);
+
+/**
+ * Function to get the schema fingerprint preceding a serialized dynamic
+ * message, if any.
+ *
+ * @param data the sequence of bytes representing a serialized dynamic message instance.
+ * @param data_len length in bytes of the data byte sequence.
+ *
+ * @return schema fingerprint, zero if the serialized dynamic message is not
+ *         preceded by one.
+ */
+extern unsigned long long
+dynmessage_get_fingerprint(const unsigned char *data, size_t data_len);
+
+/**
+ * Function to write the schema fingerprint preceding a serialized dynamic
+ * message.
+ *
+ * @param data buffer of DYN_MSG_FINGERPRINT_LEN bytes(not NULL).
+ * @param fingerprint schema fingerprint of the message.
+ */
+extern void
+dynmessage_put_fingerprint(unsigned char *data, unsigned long long fingerprint);
+
 #ifdef  __cplusplus
 }
 #endif
@@ -23,6 +23,7 @@
 #include <string.h>
 
 #include "stdlib_util.h"
+#include "pvec.h"
 #include "slinkedlist.h"
 
 #include "hashmap.h"
@@ -88,6 +89,23 @@ default_hash_func(const void *key) {
     return a;
 }
 
+/**
+ * Free a hash table bucket, including all entries and nodes.
+ *
+ * @param map hash map structure.
+ * @param list the bucket single linked list.
+ */
+static void
+hashmap_free_bucket(hashmap *map, slinkedlist *list) {
+    slinkedlist_node_t *it = list->head;
+    while (it) {
+        SAFE_SLAB_FREE_WITH(map->allocator, it->data, sizeof(hashmap_entry));
+        it = it->next;
+    }
+    slinkedlist_free(list, NULL);
+    SAFE_SLAB_FREE_WITH(map->allocator, list, sizeof(slinkedlist));
+}
+
 /**
  * Test whether the given hash map requires to be re-hashed,
  * in order to add the provided key.
@@ -136,11 +154,12 @@ hashmap_rehash(hashmap *map, size_t capacity) {
     /* save all entries in hash map */
     slinkedlist * entries = hashmap_entries(map);
     /* allocate memory for new hash table */
-    slinkedlist **table = (slinkedlist **)SAFE_MALLOC(sizeof(slinkedlist *) * capacity);
+    slinkedlist **table =
+        (slinkedlist **)SAFE_MALLOC_WITH(map->allocator, sizeof(slinkedlist *) * capacity);
     memset(table, 0, sizeof(slinkedlist *) * capacity);
     /* clear hash map */
     hashmap_clear(map);
-    SAFE_FREE(map->table);
+    SAFE_FREE_WITH(map->allocator, map->table);
     /* set new table */
     map->table = table;
     /* set new capacity */
@@ -171,8 +190,29 @@ hashmap_init(
     size_t capacity,
     hashmap_key_equal key_equal,
     hashmap_hash_func hash_func) {
+    hashmap_init_with_allocator(map, capacity, key_equal, hash_func, NULL);
+}
+
+/**
+ * Initialize the map, allocating all map internals through the
+ * provided allocator.
+ *
+ * @param map hash map structure.
+ * @param capacity initial size of the hash map.
+ * @param key_equal function to compare keys.
+ * @param hash_func hash function.
+ * @param allocator allocator to use (NULL for the global allocator).
+ */
+extern void
+hashmap_init_with_allocator(
+    hashmap *map,
+    size_t capacity,
+    hashmap_key_equal key_equal,
+    hashmap_hash_func hash_func,
+    const cerializer_allocator *allocator) {
 
     if (map != NULL) {
+        map->allocator = allocator;
         map->capacity = capacity;
         /* check user provided hash map capacity */
         if ((int)map->capacity <= 0) {
@@ -180,7 +220,8 @@ hashmap_init(
         }
         map->size = 0;
 
-        map->table = (slinkedlist **)SAFE_MALLOC(sizeof(slinkedlist *) * map->capacity);
+        map->table =
+            (slinkedlist **)SAFE_MALLOC_WITH(map->allocator, sizeof(slinkedlist *) * map->capacity);
         memset(map->table, 0, sizeof(slinkedlist *) * map->capacity);
 
         if (key_equal) {
@@ -215,22 +256,23 @@ hashmap_init_default(
 /**
  * Free the entire map including the linked lists.
  * Note that data of each entry in the linked list
- * remains intact(not free'd);
+ * remains intact(not free'd); The map structure itself
+ * is released through the map allocator.
  *
  * @param map hash map structure.
  */
 extern void
 hashmap_free(hashmap *map) {
     if (map != NULL) {
+        const cerializer_allocator *allocator = map->allocator;
         size_t i;
         for (i = 0; i < map->capacity; i++) {
             if (map->table[i]) {
-                slinkedlist_free(map->table[i], (slinkedlist_data_dealloc) safe_free);
-                SAFE_FREE(map->table[i]);
+                hashmap_free_bucket(map, map->table[i]);
             }
         }
-        SAFE_FREE(map->table);
-        SAFE_FREE(map);
+        SAFE_FREE_WITH(allocator, map->table);
+        SAFE_FREE_WITH(allocator, map);
     }
 }
 
@@ -269,8 +311,7 @@ hashmap_clear(hashmap *map) {
     for (i = 0; i < map->capacity; i++) {
         slinkedlist *list = map->table[i];
         if (list) {
-            slinkedlist_free(list, (slinkedlist_data_dealloc) safe_free);
-            SAFE_FREE(list);
+            hashmap_free_bucket(map, list);
             map->table[i] = NULL;
         }
     }
@@ -373,6 +414,31 @@ hashmap_keys(hashmap *map){
     return list;
 }
 
+/**
+ * Append all keys in the provided map to the provided vector.
+ * Prefer this over hashmap_keys when keys are only to be iterated.
+ *
+ * @param map hash map structure.
+ * @param keys vector structure to append keys to(not NULL).
+ */
+extern void
+hashmap_keys_to_pvec(hashmap *map, pvec *keys) {
+    if (!hashmap_empty(map) && keys != NULL) {
+        size_t i;
+        pvec_reserve(keys, keys->size + map->size);
+        for (i=0; i<map->capacity; i++) {
+            if (map->table[i]) {
+                slinkedlist_node_t * it = map->table[i]->head;
+                while(it) {
+                    hashmap_entry *entry = (hashmap_entry *)it->data;
+                    pvec_append(keys, entry->key);
+                    it = it->next;
+                }
+            }
+        }
+    }
+}
+
 /**
  * Return a single linked list containing all values in the provided map.
  *
@@ -420,11 +486,12 @@ hashmap_put(hashmap *map, void *key, void *value) {
         if (list == NULL) {
             hashmap_entry *entry = NULL;
             /* create a new linked list */
-            list = (slinkedlist *)SAFE_MALLOC(sizeof(slinkedlist));
+            list = (slinkedlist *)SAFE_SLAB_ALLOC_WITH(map->allocator, sizeof(slinkedlist));
             slinkedlist_init(list);
+            list->allocator = map->allocator;
             map->table[offset] = list;
 
-            entry = (hashmap_entry *)SAFE_MALLOC(sizeof(hashmap_entry));
+            entry = (hashmap_entry *)SAFE_SLAB_ALLOC_WITH(map->allocator, sizeof(hashmap_entry));
             entry->key = key;
             entry->value = value;
             slinkedlist_prepend(list, entry);
@@ -449,7 +516,8 @@ hashmap_put(hashmap *map, void *key, void *value) {
                     hashmap_put(map, key, value);
                 } else {
                     /* add a new node in the linked list */
-                    hashmap_entry *entry = (hashmap_entry *)SAFE_MALLOC(sizeof(hashmap_entry));
+                    hashmap_entry *entry =
+                        (hashmap_entry *)SAFE_SLAB_ALLOC_WITH(map->allocator, sizeof(hashmap_entry));
                     entry->key = key;
                     entry->value = value;
                     slinkedlist_prepend(list, entry);
@@ -509,8 +577,8 @@ hashmap_remove(hashmap *map, void *key) {
         del_entry->key = del_entry_data->key;
         del_entry->value = del_entry_data->value;
 
-        SAFE_FREE(current_node->data);
-        SAFE_FREE(current_node);
+        SAFE_SLAB_FREE_WITH(map->allocator, current_node->data, sizeof(hashmap_entry));
+        SAFE_SLAB_FREE_WITH(list->allocator, current_node, sizeof(slinkedlist_node_t));
         /* decrement structure sizes */
         list->size--;
         map->size--;
@@ -27,6 +27,7 @@ extern "C" {
 
 #include <stdlib.h>
 
+#include "pvec.h"
 #include "slinkedlist.h"
 
 /**
@@ -63,6 +64,8 @@ typedef struct {
     hashmap_key_equal key_equal;
     /** Key hash function */
     hashmap_hash_func hash_func;
+    /** Allocator of the map internals (NULL for the global allocator) */
+    const cerializer_allocator *allocator;
 } hashmap;
 
 /**
@@ -90,6 +93,24 @@ hashmap_init(
     hashmap_key_equal key_equal,
     hashmap_hash_func hash_func);
 
+/**
+ * Initialize the map, allocating all map internals through the
+ * provided allocator.
+ *
+ * @param map hash map structure.
+ * @param capacity initial size of the hash map.
+ * @param key_equal function to compare keys.
+ * @param hash_func hash function.
+ * @param allocator allocator to use (NULL for the global allocator).
+ */
+extern void
+hashmap_init_with_allocator(
+    hashmap *map,
+    size_t capacity,
+    hashmap_key_equal key_equal,
+    hashmap_hash_func hash_func,
+    const cerializer_allocator *allocator);
+
 /**
  * Initialize the map with the default hash function.
  *
@@ -106,7 +127,8 @@ hashmap_init_default(
 /**
  * Free the entire map including the linked lists.
  * Note that data of each entry in the linked list
- * remains intact(not free'd);
+ * remains intact(not free'd); The map structure itself
+ * is released through the map allocator.
  *
  * @param map hash map structure.
  */
@@ -167,6 +189,16 @@ hashmap_entries(hashmap *map);
 extern slinkedlist *
 hashmap_keys(hashmap *map);
 
+/**
+ * Append all keys in the provided map to the provided vector.
+ * Prefer this over hashmap_keys when keys are only to be iterated.
+ *
+ * @param map hash map structure.
+ * @param keys vector structure to append keys to(not NULL).
+ */
+extern void
+hashmap_keys_to_pvec(hashmap *map, pvec *keys);
+
 /**
  * Return a single linked list containing all values in the provided map.
  *
@@ -0,0 +1,305 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Implementation of intrusive (single and double) linked lists.
+ */
+
+#include <stdlib.h>
+
+#include "ilinkedlist.h"
+
+/**
+ * Initialize an intrusive single linked list.
+ *
+ * @param list intrusive single linked list structure.
+ */
+extern void
+islinkedlist_init(islinkedlist *list) {
+    if (list != NULL) {
+        list->head = NULL;
+        list->tail = NULL;
+        list->size = 0;
+    }
+}
+
+/**
+ * Append a link to the intrusive single linked list.
+ *
+ * @param list intrusive single linked list structure.
+ * @param link link to append(not part of any list).
+ */
+extern void
+islinkedlist_append(islinkedlist *list, islinkedlist_link *link) {
+    islinkedlist_insert_after(list, list != NULL ? list->tail : NULL, link);
+}
+
+/**
+ * Prepend a link to the intrusive single linked list.
+ *
+ * @param list intrusive single linked list structure.
+ * @param link link to prepend(not part of any list).
+ */
+extern void
+islinkedlist_prepend(islinkedlist *list, islinkedlist_link *link) {
+    islinkedlist_insert_after(list, NULL, link);
+}
+
+/**
+ * Insert a link right after the provided predecessor link.
+ *
+ * @param list intrusive single linked list structure.
+ * @param prev predecessor link already in the list, NULL to prepend.
+ * @param link link to insert(not part of any list).
+ */
+extern void
+islinkedlist_insert_after(
+    islinkedlist *list,
+    islinkedlist_link *prev,
+    islinkedlist_link *link) {
+
+    if (list != NULL && link != NULL) {
+        if (prev == NULL) {
+            /* new link becomes the head */
+            link->next = list->head;
+            list->head = link;
+        } else {
+            link->next = prev->next;
+            prev->next = link;
+        }
+        /* re-adjust tail in case the link was added at the end */
+        if (link->next == NULL) {
+            list->tail = link;
+        }
+        list->size++;
+    }
+}
+
+/**
+ * Deletes the head link of the intrusive single linked list.
+ *
+ * @param list intrusive single linked list structure.
+ *
+ * @return the deleted head link(NULL if the list is empty).
+ */
+extern islinkedlist_link *
+islinkedlist_delete_head(islinkedlist *list) {
+    return islinkedlist_delete_after(list, NULL);
+}
+
+/**
+ * Deletes the link that follows the provided predecessor link,
+ * in constant time.
+ *
+ * @param list intrusive single linked list structure.
+ * @param prev predecessor link already in the list, NULL to delete the head.
+ *
+ * @return the deleted link(NULL if there is no link after prev).
+ */
+extern islinkedlist_link *
+islinkedlist_delete_after(islinkedlist *list, islinkedlist_link *prev) {
+    islinkedlist_link *link = NULL;
+    if (!islinkedlist_empty(list)) {
+        if (prev == NULL) {
+            link = list->head;
+            list->head = link->next;
+        } else {
+            link = prev->next;
+            if (link != NULL) {
+                /* bypass the deleted link */
+                prev->next = link->next;
+            }
+        }
+        if (link != NULL) {
+            /* re-adjust tail in case it's identical to the deleted link */
+            if (link == list->tail) {
+                list->tail = prev;
+            }
+            link->next = NULL;
+            list->size--;
+        }
+    }
+    return link;
+}
+
+/**
+ * Tests whether the provided intrusive single linked list is empty.
+ *
+ * @param list intrusive single linked list structure.
+ *
+ * @return Non-zero if the list is empty, zero otherwise.
+ */
+extern int
+islinkedlist_empty(islinkedlist *list) {
+    int result = 0;
+    if (list == NULL) {
+        result++;
+    } else {
+        if (list->size == 0) {
+            result++;
+        }
+    }
+    return result;
+}
+
+/**
+ * Initialize an intrusive double linked list.
+ *
+ * @param list intrusive double linked list structure.
+ */
+extern void
+idlinkedlist_init(idlinkedlist *list) {
+    if (list != NULL) {
+        list->head = NULL;
+        list->tail = NULL;
+        list->size = 0;
+    }
+}
+
+/**
+ * Append a link to the intrusive double linked list.
+ *
+ * @param list intrusive double linked list structure.
+ * @param link link to append(not part of any list).
+ */
+extern void
+idlinkedlist_append(idlinkedlist *list, idlinkedlist_link *link) {
+    idlinkedlist_insert_after(list, list != NULL ? list->tail : NULL, link);
+}
+
+/**
+ * Prepend a link to the intrusive double linked list.
+ *
+ * @param list intrusive double linked list structure.
+ * @param link link to prepend(not part of any list).
+ */
+extern void
+idlinkedlist_prepend(idlinkedlist *list, idlinkedlist_link *link) {
+    idlinkedlist_insert_after(list, NULL, link);
+}
+
+/**
+ * Insert a link right after the provided predecessor link.
+ *
+ * @param list intrusive double linked list structure.
+ * @param prev predecessor link already in the list, NULL to prepend.
+ * @param link link to insert(not part of any list).
+ */
+extern void
+idlinkedlist_insert_after(
+    idlinkedlist *list,
+    idlinkedlist_link *prev,
+    idlinkedlist_link *link) {
+
+    if (list != NULL && link != NULL) {
+        link->prev = prev;
+        if (prev == NULL) {
+            /* new link becomes the head */
+            link->next = list->head;
+            list->head = link;
+        } else {
+            link->next = prev->next;
+            prev->next = link;
+        }
+        if (link->next == NULL) {
+            list->tail = link;
+        } else {
+            link->next->prev = link;
+        }
+        list->size++;
+    }
+}
+
+/**
+ * Deletes the provided link from the intrusive double linked list,
+ * in constant time.
+ *
+ * @param list intrusive double linked list structure.
+ * @param link link to delete(must be part of the list).
+ */
+extern void
+idlinkedlist_delete(idlinkedlist *list, idlinkedlist_link *link) {
+    if (!idlinkedlist_empty(list) && link != NULL) {
+        if (link->prev == NULL) {
+            list->head = link->next;
+        } else {
+            link->prev->next = link->next;
+        }
+        if (link->next == NULL) {
+            list->tail = link->prev;
+        } else {
+            link->next->prev = link->prev;
+        }
+        link->next = NULL;
+        link->prev = NULL;
+        list->size--;
+    }
+}
+
+/**
+ * Deletes the head link of the intrusive double linked list.
+ *
+ * @param list intrusive double linked list structure.
+ *
+ * @return the deleted head link(NULL if the list is empty).
+ */
+extern idlinkedlist_link *
+idlinkedlist_delete_head(idlinkedlist *list) {
+    idlinkedlist_link *head = NULL;
+    if (!idlinkedlist_empty(list)) {
+        head = list->head;
+        idlinkedlist_delete(list, head);
+    }
+    return head;
+}
+
+/**
+ * Deletes the tail link of the intrusive double linked list,
+ * in constant time.
+ *
+ * @param list intrusive double linked list structure.
+ *
+ * @return the deleted tail link(NULL if the list is empty).
+ */
+extern idlinkedlist_link *
+idlinkedlist_delete_tail(idlinkedlist *list) {
+    idlinkedlist_link *tail = NULL;
+    if (!idlinkedlist_empty(list)) {
+        tail = list->tail;
+        idlinkedlist_delete(list, tail);
+    }
+    return tail;
+}
+
+/**
+ * Tests whether the provided intrusive double linked list is empty.
+ *
+ * @param list intrusive double linked list structure.
+ *
+ * @return Non-zero if the list is empty, zero otherwise.
+ */
+extern int
+idlinkedlist_empty(idlinkedlist *list) {
+    int result = 0;
+    if (list == NULL) {
+        result++;
+    } else {
+        if (list->size == 0) {
+            result++;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Implementation of intrusive (single and double) linked lists.
+ *
+ * The list links live inside the user structures, so adding an element
+ * to a list does not allocate any memory. The enclosing structure of a
+ * link is retrieved with the ilinkedlist_entry macro.
+ */
+
+#ifndef ILINKEDLIST_H_
+#define ILINKEDLIST_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * Get a reference to the structure which contains the provided link.
+ *
+ * @param link pointer to the link member.
+ * @param type type of the structure the link is embedded in.
+ * @param member name of the link member within the structure.
+ */
+#define ilinkedlist_entry(link, type, member) \
+    ((type *)((char *)(link) - offsetof(type, member)))
+
+/**
+ * Intrusive single linked list link (embed in user structures).
+ */
+typedef struct _islinkedlist_link_struct {
+    /* Pointer to the next link */
+    struct _islinkedlist_link_struct *next;
+} islinkedlist_link;
+
+/**
+ * Intrusive single linked list structure.
+ */
+typedef struct {
+    /* Pointer to leading link */
+    islinkedlist_link *head;
+    /* Size of the intrusive single linked list */
+    size_t size;
+    /* Pointer to last link */
+    islinkedlist_link *tail;
+} islinkedlist;
+
+/**
+ * Intrusive double linked list link (embed in user structures).
+ */
+typedef struct _idlinkedlist_link_struct {
+    /* Pointer to the next link */
+    struct _idlinkedlist_link_struct *next;
+    /* Pointer to the previous link */
+    struct _idlinkedlist_link_struct *prev;
+} idlinkedlist_link;
+
+/**
+ * Intrusive double linked list structure.
+ */
+typedef struct {
+    /* Pointer to leading link */
+    idlinkedlist_link *head;
+    /* Size of the intrusive double linked list */
+    size_t size;
+    /* Pointer to last link */
+    idlinkedlist_link *tail;
+} idlinkedlist;
+
+/**
+ * Initialize an intrusive single linked list.
+ *
+ * @param list intrusive single linked list structure.
+ */
+extern void
+islinkedlist_init(islinkedlist *list);
+
+/**
+ * Append a link to the intrusive single linked list.
+ *
+ * @param list intrusive single linked list structure.
+ * @param link link to append(not part of any list).
+ */
+extern void
+islinkedlist_append(islinkedlist *list, islinkedlist_link *link);
+
+/**
+ * Prepend a link to the intrusive single linked list.
+ *
+ * @param list intrusive single linked list structure.
+ * @param link link to prepend(not part of any list).
+ */
+extern void
+islinkedlist_prepend(islinkedlist *list, islinkedlist_link *link);
+
+/**
+ * Insert a link right after the provided predecessor link.
+ *
+ * @param list intrusive single linked list structure.
+ * @param prev predecessor link already in the list, NULL to prepend.
+ * @param link link to insert(not part of any list).
+ */
+extern void
+islinkedlist_insert_after(
+    islinkedlist *list,
+    islinkedlist_link *prev,
+    islinkedlist_link *link);
+
+/**
+ * Deletes the head link of the intrusive single linked list.
+ *
+ * @param list intrusive single linked list structure.
+ *
+ * @return the deleted head link(NULL if the list is empty).
+ */
+extern islinkedlist_link *
+islinkedlist_delete_head(islinkedlist *list);
+
+/**
+ * Deletes the link that follows the provided predecessor link,
+ * in constant time.
+ *
+ * @param list intrusive single linked list structure.
+ * @param prev predecessor link already in the list, NULL to delete the head.
+ *
+ * @return the deleted link(NULL if there is no link after prev).
+ */
+extern islinkedlist_link *
+islinkedlist_delete_after(islinkedlist *list, islinkedlist_link *prev);
+
+/**
+ * Tests whether the provided intrusive single linked list is empty.
+ *
+ * @param list intrusive single linked list structure.
+ *
+ * @return Non-zero if the list is empty, zero otherwise.
+ */
+extern int
+islinkedlist_empty(islinkedlist *list);
+
+/**
+ * Initialize an intrusive double linked list.
+ *
+ * @param list intrusive double linked list structure.
+ */
+extern void
+idlinkedlist_init(idlinkedlist *list);
+
+/**
+ * Append a link to the intrusive double linked list.
+ *
+ * @param list intrusive double linked list structure.
+ * @param link link to append(not part of any list).
+ */
+extern void
+idlinkedlist_append(idlinkedlist *list, idlinkedlist_link *link);
+
+/**
+ * Prepend a link to the intrusive double linked list.
+ *
+ * @param list intrusive double linked list structure.
+ * @param link link to prepend(not part of any list).
+ */
+extern void
+idlinkedlist_prepend(idlinkedlist *list, idlinkedlist_link *link);
+
+/**
+ * Insert a link right after the provided predecessor link.
+ *
+ * @param list intrusive double linked list structure.
+ * @param prev predecessor link already in the list, NULL to prepend.
+ * @param link link to insert(not part of any list).
+ */
+extern void
+idlinkedlist_insert_after(
+    idlinkedlist *list,
+    idlinkedlist_link *prev,
+    idlinkedlist_link *link);
+
+/**
+ * Deletes the provided link from the intrusive double linked list,
+ * in constant time.
+ *
+ * @param list intrusive double linked list structure.
+ * @param link link to delete(must be part of the list).
+ */
+extern void
+idlinkedlist_delete(idlinkedlist *list, idlinkedlist_link *link);
+
+/**
+ * Deletes the head link of the intrusive double linked list.
+ *
+ * @param list intrusive double linked list structure.
+ *
+ * @return the deleted head link(NULL if the list is empty).
+ */
+extern idlinkedlist_link *
+idlinkedlist_delete_head(idlinkedlist *list);
+
+/**
+ * Deletes the tail link of the intrusive double linked list,
+ * in constant time.
+ *
+ * @param list intrusive double linked list structure.
+ *
+ * @return the deleted tail link(NULL if the list is empty).
+ */
+extern idlinkedlist_link *
+idlinkedlist_delete_tail(idlinkedlist *list);
+
+/**
+ * Tests whether the provided intrusive double linked list is empty.
+ *
+ * @param list intrusive double linked list structure.
+ *
+ * @return Non-zero if the list is empty, zero otherwise.
+ */
+extern int
+idlinkedlist_empty(idlinkedlist *list);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* ILINKEDLIST_H_ */
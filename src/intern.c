@@ -0,0 +1,269 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Process-wide, thread-safe string interning table.
+ *
+ * The table is split in shards, each one a chained hash table guarded by
+ * its own mutex, so that threads interning different strings rarely
+ * contend. Entries keep their hash value and reference count in a header
+ * placed right before the string characters, which lets a canonical
+ * pointer be released without looking the string up again.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "stdlib_util.h"
+#include "strkernel.h"
+#include "intern.h"
+
+/* number of shards (power of two) */
+#define INTERN_SHARDS 64
+
+/* initial number of buckets of a shard (power of two) */
+#define INTERN_MIN_BUCKETS 64
+
+/**
+ * Interned string entry.
+ */
+typedef struct _intern_entry_struct {
+    /* next entry of the same bucket */
+    struct _intern_entry_struct *next;
+    /* hash value of the string */
+    size_t hash;
+    /* length of the string */
+    size_t len;
+    /* number of references */
+    size_t refs;
+    /* string characters (null terminated) */
+    char str[1];
+} intern_entry;
+
+/**
+ * Interning table shard.
+ */
+typedef struct {
+    /* guards all members and the entries of the shard */
+    pthread_mutex_t lock;
+    /* buckets of entries */
+    intern_entry **buckets;
+    /* number of buckets */
+    size_t capacity;
+    /* number of entries */
+    size_t size;
+} intern_shard;
+
+static intern_shard shards[INTERN_SHARDS];
+static pthread_once_t intern_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Initialize all shard locks.
+ */
+static void
+intern_init(void) {
+    int i;
+    for (i = 0; i < INTERN_SHARDS; i++) {
+        pthread_mutex_init(&shards[i].lock, NULL);
+    }
+}
+
+/**
+ * Get the shard of the provided hash value.
+ *
+ * @param hash hash value of a string.
+ *
+ * @return the shard holding strings of that hash value.
+ */
+static inline intern_shard *
+intern_shard_of(size_t hash) {
+    /* low bits select the bucket, use other bits for the shard */
+    return &shards[(hash >> 24) & (INTERN_SHARDS - 1)];
+}
+
+/**
+ * Get the entry of a canonical pointer.
+ *
+ * @param interned canonical pointer.
+ *
+ * @return the entry holding the string.
+ */
+static inline intern_entry *
+intern_entry_of(const char *interned) {
+    return (intern_entry *)(interned - offsetof(intern_entry, str));
+}
+
+/**
+ * Double the number of buckets of the provided shard.
+ *
+ * @param shard shard to grow (locked).
+ */
+static void
+intern_shard_grow(intern_shard *shard) {
+    size_t capacity = shard->capacity ? 2 * shard->capacity : INTERN_MIN_BUCKETS;
+    intern_entry **buckets =
+        (intern_entry **)SAFE_MALLOC_WITH(cerializer_get_std_allocator(), capacity * sizeof(intern_entry *));
+    size_t i;
+    memset(buckets, 0, capacity * sizeof(intern_entry *));
+    for (i = 0; i < shard->capacity; i++) {
+        intern_entry *it = shard->buckets[i];
+        while (it) {
+            intern_entry *next = it->next;
+            size_t offset = it->hash & (capacity - 1);
+            it->next = buckets[offset];
+            buckets[offset] = it;
+            it = next;
+        }
+    }
+    if (shard->buckets != NULL) {
+        SAFE_FREE_WITH(cerializer_get_std_allocator(), shard->buckets);
+    }
+    shard->buckets = buckets;
+    shard->capacity = capacity;
+}
+
+/**
+ * Intern a null terminated string, acquiring a reference to it.
+ *
+ * @param str string to intern (not NULL).
+ *
+ * @return canonical pointer of the string, to be released with
+ *         cerializer_intern_release.
+ */
+extern const char *
+cerializer_intern(const char *str) {
+    return cerializer_intern_len(str, strlen(str));
+}
+
+/**
+ * Intern a string of known length (not required to be null terminated),
+ * acquiring a reference to it.
+ *
+ * @param str string to intern (not NULL).
+ * @param len length of the string.
+ *
+ * @return canonical (null terminated) pointer of the string, to be released
+ *         with cerializer_intern_release.
+ */
+extern const char *
+cerializer_intern_len(const char *str, size_t len) {
+    size_t hash = strkernel_hash_len(str, len);
+    intern_shard *shard = intern_shard_of(hash);
+    intern_entry *entry = NULL;
+
+    pthread_once(&intern_once, intern_init);
+    pthread_mutex_lock(&shard->lock);
+    if (shard->capacity > 0) {
+        entry = shard->buckets[hash & (shard->capacity - 1)];
+        while (entry) {
+            if (entry->hash == hash
+                && strkernel_equal_len(entry->str, entry->len, str, len)) {
+                break;
+            }
+            entry = entry->next;
+        }
+    }
+    if (entry == NULL) {
+        /* first reference, add a new entry */
+        size_t offset;
+        if (shard->size >= shard->capacity) {
+            intern_shard_grow(shard);
+        }
+        entry = (intern_entry *)SAFE_MALLOC_WITH(
+            cerializer_get_std_allocator(), offsetof(intern_entry, str) + len + 1);
+        entry->hash = hash;
+        entry->len = len;
+        entry->refs = 0;
+        memcpy(entry->str, str, len);
+        entry->str[len] = '\0';
+        offset = hash & (shard->capacity - 1);
+        entry->next = shard->buckets[offset];
+        shard->buckets[offset] = entry;
+        shard->size++;
+    }
+    entry->refs++;
+    pthread_mutex_unlock(&shard->lock);
+    return entry->str;
+}
+
+/**
+ * Acquire one more reference to an interned string.
+ *
+ * @param interned canonical pointer returned by cerializer_intern.
+ *
+ * @return the canonical pointer.
+ */
+extern const char *
+cerializer_intern_ref(const char *interned) {
+    if (interned != NULL) {
+        intern_entry *entry = intern_entry_of(interned);
+        intern_shard *shard = intern_shard_of(entry->hash);
+        pthread_mutex_lock(&shard->lock);
+        entry->refs++;
+        pthread_mutex_unlock(&shard->lock);
+    }
+    return interned;
+}
+
+/**
+ * Release a reference to an interned string. The string is removed from
+ * the table (and its memory released) with its last reference.
+ *
+ * @param interned canonical pointer returned by cerializer_intern
+ *        (NULL is ignored).
+ */
+extern void
+cerializer_intern_release(const char *interned) {
+    if (interned != NULL) {
+        intern_entry *entry = intern_entry_of(interned);
+        intern_shard *shard = intern_shard_of(entry->hash);
+        int last = 0;
+        pthread_mutex_lock(&shard->lock);
+        if (--entry->refs == 0) {
+            /* unlink from bucket */
+            intern_entry **it = &shard->buckets[entry->hash & (shard->capacity - 1)];
+            while (*it != entry) {
+                it = &(*it)->next;
+            }
+            *it = entry->next;
+            shard->size--;
+            last++;
+        }
+        pthread_mutex_unlock(&shard->lock);
+        if (last) {
+            SAFE_FREE_WITH(cerializer_get_std_allocator(), entry);
+        }
+    }
+}
+
+/**
+ * Get the number of distinct strings currently interned.
+ *
+ * @return number of distinct strings currently interned.
+ */
+extern size_t
+cerializer_intern_count(void) {
+    size_t result = 0;
+    int i;
+    pthread_once(&intern_once, intern_init);
+    for (i = 0; i < INTERN_SHARDS; i++) {
+        pthread_mutex_lock(&shards[i].lock);
+        result += shards[i].size;
+        pthread_mutex_unlock(&shards[i].lock);
+    }
+    return result;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Process-wide, thread-safe string interning table. Every distinct string
+ * is stored once and identified by a stable canonical pointer, so that
+ * interned strings can be compared by pointer. Interned strings are
+ * reference counted and released once their last reference is dropped.
+ * Memory is obtained from the standard library allocator (see
+ * cerializer_get_std_allocator), whatever the global library allocator or
+ * the allocator of the messages holding the strings, since the table
+ * lives as long as the process.
+ */
+
+#ifndef INTERN_H_
+#define INTERN_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * Intern a null terminated string, acquiring a reference to it.
+ *
+ * @param str string to intern (not NULL).
+ *
+ * @return canonical pointer of the string, to be released with
+ *         cerializer_intern_release.
+ */
+extern const char *
+cerializer_intern(const char *str);
+
+/**
+ * Intern a string of known length (not required to be null terminated),
+ * acquiring a reference to it.
+ *
+ * @param str string to intern (not NULL).
+ * @param len length of the string.
+ *
+ * @return canonical (null terminated) pointer of the string, to be released
+ *         with cerializer_intern_release.
+ */
+extern const char *
+cerializer_intern_len(const char *str, size_t len);
+
+/**
+ * Acquire one more reference to an interned string.
+ *
+ * @param interned canonical pointer returned by cerializer_intern.
+ *
+ * @return the canonical pointer.
+ */
+extern const char *
+cerializer_intern_ref(const char *interned);
+
+/**
+ * Release a reference to an interned string. The string is removed from
+ * the table (and its memory released) with its last reference.
+ *
+ * @param interned canonical pointer returned by cerializer_intern
+ *        (NULL is ignored).
+ */
+extern void
+cerializer_intern_release(const char *interned);
+
+/**
+ * Get the number of distinct strings currently interned.
+ *
+ * @return number of distinct strings currently interned.
+ */
+extern size_t
+cerializer_intern_count(void);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* INTERN_H_ */
@@ -15,29 +15,57 @@
  */
 
 /**
- * Simple logging module with log control to log statements on screen.
+ * Simple logging module with log control to log statements on screen, or
+ * to the configured log sinks, tagged with the context of the logging
+ * thread.
  */
 
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
 #include <time.h>
+#include <errno.h>
+#include <unistd.h>
 
 #ifdef HAVE_CONFIG_H
 #include <config.h>
-#ifdef HAVE_FTIME
-#define __USE_FTIME
-#endif /* HAVE_FTIME */
 #endif /* HAVE_CONFIG_H*/
 
-#ifdef __USE_FTIME
-#include <sys/timeb.h>
-#endif /* __USE_FTIME */
+/* asynchronous logging, the timestamp cache, rate limiting, sinks and
+ * thread contexts need thread-local storage and atomic builtins */
+#if defined(__GNUC__)
+#define USE_ASYNC_LOG
+#define USE_TIMESTAMP_CACHE
+#define USE_LOG_LIMIT
+#define USE_LOG_SINKS
+#define USE_LOG_CONTEXT
+#include <pthread.h>
+#include <sched.h>
+#include <sys/uio.h>
+#endif /* __GNUC__ */
 
+#include "stdlib_util.h"
 #include "log.h"
 
 #define DEF_BUFFER_LEN 1024
 
+/* maximum length of a context tag key and value */
+#define LOG_CONTEXT_KEY_LEN 16
+#define LOG_CONTEXT_VALUE_LEN 48
+
+/* maximum length of the rendered context tags ("[key=value ...]:"): per tag
+   the key, '=', the value and '[' or ' ', then "]:" (and one spare byte) */
+#define LOG_CONTEXT_LEN (LOG_CONTEXT_TAGS * (LOG_CONTEXT_KEY_LEN + LOG_CONTEXT_VALUE_LEN + 2) + 3)
+
+/* maximum length of a log line (timestamp, level and context included) */
+#define LOG_LINE_LEN (DEF_BUFFER_LEN + 64 + LOG_CONTEXT_LEN)
+
+/* length of a timestamp up to the seconds ("Www Mmm dd hh:mm:ss") */
+#define LOG_TIMESTAMP_SEC_LEN 19
+
+/* length of a timestamp ("Www Mmm dd hh:mm:ss.mmm") */
+#define LOG_TIMESTAMP_LEN (LOG_TIMESTAMP_SEC_LEN + 4)
+
 /* log level text */
 static const char *LOG_LEVELS_TEXT[] = {
     "[OFF]", "[ALL]", "[DEBUG]", "[INFO]", "[WARNING]", "[ERROR]" };
@@ -45,24 +73,597 @@ static const char *LOG_LEVELS_TEXT[] = {
 /* current log level */
 static log_level_e level = WARNING_LOG_LEVEL;
 
+/* lowest log level enabled, see log_level_threshold_of */
+int log_level_threshold = WARNING_LOG_LEVEL;
+
+/* log levels with a rate limit or sampling configured (1 << log level) */
+int log_limited_levels = 0;
+
+#ifdef USE_LOG_SINKS
+/**
+ * Log sink.
+ */
+typedef struct {
+    /* LOG_SINK_ACTIVE while the sink is in use (published last),
+     * LOG_SINK_REMOVED while it is being removed, zero while free */
+    int active;
+    /* number of threads currently writing to the sink */
+    unsigned long users;
+    /* kind of the sink */
+    log_sink_kind_e kind;
+    /* lowest log level enabled for the sink, see log_level_threshold_of */
+    int threshold;
+    /* file descriptor (FD_LOG_SINK) */
+    int fd;
+    /* callback and its argument (CALLBACK_LOG_SINK) */
+    log_sink_callback callback;
+    void *arg;
+    /* memory ring, its capacity and the number of bytes ever written to
+     * it, guarded by lock (MEMORY_LOG_SINK) */
+    char *ring;
+    size_t capacity;
+    size_t written;
+    pthread_mutex_t lock;
+} log_sink;
+
+/* states of a log sink slot besides free */
+#define LOG_SINK_ACTIVE 1
+#define LOG_SINK_REMOVED 2
+
+/* log sinks */
+static log_sink sinks[LOG_MAX_SINKS];
+
+/* number of active log sinks */
+static int sink_count = 0;
+
+/* number of times the calling thread is currently writing to each log
+ * sink (a sink callback may remove its own sink) */
+static __thread unsigned long thread_sink_users[LOG_MAX_SINKS];
+
+/* serializes adding and removing log sinks */
+static pthread_mutex_t sink_control_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif /* USE_LOG_SINKS */
+
+#ifdef USE_LOG_CONTEXT
+/**
+ * Context tag of a thread.
+ */
+typedef struct {
+    char key[LOG_CONTEXT_KEY_LEN + 1];
+    char value[LOG_CONTEXT_VALUE_LEN + 1];
+} log_context_tag;
+
+/* context tags of the thread */
+static __thread log_context_tag thread_context_tags[LOG_CONTEXT_TAGS];
+
+/* number of context tags of the thread */
+static __thread int thread_context_count = 0;
+
+/* rendered context tags of the thread */
+static __thread char thread_context[LOG_CONTEXT_LEN + 1];
+
+/* length of the rendered context tags of the thread */
+static __thread size_t thread_context_len = 0;
+#endif /* USE_LOG_CONTEXT */
+
+#ifdef USE_LOG_LIMIT
+/* sampling of each log level (log one in that many calls of a call site) */
+static unsigned long limit_sample_every[ERROR_LOG_LEVEL + 1];
+
+/* rate limit of each log level (ns between two calls of a call site) */
+static unsigned long long limit_interval_ns[ERROR_LOG_LEVEL + 1];
+
+/* rate limit burst of each log level (ns a call site may run ahead) */
+static unsigned long long limit_tolerance_ns[ERROR_LOG_LEVEL + 1];
+
+/* minimum interval between two suppressed calls reports of a call site */
+static unsigned long long limit_report_ns = 1000000000ULL;
+
+/* call sites which suppressed calls (listed once, never removed) */
+static log_limit_site *limit_sites = NULL;
+
+/* time the next report of suppressed calls is due (ns, zero while no
+ * suppressed calls are pending) */
+static unsigned long long limit_report_due = 0;
+
+static void log_limit_report_when_due(void);
+#endif /* USE_LOG_LIMIT */
+
+#ifdef USE_ASYNC_LOG
+/* number of log lines written by one writev call */
+#define ASYNC_LOG_BATCH 64
+
+/* pause of the flush thread while the ring is empty (nanoseconds) */
+#define ASYNC_LOG_IDLE_NS 1000000L
+
+/**
+ * Slot of the asynchronous log ring.
+ */
+typedef struct {
+    /* sequence number of the slot (see async_log_push/async_log_thread) */
+    size_t seq;
+    /* file descriptor to write the line to */
+    int fd;
+    /* length of the line */
+    size_t len;
+    /* log line */
+    char line[LOG_LINE_LEN];
+} async_log_slot;
+
+/**
+ * Bounded multi-producer single-consumer ring of log lines. Producers
+ * claim slots by advancing `head` with compare-and-swap and publish them
+ * through the slot sequence number, so that no lock is ever taken.
+ */
+typedef struct {
+    /* slots (capacity is a power of two) */
+    async_log_slot *slots;
+    /* capacity - 1 */
+    size_t mask;
+    /* next slot to claim by producers */
+    size_t head;
+    /* number of lines written by the flush thread */
+    size_t written;
+    /* policy in case the ring is full */
+    log_async_policy_e policy;
+    /* number of lines dropped because the ring was full */
+    unsigned long dropped;
+    /* non-zero once the flush thread has to drain the ring and exit */
+    int stopping;
+    /* background flush thread */
+    pthread_t thread;
+} async_log_ring;
+
+/* active ring (NULL while logging synchronously) */
+static async_log_ring *async_ring = NULL;
+
+/* number of threads currently using the active ring */
+static unsigned long async_users = 0;
+
+/* non-zero on the flush thread, which must not wait for its own ring */
+static __thread int async_log_flushing = 0;
+
+/* serializes log_async_start and log_async_stop */
+static pthread_mutex_t async_control_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* per-thread buffer where log lines are formatted */
+static __thread char thread_log_line[LOG_LINE_LEN];
+#endif /* USE_ASYNC_LOG */
+
+#ifdef USE_TIMESTAMP_CACHE
+/* second of the cached timestamp text of the thread */
+static __thread time_t cached_timestamp_sec = (time_t)-1;
+
+/* cached timestamp text (up to the seconds) of the thread */
+static __thread char cached_timestamp[LOG_TIMESTAMP_SEC_LEN + 1];
+#endif /* USE_TIMESTAMP_CACHE */
+
+/**
+ * Get the lowest log level enabled by the provided active log level.
+ *
+ * @param log_level active log level.
+ *
+ * @return lowest enabled log level (past ERROR_LOG_LEVEL if none).
+ */
+static int
+log_level_threshold_of(log_level_e log_level) {
+    if (log_level == ALL_LOG_LEVELS) {
+        return OFF_LOG_LEVEL;
+    } else if (log_level == OFF_LOG_LEVEL) {
+        return ERROR_LOG_LEVEL + 1;
+    }
+    return log_level;
+}
+
 /**
- * Tests whether the provided log level is enabled.
+ * Tests whether the provided log level is enabled by the active log level
+ * (see set_log_level), regardless of the log levels of the log sinks.
  *
  * @param log_level_request requested log level.
  *
  * @return Non-zero if logging is enabled, zero otherwise.
  */
-static int
+extern int
 log_level_enabled(log_level_e log_level_request) {
     int result = 0;
-    if (level == ALL_LOG_LEVELS || log_level_request == ALL_LOG_LEVELS) {
+    log_level_e current = LOG_LOAD_RELAXED(level);
+    if (current == ALL_LOG_LEVELS || log_level_request == ALL_LOG_LEVELS) {
         result++;
-    } else if (log_level_request >= level && level != OFF_LOG_LEVEL) {
+    } else if (log_level_request >= current && current != OFF_LOG_LEVEL) {
         result++;
     }
     return result;
 }
 
+/**
+ * Update the lowest log level enabled (log_level_threshold): that of the
+ * active log level or, while log sinks are active, the lowest of the log
+ * sinks (none while all logging is switched off). Called with
+ * sink_control_lock held, when there are log sinks.
+ */
+static void
+log_update_threshold(void) {
+    int threshold = log_level_threshold_of(LOG_LOAD_RELAXED(level));
+#ifdef USE_LOG_SINKS
+    if (threshold <= ERROR_LOG_LEVEL && sink_count > 0) {
+        int i;
+        threshold = ERROR_LOG_LEVEL + 1;
+        for (i = 0; i < LOG_MAX_SINKS; i++) {
+            if (sinks[i].active == LOG_SINK_ACTIVE && sinks[i].threshold < threshold) {
+                threshold = sinks[i].threshold;
+            }
+        }
+    }
+#endif /* USE_LOG_SINKS */
+#if defined(__GNUC__)
+    __atomic_store_n(&log_level_threshold, threshold, __ATOMIC_RELAXED);
+#else
+    log_level_threshold = threshold;
+#endif /* __GNUC__ */
+}
+
+/**
+ * Render the date and time up to the seconds (ctime style, without the
+ * year), always LOG_TIMESTAMP_SEC_LEN characters: day and month names are
+ * those of the C locale, whatever the locale of the application.
+ *
+ * @param buffer buffer of at least LOG_TIMESTAMP_SEC_LEN + 1 bytes.
+ * @param sec seconds since the epoch.
+ */
+static void
+log_render_seconds(char *buffer, time_t sec) {
+    static const char days[7][4] = {
+        "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+    static const char months[12][4] = {
+        "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    struct tm tm;
+    localtime_r(&sec, &tm);
+    memcpy(buffer, days[tm.tm_wday % 7], 3);
+    buffer[3] = ' ';
+    memcpy(buffer + 4, months[tm.tm_mon % 12], 3);
+    buffer[7] = ' ';
+    buffer[8] = tm.tm_mday >= 10 ? (char)('0' + tm.tm_mday / 10) : ' ';
+    buffer[9] = (char)('0' + tm.tm_mday % 10);
+    buffer[10] = ' ';
+    buffer[11] = (char)('0' + tm.tm_hour / 10);
+    buffer[12] = (char)('0' + tm.tm_hour % 10);
+    buffer[13] = ':';
+    buffer[14] = (char)('0' + tm.tm_min / 10);
+    buffer[15] = (char)('0' + tm.tm_min % 10);
+    buffer[16] = ':';
+    buffer[17] = (char)('0' + tm.tm_sec / 10);
+    buffer[18] = (char)('0' + tm.tm_sec % 10);
+    buffer[LOG_TIMESTAMP_SEC_LEN] = '\0';
+}
+
+/**
+ * Render the current timestamp ("Www Mmm dd hh:mm:ss.mmm"). The text up to
+ * the seconds is cached per thread and only rendered again once the second
+ * changes, while the milliseconds are appended arithmetically.
+ *
+ * @param buffer buffer of at least LOG_TIMESTAMP_LEN bytes (not null
+ *        terminated on return).
+ *
+ * @return length of the timestamp.
+ */
+static size_t
+log_render_timestamp(char *buffer) {
+    struct timespec now;
+    long ms;
+#ifdef CLOCK_REALTIME_COARSE
+    /* a few milliseconds resolution, but no system call */
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+#else
+    clock_gettime(CLOCK_REALTIME, &now);
+#endif /* CLOCK_REALTIME_COARSE */
+#ifdef USE_TIMESTAMP_CACHE
+    if (now.tv_sec != cached_timestamp_sec) {
+        log_render_seconds(cached_timestamp, now.tv_sec);
+        cached_timestamp_sec = now.tv_sec;
+    }
+    memcpy(buffer, cached_timestamp, LOG_TIMESTAMP_SEC_LEN);
+#else
+    {
+        char text[LOG_TIMESTAMP_SEC_LEN + 1];
+        log_render_seconds(text, now.tv_sec);
+        memcpy(buffer, text, LOG_TIMESTAMP_SEC_LEN);
+    }
+#endif /* USE_TIMESTAMP_CACHE */
+    ms = now.tv_nsec / 1000000;
+    buffer[LOG_TIMESTAMP_SEC_LEN] = '.';
+    buffer[LOG_TIMESTAMP_SEC_LEN + 1] = (char)('0' + ms / 100);
+    buffer[LOG_TIMESTAMP_SEC_LEN + 2] = (char)('0' + (ms / 10) % 10);
+    buffer[LOG_TIMESTAMP_SEC_LEN + 3] = (char)('0' + ms % 10);
+    return LOG_TIMESTAMP_LEN;
+}
+
+/**
+ * Render a log line (timestamp, level and formatted elements, new line
+ * terminated) into the provided buffer.
+ *
+ * @param buffer buffer of LOG_LINE_LEN bytes.
+ * @param log_level log level to use.
+ * @param format the output format to use.
+ * @param args variable argument list to log.
+ *
+ * @return length of the log line.
+ */
+static size_t
+log_render_line(char *buffer, log_level_e log_level, const char *format, va_list args) {
+    size_t len = log_render_timestamp(buffer);
+    const char *level_text = LOG_LEVELS_TEXT[log_level];
+    size_t level_len = strlen(level_text);
+    int n;
+    /* " - [LEVEL]:" */
+    memcpy(buffer + len, " - ", 3);
+    len += 3;
+    memcpy(buffer + len, level_text, level_len);
+    len += level_len;
+    buffer[len++] = ':';
+#ifdef USE_LOG_CONTEXT
+    /* "[key=value ...]:" */
+    memcpy(buffer + len, thread_context, thread_context_len);
+    len += thread_context_len;
+#endif /* USE_LOG_CONTEXT */
+    /* formatted elements (at most DEF_BUFFER_LEN - 1 characters as before) */
+    n = vsnprintf(buffer + len, DEF_BUFFER_LEN, format, args);
+    if (n > 0) {
+        len += (n < DEF_BUFFER_LEN) ? (size_t)n : DEF_BUFFER_LEN - 1;
+    }
+    buffer[len++] = '\n';
+    return len;
+}
+
+#ifdef USE_ASYNC_LOG
+/**
+ * Write all provided buffers to a file descriptor.
+ *
+ * @param fd file descriptor to write to.
+ * @param iov buffers to write (modified on partial writes).
+ * @param iovcnt number of buffers.
+ */
+static void
+async_log_writev(int fd, struct iovec *iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t n = writev(fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return; /* nowhere to report, give up on this batch */
+        }
+        /* skip fully written buffers, advance into a partially written one */
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+}
+
+/**
+ * Background flush thread: collects batches of published log lines and
+ * writes each batch with as few writev calls as possible.
+ *
+ * @param arg the ring to flush.
+ *
+ * @return NULL.
+ */
+static void *
+async_log_thread(void *arg) {
+    async_log_ring *ring = (async_log_ring *)arg;
+    size_t tail = 0;
+    async_log_flushing = 1;
+    for (;;) {
+        struct iovec iov[ASYNC_LOG_BATCH];
+        size_t count = 0;
+        size_t i;
+        int iovcnt = 0;
+        int fd = -1;
+        /* collect published slots */
+        while (count < ASYNC_LOG_BATCH) {
+            async_log_slot *slot = &ring->slots[(tail + count) & ring->mask];
+            if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != tail + count + 1) {
+                break;
+            }
+            count++;
+        }
+        if (count == 0) {
+            struct timespec idle = { 0, ASYNC_LOG_IDLE_NS };
+            if (__atomic_load_n(&ring->stopping, __ATOMIC_ACQUIRE)
+                && __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail) {
+                break;
+            }
+#ifdef USE_LOG_LIMIT
+            /* report suppressed calls even if nothing else is logged */
+            log_limit_report_when_due();
+#endif /* USE_LOG_LIMIT */
+            nanosleep(&idle, NULL);
+            continue;
+        }
+        /* write lines in order, one writev per run of the same descriptor */
+        for (i = 0; i < count; i++) {
+            async_log_slot *slot = &ring->slots[(tail + i) & ring->mask];
+            if (slot->fd != fd && iovcnt > 0) {
+                async_log_writev(fd, iov, iovcnt);
+                iovcnt = 0;
+            }
+            fd = slot->fd;
+            iov[iovcnt].iov_base = slot->line;
+            iov[iovcnt].iov_len = slot->len;
+            iovcnt++;
+        }
+        async_log_writev(fd, iov, iovcnt);
+        /* hand slots back to producers */
+        for (i = 0; i < count; i++) {
+            async_log_slot *slot = &ring->slots[(tail + i) & ring->mask];
+            __atomic_store_n(&slot->seq, tail + i + ring->mask + 1, __ATOMIC_RELEASE);
+        }
+        tail += count;
+        __atomic_store_n(&ring->written, tail, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+/**
+ * Push a log line into the ring, applying the ring policy when it is full
+ * (lines of the flush thread itself are dropped then).
+ *
+ * @param ring the ring.
+ * @param fd file descriptor to write the line to.
+ * @param line the log line.
+ * @param len length of the line.
+ */
+static void
+async_log_push(async_log_ring *ring, int fd, const char *line, size_t len) {
+    size_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    async_log_slot *slot;
+    for (;;) {
+        size_t seq;
+        slot = &ring->slots[pos & ring->mask];
+        seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq == pos) {
+            /* slot is free, try to claim it */
+            if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, 1,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if ((long)(seq - pos) < 0) {
+            /* ring is full */
+            if (ring->policy == DROP_ASYNC_LOG_POLICY || async_log_flushing) {
+                __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+                return;
+            }
+            sched_yield();
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        } else {
+            /* claimed by another producer meanwhile */
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        }
+    }
+    slot->fd = fd;
+    slot->len = len;
+    memcpy(slot->line, line, len);
+    /* publish */
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+}
+#endif /* USE_ASYNC_LOG */
+
+#ifdef USE_LOG_SINKS
+/**
+ * Append a log line to the ring of a memory sink, overwriting the oldest
+ * bytes once the ring is full.
+ *
+ * @param sink memory sink.
+ * @param line the log line.
+ * @param len length of the line.
+ */
+static void
+log_memory_sink_append(log_sink *sink, const char *line, size_t len) {
+    size_t offset;
+    size_t chunk;
+    pthread_mutex_lock(&sink->lock);
+    if (len > sink->capacity) {
+        /* keep the end of the line only */
+        sink->written += len - sink->capacity;
+        line += len - sink->capacity;
+        len = sink->capacity;
+    }
+    offset = sink->written % sink->capacity;
+    chunk = sink->capacity - offset;
+    if (chunk > len) {
+        chunk = len;
+    }
+    memcpy(sink->ring + offset, line, chunk);
+    memcpy(sink->ring, line + chunk, len - chunk);
+    sink->written += len;
+    pthread_mutex_unlock(&sink->lock);
+}
+
+/**
+ * Write a log line to all active log sinks enabled for its log level.
+ *
+ * @param log_level log level of the line.
+ * @param line the log line.
+ * @param len length of the line.
+ */
+static void
+log_sinks_write(log_level_e log_level, const char *line, size_t len) {
+    int i;
+    for (i = 0; i < LOG_MAX_SINKS; i++) {
+        log_sink *sink = &sinks[i];
+        if (__atomic_load_n(&sink->active, __ATOMIC_RELAXED) != LOG_SINK_ACTIVE
+            || (int)log_level < __atomic_load_n(&sink->threshold, __ATOMIC_RELAXED)) {
+            continue;
+        }
+        /* announce the use, then make sure the sink was not removed meanwhile */
+        thread_sink_users[i]++;
+        __atomic_fetch_add(&sink->users, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&sink->active, __ATOMIC_SEQ_CST) != LOG_SINK_ACTIVE) {
+            __atomic_fetch_sub(&sink->users, 1, __ATOMIC_RELEASE);
+            thread_sink_users[i]--;
+            continue;
+        }
+        switch (sink->kind) {
+        case FD_LOG_SINK:
+            log_write_record(sink->fd, line, len);
+            break;
+        case CALLBACK_LOG_SINK:
+            sink->callback(log_level, line, len, sink->arg);
+            break;
+        case MEMORY_LOG_SINK:
+            log_memory_sink_append(sink, line, len);
+            break;
+        }
+        __atomic_fetch_sub(&sink->users, 1, __ATOMIC_RELEASE);
+        thread_sink_users[i]--;
+    }
+}
+
+/**
+ * Add a log sink.
+ *
+ * @param prototype the sink to add (its active flag and lock are ignored).
+ *
+ * @return ID of the sink (positive), zero if there is no room for it.
+ */
+static int
+log_add_sink(const log_sink *prototype) {
+    int result = 0;
+    int i;
+    pthread_mutex_lock(&sink_control_lock);
+    for (i = 0; i < LOG_MAX_SINKS; i++) {
+        log_sink *sink = &sinks[i];
+        if (!sink->active) {
+            sink->kind = prototype->kind;
+            sink->threshold = prototype->threshold;
+            sink->fd = prototype->fd;
+            sink->callback = prototype->callback;
+            sink->arg = prototype->arg;
+            sink->ring = prototype->ring;
+            sink->capacity = prototype->capacity;
+            sink->written = 0;
+            if (sink->kind == MEMORY_LOG_SINK) {
+                pthread_mutex_init(&sink->lock, NULL);
+            }
+            /* publish */
+            __atomic_store_n(&sink->active, LOG_SINK_ACTIVE, __ATOMIC_SEQ_CST);
+            __atomic_fetch_add(&sink_count, 1, __ATOMIC_SEQ_CST);
+            log_update_threshold();
+            result = i + 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&sink_control_lock);
+    return result;
+}
+#endif /* USE_LOG_SINKS */
+
 /**
  * Log a variable argument list with the provided output format.
  *
@@ -72,32 +673,92 @@ log_level_enabled(log_level_e log_level_request) {
  */
 static void
 log_format_va_list(log_level_e log_level, const char *format, va_list args) {
-    if (log_level_enabled(log_level)) {
-#ifdef __USE_FTIME
-        struct timeb timebuffer;
-#else
-        time_t time_now = time(NULL);
-#endif /* __USE_FTIME */
-        char * t;
+#ifdef USE_LOG_LIMIT
+    log_limit_report_when_due();
+#endif /* USE_LOG_LIMIT */
+    /* the active log level or, while log sinks are active, theirs */
+    if (log_level == ALL_LOG_LEVELS || (int)log_level >= LOG_LOAD_RELAXED(log_level_threshold)) {
         FILE * file_p = stdout;
-        char log_data[DEF_BUFFER_LEN];
-#ifdef __USE_FTIME
-        ftime(&timebuffer);
-        t = ctime(&(timebuffer.time));
+#ifdef USE_ASYNC_LOG
+        char *log_line = thread_log_line;
+        async_log_ring *ring;
 #else
-        t = ctime(&time_now);
-#endif /* __USE_FTIME */
-        t[strlen(t) - 1] = '\0'; /* replace new line character */
+        char log_line[LOG_LINE_LEN];
+#endif /* USE_ASYNC_LOG */
+        size_t len;
         if (log_level >= WARNING_LOG_LEVEL) {
             file_p = stderr;
         }
-        vsnprintf(log_data, DEF_BUFFER_LEN, format, args);
-#ifdef __USE_FTIME
-        fprintf(file_p, "%.19s.%03hu - %s:%s\n", t, timebuffer.millitm,
-            LOG_LEVELS_TEXT[log_level], log_data);
-#else
-        fprintf(file_p, "%s - %s:%s\n", t, LOG_LEVELS_TEXT[log_level], log_data);
-#endif /* __USE_FTIME */
+        len = log_render_line(log_line, log_level, format, args);
+#ifdef USE_LOG_SINKS
+        if (__atomic_load_n(&sink_count, __ATOMIC_ACQUIRE) > 0) {
+            log_sinks_write(log_level, log_line, len);
+            return;
+        }
+#endif /* USE_LOG_SINKS */
+#ifdef USE_ASYNC_LOG
+        __atomic_fetch_add(&async_users, 1, __ATOMIC_SEQ_CST);
+        ring = __atomic_load_n(&async_ring, __ATOMIC_SEQ_CST);
+        if (ring != NULL) {
+            async_log_push(ring, fileno(file_p), log_line, len);
+            __atomic_fetch_sub(&async_users, 1, __ATOMIC_RELEASE);
+            return;
+        }
+        __atomic_fetch_sub(&async_users, 1, __ATOMIC_RELEASE);
+#endif /* USE_ASYNC_LOG */
+        fwrite(log_line, 1, len, file_p);
+    }
+}
+
+/**
+ * Get the text of a log level (e.g. "[ERROR]").
+ *
+ * @param log_level log level.
+ *
+ * @return text of the log level.
+ */
+extern const char *
+log_level_text(log_level_e log_level) {
+    if (log_level < OFF_LOG_LEVEL || log_level > ERROR_LOG_LEVEL) {
+        return "[?]";
+    }
+    return LOG_LEVELS_TEXT[log_level];
+}
+
+/**
+ * Write a complete log record (e.g. a binary log record) to a file
+ * descriptor, through the asynchronous log ring when it is active and
+ * the record fits in a ring slot.
+ *
+ * @param fd file descriptor to write to.
+ * @param record the record.
+ * @param len length of the record.
+ */
+extern void
+log_write_record(int fd, const char *record, size_t len) {
+#ifdef USE_ASYNC_LOG
+    if (len <= LOG_LINE_LEN) {
+        async_log_ring *ring;
+        __atomic_fetch_add(&async_users, 1, __ATOMIC_SEQ_CST);
+        ring = __atomic_load_n(&async_ring, __ATOMIC_SEQ_CST);
+        if (ring != NULL) {
+            async_log_push(ring, fd, record, len);
+            __atomic_fetch_sub(&async_users, 1, __ATOMIC_RELEASE);
+            return;
+        }
+        __atomic_fetch_sub(&async_users, 1, __ATOMIC_RELEASE);
+    }
+#endif /* USE_ASYNC_LOG */
+    while (len > 0) {
+        ssize_t n = write(fd, record, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return; /* nowhere to report */
+        }
+        record += n;
+        len -= (size_t)n;
     }
 }
 
@@ -137,37 +798,22 @@ log_function_message(
  */
 extern void
 log_format(log_level_e log_level, const char *format, ...) {
-    if (log_level_enabled(log_level)) {
-#ifdef __USE_FTIME
-        struct timeb timebuffer;
-#else
-        time_t time_now = time(NULL);
-#endif /* __USE_FTIME */
-        char * t;
-        FILE * file_p = stdout;
-        va_list args;
-        char log_data[DEF_BUFFER_LEN];
+    va_list args;
+    va_start(args, format);
+    log_format_va_list(log_level, format, args);
+    va_end(args);
+}
 
-#ifdef __USE_FTIME
-        ftime(&timebuffer);
-        t = ctime(&(timebuffer.time));
-#else
-        t = ctime(&time_now);
-#endif /* __USE_FTIME */
-        t[strlen(t) - 1] = '\0'; /* replace new line character */
-        if (log_level >= WARNING_LOG_LEVEL) {
-            file_p = stderr;
-        }
-        va_start(args, format);
-        vsnprintf(log_data, DEF_BUFFER_LEN, format, args);
-        va_end(args);
-#ifdef __USE_FTIME
-        fprintf(file_p, "%.19s.%03hu - %s:%s\n", t, timebuffer.millitm,
-            LOG_LEVELS_TEXT[log_level], log_data);
-#else
-        fprintf(file_p, "%s - %s:%s\n", t, LOG_LEVELS_TEXT[log_level], log_data);
-#endif /* __USE_FTIME */
-    }
+/**
+ * Log a variable argument list with the provided output format.
+ *
+ * @param log_level log level to use.
+ * @param format the output format to use.
+ * @param args variable argument list to log.
+ */
+extern void
+log_vformat(log_level_e log_level, const char *format, va_list args) {
+    log_format_va_list(log_level, format, args);
 }
 
 /**
@@ -311,13 +957,26 @@ log_error_format(const char *format, ...) {
 }
 
 /**
- * Set the active log level.
+ * Set the active log level (safe to call while other threads log). It
+ * applies to stdout/stderr and binary logs, while each log sink has its
+ * own log level. OFF_LOG_LEVEL switches off all logging, log sinks included.
  *
  * @param log_level the value to set.
  */
 extern void
 set_log_level(log_level_e log_level) {
+#ifdef USE_LOG_SINKS
+    pthread_mutex_lock(&sink_control_lock);
+#endif /* USE_LOG_SINKS */
+#if defined(__GNUC__)
+    __atomic_store_n(&level, log_level, __ATOMIC_RELAXED);
+#else
     level = log_level;
+#endif /* __GNUC__ */
+    log_update_threshold();
+#ifdef USE_LOG_SINKS
+    pthread_mutex_unlock(&sink_control_lock);
+#endif /* USE_LOG_SINKS */
 }
 
 /**
@@ -335,3 +994,659 @@ extern void
 switch_off_all_log(void) {
     set_log_level(OFF_LOG_LEVEL);
 }
+
+/**
+ * Add a log sink writing log lines to a file descriptor (through the
+ * asynchronous log ring when it is active). Once a sink is added, log
+ * lines are no longer written to stdout/stderr but to the sinks.
+ *
+ * @param fd file descriptor to write to (not closed by the logger).
+ * @param log_level lowest log level written to the sink, regardless of the active
+ *        log level (see set_log_level).
+ *
+ * @return ID of the sink (positive), zero if there is no room for it.
+ */
+extern int
+log_add_fd_sink(int fd, log_level_e log_level) {
+    int result = 0;
+#ifdef USE_LOG_SINKS
+    log_sink sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.kind = FD_LOG_SINK;
+    sink.threshold = log_level_threshold_of(log_level);
+    sink.fd = fd;
+    /* lines buffered so far must not be overtaken */
+    fflush(stdout);
+    fflush(stderr);
+    result = log_add_sink(&sink);
+#endif /* USE_LOG_SINKS */
+    return result;
+}
+
+/**
+ * Add a log sink passing log lines to a callback.
+ *
+ * @param callback callback to call with every log line.
+ * @param arg argument to pass to the callback.
+ * @param log_level lowest log level passed to the sink, regardless of the active
+ *        log level (see set_log_level).
+ *
+ * @return ID of the sink (positive), zero if there is no room for it.
+ */
+extern int
+log_add_callback_sink(log_sink_callback callback, void *arg, log_level_e log_level) {
+    int result = 0;
+#ifdef USE_LOG_SINKS
+    log_sink sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.kind = CALLBACK_LOG_SINK;
+    sink.threshold = log_level_threshold_of(log_level);
+    sink.callback = callback;
+    sink.arg = arg;
+    result = log_add_sink(&sink);
+#endif /* USE_LOG_SINKS */
+    return result;
+}
+
+/**
+ * Add a log sink keeping the most recent log lines in a memory ring.
+ *
+ * @param capacity size of the ring (bytes).
+ * @param log_level lowest log level kept by the sink, regardless of the active
+ *        log level (see set_log_level).
+ *
+ * @return ID of the sink (positive), zero if there is no room for it.
+ */
+extern int
+log_add_memory_sink(size_t capacity, log_level_e log_level) {
+    int result = 0;
+#ifdef USE_LOG_SINKS
+    if (capacity > 0) {
+        log_sink sink;
+        memset(&sink, 0, sizeof(sink));
+        sink.kind = MEMORY_LOG_SINK;
+        sink.threshold = log_level_threshold_of(log_level);
+        sink.ring = (char *)SAFE_MALLOC_WITH(cerializer_get_std_allocator(), capacity);
+        sink.capacity = capacity;
+        result = log_add_sink(&sink);
+        if (result == 0) {
+            SAFE_FREE_WITH(cerializer_get_std_allocator(), sink.ring);
+        }
+    }
+#endif /* USE_LOG_SINKS */
+    return result;
+}
+
+/**
+ * Read the most recent (complete) log lines kept by a memory sink.
+ *
+ * @param sink ID of a memory sink.
+ * @param buffer buffer to copy the lines into (null terminated).
+ * @param size size of the buffer.
+ *
+ * @return length of the lines copied.
+ */
+extern size_t
+log_memory_sink_read(int sink, char *buffer, size_t size) {
+    size_t result = 0;
+    if (size == 0) {
+        return result;
+    }
+#ifdef USE_LOG_SINKS
+    pthread_mutex_lock(&sink_control_lock);
+    if (sink >= 1 && sink <= LOG_MAX_SINKS && sinks[sink - 1].active == LOG_SINK_ACTIVE
+        && sinks[sink - 1].kind == MEMORY_LOG_SINK) {
+        log_sink *memory_sink = &sinks[sink - 1];
+        size_t available, start, i;
+        pthread_mutex_lock(&memory_sink->lock);
+        available = memory_sink->written < memory_sink->capacity
+            ? memory_sink->written : memory_sink->capacity;
+        if (available > size - 1) {
+            available = size - 1;
+        }
+        start = memory_sink->written - available;
+        /* skip a partially kept line (the byte before start is only
+         * known while it was not overwritten) */
+        if (start > 0 && (start + memory_sink->capacity == memory_sink->written
+            || memory_sink->ring[(start - 1) % memory_sink->capacity] != '\n')) {
+            while (available > 0
+                && memory_sink->ring[start % memory_sink->capacity] != '\n') {
+                start++;
+                available--;
+            }
+            if (available > 0) {
+                start++;
+                available--;
+            }
+        }
+        for (i = 0; i < available; i++) {
+            buffer[i] = memory_sink->ring[(start + i) % memory_sink->capacity];
+        }
+        result = available;
+        pthread_mutex_unlock(&memory_sink->lock);
+    }
+    pthread_mutex_unlock(&sink_control_lock);
+#endif /* USE_LOG_SINKS */
+    buffer[result] = '\0';
+    return result;
+}
+
+/**
+ * Remove a log sink. Once the last sink is removed, log lines are written
+ * to stdout/stderr again. Waits for other threads still writing to the
+ * sink, so a callback is not called anymore once this returns (unless it
+ * is the calling thread's own callback removing its sink).
+ *
+ * @param sink ID of the sink.
+ */
+extern void
+log_remove_sink(int sink) {
+#ifdef USE_LOG_SINKS
+    log_sink *removed = NULL;
+    pthread_mutex_lock(&sink_control_lock);
+    if (sink >= 1 && sink <= LOG_MAX_SINKS && sinks[sink - 1].active == LOG_SINK_ACTIVE) {
+        removed = &sinks[sink - 1];
+        /* the slot is not reused until the sink is completely removed */
+        __atomic_store_n(&removed->active, LOG_SINK_REMOVED, __ATOMIC_SEQ_CST);
+        __atomic_fetch_sub(&sink_count, 1, __ATOMIC_SEQ_CST);
+        log_update_threshold();
+    }
+    pthread_mutex_unlock(&sink_control_lock);
+    if (removed != NULL) {
+        struct timespec pause = { 0, 100000L };
+        /* wait for the other threads still writing to the sink, without
+         * holding sink_control_lock, which their sink callbacks may need */
+        while (__atomic_load_n(&removed->users, __ATOMIC_SEQ_CST) > thread_sink_users[sink - 1]) {
+            nanosleep(&pause, NULL);
+        }
+        pthread_mutex_lock(&sink_control_lock);
+        if (removed->kind == MEMORY_LOG_SINK) {
+            pthread_mutex_destroy(&removed->lock);
+            SAFE_FREE_WITH(cerializer_get_std_allocator(), removed->ring);
+            removed->ring = NULL;
+        }
+        __atomic_store_n(&removed->active, 0, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&sink_control_lock);
+    }
+#endif /* USE_LOG_SINKS */
+}
+
+#ifdef USE_LOG_CONTEXT
+/**
+ * Render the context tags of the calling thread ("[key=value ...]:").
+ */
+static void
+log_context_render(void) {
+    size_t len = 0;
+    int i;
+    if (thread_context_count > 0) {
+        thread_context[len++] = '[';
+        for (i = 0; i < thread_context_count; i++) {
+            size_t key_len = strlen(thread_context_tags[i].key);
+            size_t value_len = strlen(thread_context_tags[i].value);
+            /* room for the separator, the tag and the closing "]:" */
+            if (len + 1 + key_len + 1 + value_len + 2 > LOG_CONTEXT_LEN) {
+                break;
+            }
+            if (i > 0) {
+                thread_context[len++] = ' ';
+            }
+            memcpy(thread_context + len, thread_context_tags[i].key, key_len);
+            len += key_len;
+            thread_context[len++] = '=';
+            memcpy(thread_context + len, thread_context_tags[i].value, value_len);
+            len += value_len;
+        }
+        thread_context[len++] = ']';
+        thread_context[len++] = ':';
+    }
+    thread_context[len] = '\0';
+    thread_context_len = len;
+}
+#endif /* USE_LOG_CONTEXT */
+
+/**
+ * Set a context tag of the calling thread (e.g. "worker" or "message"),
+ * prefixed to every log line the thread logs as "[key=value ...]".
+ *
+ * @param key key of the tag.
+ * @param value value of the tag (NULL to remove the tag).
+ *
+ * @return Non-zero if the tag was set, zero otherwise (too many tags, or
+ *         not supported).
+ */
+extern int
+log_context_set(const char *key, const char *value) {
+    int result = 0;
+#ifdef USE_LOG_CONTEXT
+    int i;
+    for (i = 0; i < thread_context_count; i++) {
+        if (strncmp(thread_context_tags[i].key, key, LOG_CONTEXT_KEY_LEN) == 0) {
+            break;
+        }
+    }
+    if (value == NULL) {
+        /* remove, keeping the order of the other tags */
+        if (i < thread_context_count) {
+            memmove(&thread_context_tags[i], &thread_context_tags[i + 1],
+                (thread_context_count - i - 1) * sizeof(log_context_tag));
+            thread_context_count--;
+        }
+        result++;
+    } else if (i < LOG_CONTEXT_TAGS) {
+        log_context_tag *tag = &thread_context_tags[i];
+        strncpy(tag->key, key, LOG_CONTEXT_KEY_LEN);
+        tag->key[LOG_CONTEXT_KEY_LEN] = '\0';
+        strncpy(tag->value, value, LOG_CONTEXT_VALUE_LEN);
+        tag->value[LOG_CONTEXT_VALUE_LEN] = '\0';
+        if (i == thread_context_count) {
+            thread_context_count++;
+        }
+        result++;
+    }
+    log_context_render();
+#else
+    (void)key;
+    (void)value;
+#endif /* USE_LOG_CONTEXT */
+    return result;
+}
+
+/**
+ * Get a context tag of the calling thread.
+ *
+ * @param key key of the tag.
+ *
+ * @return value of the tag, NULL if not set.
+ */
+extern const char *
+log_context_get(const char *key) {
+#ifdef USE_LOG_CONTEXT
+    int i;
+    for (i = 0; i < thread_context_count; i++) {
+        if (strncmp(thread_context_tags[i].key, key, LOG_CONTEXT_KEY_LEN) == 0) {
+            return thread_context_tags[i].value;
+        }
+    }
+#else
+    (void)key;
+#endif /* USE_LOG_CONTEXT */
+    return NULL;
+}
+
+/**
+ * Remove all context tags of the calling thread.
+ */
+extern void
+log_context_clear(void) {
+#ifdef USE_LOG_CONTEXT
+    thread_context_count = 0;
+    log_context_render();
+#endif /* USE_LOG_CONTEXT */
+}
+
+#ifdef USE_LOG_LIMIT
+/**
+ * Get the current time of the monotonic clock.
+ *
+ * @return nanoseconds of the monotonic clock.
+ */
+static unsigned long long
+log_monotonic_ns(void) {
+    struct timespec now;
+#ifdef CLOCK_MONOTONIC_COARSE
+    /* a few milliseconds resolution, but no system call */
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#endif /* CLOCK_MONOTONIC_COARSE */
+    return (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/**
+ * Update the set of log levels with a rate limit or sampling configured.
+ *
+ * @param log_level log level whose configuration changed.
+ */
+static void
+log_limit_update(log_level_e log_level) {
+    if (__atomic_load_n(&limit_sample_every[log_level], __ATOMIC_RELAXED) > 1
+        || __atomic_load_n(&limit_interval_ns[log_level], __ATOMIC_RELAXED) > 0) {
+        __atomic_or_fetch(&log_limited_levels, 1 << log_level, __ATOMIC_RELEASE);
+    } else {
+        __atomic_and_fetch(&log_limited_levels, ~(1 << log_level), __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * List a call site which suppressed calls for log_report_suppressed (once).
+ *
+ * @param site call site state.
+ * @param log_level log level of the call site.
+ */
+static void
+log_limit_list(log_limit_site *site, log_level_e log_level) {
+    int listed = 0;
+    if (!__atomic_load_n(&site->listed, __ATOMIC_RELAXED)
+        && __atomic_compare_exchange_n(&site->listed, &listed, 1, 0,
+            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        site->level = log_level;
+        site->next = __atomic_load_n(&limit_sites, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&limit_sites, &site->next, site, 1,
+            __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
+}
+
+/**
+ * Count a suppressed call of a call site, and schedule a report of the
+ * suppressed calls unless one is pending already.
+ *
+ * @param site call site state.
+ * @param log_level log level of the call site.
+ */
+static void
+log_limit_suppress(log_limit_site *site, log_level_e log_level) {
+    unsigned long long due = 0;
+    __atomic_fetch_add(&site->suppressed, 1, __ATOMIC_RELAXED);
+    log_limit_list(site, log_level);
+    if (!__atomic_load_n(&limit_report_due, __ATOMIC_RELAXED)) {
+        __atomic_compare_exchange_n(&limit_report_due, &due,
+            log_monotonic_ns() + __atomic_load_n(&limit_report_ns, __ATOMIC_RELAXED),
+            0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Report the suppressed calls of all call sites once the scheduled report
+ * is due, so that storms which stopped are reported too. Costs a single
+ * load while no report is pending.
+ */
+static void
+log_limit_report_when_due(void) {
+    unsigned long long due = __atomic_load_n(&limit_report_due, __ATOMIC_RELAXED);
+    if (due != 0 && log_monotonic_ns() >= due
+        && __atomic_compare_exchange_n(&limit_report_due, &due, 0, 0,
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        log_report_suppressed();
+    }
+}
+#endif /* USE_LOG_LIMIT */
+
+/**
+ * Limit the rate of every call site logging (through the CLOG_* macros) at
+ * the provided log level, with a token bucket: a call site may log bursts
+ * of up to `burst` calls, and `rate` calls per second on average. The
+ * number of calls suppressed is reported periodically by the call site
+ * (see log_set_suppressed_report_interval).
+ *
+ * @param log_level log level to limit.
+ * @param rate calls per second allowed per call site (zero for no limit).
+ * @param burst calls allowed in a burst (at least one).
+ */
+extern void
+log_set_rate_limit(log_level_e log_level, unsigned long rate, unsigned long burst) {
+#ifdef USE_LOG_LIMIT
+    if (log_level >= OFF_LOG_LEVEL && log_level <= ERROR_LOG_LEVEL) {
+        unsigned long long interval = rate > 0 ? 1000000000ULL / rate : 0;
+        if (rate > 0 && interval == 0) {
+            interval = 1;
+        }
+        if (burst == 0) {
+            burst = 1;
+        }
+        __atomic_store_n(&limit_tolerance_ns[log_level], interval * (burst - 1), __ATOMIC_RELAXED);
+        __atomic_store_n(&limit_interval_ns[log_level], interval, __ATOMIC_RELAXED);
+        log_limit_update(log_level);
+    }
+#endif /* USE_LOG_LIMIT */
+}
+
+/**
+ * Sample every call site logging (through the CLOG_* macros) at the
+ * provided log level: only one in `every` calls of a call site is logged
+ * (before any rate limit applies). The number of calls suppressed is
+ * reported periodically by the call site.
+ *
+ * @param log_level log level to sample.
+ * @param every log one in `every` calls (zero or one for all calls).
+ */
+extern void
+log_set_sampling(log_level_e log_level, unsigned long every) {
+#ifdef USE_LOG_LIMIT
+    if (log_level >= OFF_LOG_LEVEL && log_level <= ERROR_LOG_LEVEL) {
+        __atomic_store_n(&limit_sample_every[log_level], every, __ATOMIC_RELAXED);
+        log_limit_update(log_level);
+    }
+#endif /* USE_LOG_LIMIT */
+}
+
+/**
+ * Set how often a call site reports the number of calls it suppressed.
+ * The report is logged along with the next call the call site logs; calls
+ * suppressed by a call site that is not logging again are reported once
+ * the interval elapsed, by the next call logged or rate limited anywhere
+ * (or by the asynchronous flush thread, see log_async_start).
+ *
+ * @param ms minimum interval between two reports of a call site
+ *        (milliseconds, 1000 by default).
+ */
+extern void
+log_set_suppressed_report_interval(unsigned long ms) {
+#ifdef USE_LOG_LIMIT
+    __atomic_store_n(&limit_report_ns, ms * 1000000ULL, __ATOMIC_RELAXED);
+#endif /* USE_LOG_LIMIT */
+}
+
+/**
+ * Tests whether a rate limited or sampled call site may log, first
+ * reporting the number of calls it suppressed when due. Use the CLOG_*
+ * macros instead of calling this directly.
+ *
+ * @param site call site state (see LOG_LIMIT_SITE_INIT).
+ * @param log_level log level of the call site.
+ *
+ * @return Non-zero if the call may be logged, zero if it is suppressed.
+ */
+extern int
+log_limit_pass(log_limit_site *site, log_level_e log_level) {
+    int result = 1;
+#ifdef USE_LOG_LIMIT
+    unsigned long every;
+    unsigned long long interval;
+    unsigned long long now;
+    unsigned long suppressed;
+    if (log_level < OFF_LOG_LEVEL || log_level > ERROR_LOG_LEVEL) {
+        return result;
+    }
+    log_limit_report_when_due();
+    /* sampling: one relaxed increment, no clock read (unless scheduling a report) */
+    every = __atomic_load_n(&limit_sample_every[log_level], __ATOMIC_RELAXED);
+    if (every > 1
+        && __atomic_fetch_add(&site->calls, 1, __ATOMIC_RELAXED) % every != 0) {
+        log_limit_suppress(site, log_level);
+        return 0;
+    }
+    now = log_monotonic_ns();
+    /* rate limiting, as a generic cell rate algorithm (equivalent to a
+     * token bucket, but a single word of state updated with one CAS) */
+    interval = __atomic_load_n(&limit_interval_ns[log_level], __ATOMIC_RELAXED);
+    if (interval > 0) {
+        unsigned long long tolerance =
+            __atomic_load_n(&limit_tolerance_ns[log_level], __ATOMIC_RELAXED);
+        unsigned long long tat = __atomic_load_n(&site->tat, __ATOMIC_RELAXED);
+        unsigned long long base;
+        do {
+            base = tat > now ? tat : now;
+            if (base - now > tolerance) {
+                /* bucket empty */
+                log_limit_suppress(site, log_level);
+                return 0;
+            }
+        } while (!__atomic_compare_exchange_n(&site->tat, &tat, base + interval, 1,
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    }
+    /* report suppressed calls, at most once per report interval */
+    suppressed = __atomic_load_n(&site->suppressed, __ATOMIC_RELAXED);
+    if (suppressed > 0) {
+        unsigned long long reported = __atomic_load_n(&site->reported, __ATOMIC_RELAXED);
+        if (now - reported >= __atomic_load_n(&limit_report_ns, __ATOMIC_RELAXED)
+            && __atomic_compare_exchange_n(&site->reported, &reported, now, 0,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            suppressed = __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED);
+            if (suppressed > 0) {
+                log_format(log_level, "suppressed %lu log calls of %s:%d",
+                    suppressed, site->file, site->line);
+            }
+        }
+    }
+#else
+    (void)site;
+    (void)log_level;
+#endif /* USE_LOG_LIMIT */
+    return result;
+}
+
+/**
+ * Report the number of calls suppressed by every call site and not
+ * reported yet, regardless of the report interval. Called automatically
+ * once the report interval elapsed (see log_set_suppressed_report_interval)
+ * and by log_async_flush and log_async_stop.
+ */
+extern void
+log_report_suppressed(void) {
+#ifdef USE_LOG_LIMIT
+    log_limit_site *site = __atomic_load_n(&limit_sites, __ATOMIC_ACQUIRE);
+    unsigned long long now = log_monotonic_ns();
+    for (; site != NULL; site = site->next) {
+        unsigned long suppressed = __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED);
+        if (suppressed > 0) {
+            __atomic_store_n(&site->reported, now, __ATOMIC_RELAXED);
+            log_format((log_level_e)site->level, "suppressed %lu log calls of %s:%d",
+                suppressed, site->file, site->line);
+        }
+    }
+#endif /* USE_LOG_LIMIT */
+}
+
+/**
+ * Switch to asynchronous logging: log lines are formatted on the calling
+ * thread and pushed into a lock-free ring, while a background thread writes
+ * them out in batches.
+ *
+ * @param capacity number of log lines the ring can hold (rounded up to a
+ *        power of two).
+ * @param policy what to do when the ring is full.
+ *
+ * @return Non-zero if asynchronous logging was started, zero otherwise
+ *         (already started or not supported).
+ */
+extern int
+log_async_start(size_t capacity, log_async_policy_e policy) {
+    int result = 0;
+#ifdef USE_ASYNC_LOG
+    pthread_mutex_lock(&async_control_lock);
+    if (async_ring == NULL && capacity > 0) {
+        async_log_ring *ring = (async_log_ring *)SAFE_MALLOC_WITH(
+            cerializer_get_std_allocator(), sizeof(async_log_ring));
+        size_t size = 1;
+        size_t i;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        ring->slots = (async_log_slot *)SAFE_MALLOC_WITH(
+            cerializer_get_std_allocator(), size * sizeof(async_log_slot));
+        for (i = 0; i < size; i++) {
+            ring->slots[i].seq = i;
+        }
+        ring->mask = size - 1;
+        ring->head = 0;
+        ring->written = 0;
+        ring->policy = policy;
+        ring->dropped = 0;
+        ring->stopping = 0;
+        /* lines buffered so far must not be overtaken */
+        fflush(stdout);
+        fflush(stderr);
+        if (pthread_create(&ring->thread, NULL, async_log_thread, ring) == 0) {
+            __atomic_store_n(&async_ring, ring, __ATOMIC_SEQ_CST);
+            result++;
+        } else {
+            SAFE_FREE_WITH(cerializer_get_std_allocator(), ring->slots);
+            SAFE_FREE_WITH(cerializer_get_std_allocator(), ring);
+        }
+    }
+    pthread_mutex_unlock(&async_control_lock);
+#endif /* USE_ASYNC_LOG */
+    return result;
+}
+
+/**
+ * Wait until all log lines pushed so far have been written out.
+ */
+extern void
+log_async_flush(void) {
+#ifdef USE_ASYNC_LOG
+    async_log_ring *ring;
+    log_report_suppressed();
+    pthread_mutex_lock(&async_control_lock);
+    ring = async_ring;
+    if (ring != NULL) {
+        size_t target = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        struct timespec pause = { 0, ASYNC_LOG_IDLE_NS / 10 };
+        while (__atomic_load_n(&ring->written, __ATOMIC_ACQUIRE) < target) {
+            nanosleep(&pause, NULL);
+        }
+    }
+    pthread_mutex_unlock(&async_control_lock);
+#endif /* USE_ASYNC_LOG */
+}
+
+/**
+ * Switch back to synchronous logging, after writing out all pending
+ * log lines.
+ */
+extern void
+log_async_stop(void) {
+#ifdef USE_ASYNC_LOG
+    async_log_ring *ring;
+    log_report_suppressed();
+    pthread_mutex_lock(&async_control_lock);
+    ring = async_ring;
+    if (ring != NULL) {
+        struct timespec pause = { 0, ASYNC_LOG_IDLE_NS / 10 };
+        /* new log lines are written synchronously from now on */
+        __atomic_store_n(&async_ring, NULL, __ATOMIC_SEQ_CST);
+        /* wait for threads still pushing into the ring */
+        while (__atomic_load_n(&async_users, __ATOMIC_SEQ_CST) > 0) {
+            nanosleep(&pause, NULL);
+        }
+        __atomic_store_n(&ring->stopping, 1, __ATOMIC_RELEASE);
+        pthread_join(ring->thread, NULL);
+        SAFE_FREE_WITH(cerializer_get_std_allocator(), ring->slots);
+        SAFE_FREE_WITH(cerializer_get_std_allocator(), ring);
+    }
+    pthread_mutex_unlock(&async_control_lock);
+#endif /* USE_ASYNC_LOG */
+}
+
+/**
+ * Get the number of log lines dropped because the asynchronous log ring
+ * was full (DROP_ASYNC_LOG_POLICY).
+ *
+ * @return number of dropped log lines since asynchronous logging started.
+ */
+extern unsigned long
+log_async_dropped(void) {
+    unsigned long result = 0;
+#ifdef USE_ASYNC_LOG
+    async_log_ring *ring;
+    pthread_mutex_lock(&async_control_lock);
+    ring = async_ring;
+    if (ring != NULL) {
+        result = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&async_control_lock);
+#endif /* USE_ASYNC_LOG */
+    return result;
+}
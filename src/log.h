@@ -15,7 +15,9 @@
  */
 
 /**
- * Simple logging module with log control to log statements on screen.
+ * Simple logging module with log control to log statements on screen, or
+ * to the configured log sinks, tagged with the context of the logging
+ * thread.
  */
 
 #ifndef LOG_H_
@@ -25,6 +27,9 @@
 extern "C" {
 #endif
 
+#include <stdarg.h>
+#include <stddef.h>
+
 /**
  * The log_level_e enumeration defines a set of standard logging levels
  * that can be used to control logging output.  The logging Level objects
@@ -39,6 +44,171 @@ typedef enum {
     ERROR_LOG_LEVEL
 } log_level_e;
 
+/**
+ * The log_async_policy_e enumeration defines what happens to a log line
+ * when the asynchronous log ring is full.
+ */
+typedef enum {
+    DROP_ASYNC_LOG_POLICY, /* discard the line (and count it) */
+    BLOCK_ASYNC_LOG_POLICY /* wait until the flush thread makes room */
+} log_async_policy_e;
+
+/**
+ * Kind of a log sink.
+ */
+typedef enum {
+    FD_LOG_SINK,       /* write lines to a file descriptor */
+    CALLBACK_LOG_SINK, /* pass lines to a callback */
+    MEMORY_LOG_SINK    /* keep the most recent lines in a memory ring */
+} log_sink_kind_e;
+
+/**
+ * Log sink callback, called on the logging thread (so log_context_get
+ * returns the context of the logging thread). A callback may add log
+ * sinks and remove its own sink, but must not remove the sink of another
+ * callback that may be removing its sink at the same time (both would
+ * wait for each other).
+ *
+ * @param log_level log level of the line.
+ * @param line the log line (new line terminated, not null terminated).
+ * @param len length of the line.
+ * @param arg argument provided along with the callback.
+ */
+typedef void (*log_sink_callback)(
+    log_level_e log_level,
+    const char *line,
+    size_t len,
+    void *arg);
+
+/* maximum number of log sinks */
+#define LOG_MAX_SINKS 8
+
+/* maximum number of context tags of a thread */
+#define LOG_CONTEXT_TAGS 4
+
+/**
+ * Lowest log level kept by the CLOG_* macros: calls below it are removed
+ * at compile time. Release builds can define it (e.g. with
+ * CPPFLAGS=-DCERIALIZER_MIN_LOG_LEVEL=WARNING_LOG_LEVEL) to drop all debug
+ * and info logging.
+ */
+#ifndef CERIALIZER_MIN_LOG_LEVEL
+#define CERIALIZER_MIN_LOG_LEVEL ALL_LOG_LEVELS
+#endif
+
+/**
+ * Lowest log level currently enabled (cached by set_log_level and the log
+ * sinks: the lowest of the log sinks while there are any), past the
+ * highest level while logging is off. Read by the CLOG_* macros.
+ */
+extern int log_level_threshold;
+
+#if defined(__GNUC__)
+#define LOG_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define LOG_LOAD_RELAXED(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#else
+#define LOG_UNLIKELY(x) (x)
+#define LOG_LOAD_RELAXED(x) (x)
+#endif
+
+/**
+ * Log levels with a rate limit or sampling configured (bit 1 << log level),
+ * see log_set_rate_limit and log_set_sampling. Read by the CLOG_* macros.
+ */
+extern int log_limited_levels;
+
+/**
+ * Log call site state used for rate limiting and sampling. Every CLOG_*
+ * call site holds its own, so that one noisy call site cannot silence the
+ * others.
+ */
+typedef struct _log_limit_site {
+    /* source file of the call site */
+    const char *file;
+    /* source line of the call site */
+    int line;
+    /* number of calls seen (for sampling) */
+    unsigned long calls;
+    /* theoretical arrival time of the next call (for rate limiting, ns) */
+    unsigned long long tat;
+    /* number of calls suppressed and not reported yet */
+    unsigned long suppressed;
+    /* time of the last suppressed calls report (ns) */
+    unsigned long long reported;
+    /* whether the call site is listed for log_report_suppressed */
+    int listed;
+    /* log level of the call site (once listed) */
+    int level;
+    /* next listed call site */
+    struct _log_limit_site *next;
+} log_limit_site;
+
+/* static initializer of the log call site state */
+#define LOG_LIMIT_SITE_INIT { __FILE__, __LINE__, 0, 0, 0, 0, 0, 0, NULL }
+
+/**
+ * Tests whether a call site with a rate limit or sampling configured for
+ * its log level may log, first reporting the number of calls it suppressed
+ * when due.
+ *
+ * CLOG_LIMIT_PASS(site, log_level)
+ */
+#define CLOG_LIMIT_PASS(site, log_level) \
+    (!(LOG_LOAD_RELAXED(log_limited_levels) & (1 << (log_level))) \
+        || log_limit_pass((site), (log_level)))
+
+/**
+ * Log a number of elements with the provided output format, unless the
+ * log level is removed at compile time or disabled, or the call site is
+ * rate limited or sampled out. Arguments are only evaluated when the call
+ * is actually logged.
+ *
+ * CLOG(log_level, format, ...)
+ */
+#define CLOG(log_level, ...) \
+    do { \
+        static log_limit_site clog_limit_site = LOG_LIMIT_SITE_INIT; \
+        if ((log_level) >= CERIALIZER_MIN_LOG_LEVEL \
+            && LOG_UNLIKELY((log_level) >= LOG_LOAD_RELAXED(log_level_threshold)) \
+            && CLOG_LIMIT_PASS(&clog_limit_site, (log_level))) { \
+            log_format((log_level), __VA_ARGS__); \
+        } \
+    } while (0)
+
+/* CLOG_DEBUG(format, ...) */
+#define CLOG_DEBUG(...) CLOG(DEBUG_LOG_LEVEL, __VA_ARGS__)
+
+/* CLOG_INFO(format, ...) */
+#define CLOG_INFO(...) CLOG(INFO_LOG_LEVEL, __VA_ARGS__)
+
+/* CLOG_WARN(format, ...) */
+#define CLOG_WARN(...) CLOG(WARNING_LOG_LEVEL, __VA_ARGS__)
+
+/* CLOG_ERROR(format, ...) */
+#define CLOG_ERROR(...) CLOG(ERROR_LOG_LEVEL, __VA_ARGS__)
+
+/**
+ * Get the text of a log level (e.g. "[ERROR]").
+ *
+ * @param log_level log level.
+ *
+ * @return text of the log level.
+ */
+extern const char *
+log_level_text(log_level_e log_level);
+
+/**
+ * Write a complete log record (e.g. a binary log record) to a file
+ * descriptor, through the asynchronous log ring when it is active and
+ * the record fits in a ring slot.
+ *
+ * @param fd file descriptor to write to.
+ * @param record the record.
+ * @param len length of the record.
+ */
+extern void
+log_write_record(int fd, const char *record, size_t len);
+
 /**
  * Log a message.
  *
@@ -71,6 +241,16 @@ log_function_message(
 extern void
 log_format(log_level_e log_level, const char *format, ...);
 
+/**
+ * Log a variable argument list with the provided output format.
+ *
+ * @param log_level log level to use.
+ * @param format the output format to use.
+ * @param args variable argument list to log.
+ */
+extern void
+log_vformat(log_level_e log_level, const char *format, va_list args);
+
 /**
  * Log a DEBUG message.
  *
@@ -176,13 +356,26 @@ extern void
 log_error_format(const char *format, ...);
 
 /**
- * Set the active log level.
+ * Set the active log level (safe to call while other threads log). It
+ * applies to stdout/stderr and binary logs, while each log sink has its
+ * own log level. OFF_LOG_LEVEL switches off all logging, log sinks included.
  *
  * @param log_level the value to set.
  */
 extern void
 set_log_level(log_level_e log_level);
 
+/**
+ * Tests whether the provided log level is enabled by the active log level
+ * (see set_log_level), regardless of the log levels of the log sinks.
+ *
+ * @param log_level_request requested log level.
+ *
+ * @return Non-zero if logging is enabled, zero otherwise.
+ */
+extern int
+log_level_enabled(log_level_e log_level_request);
+
 /**
  * Enables all log levels.
  */
@@ -195,6 +388,195 @@ enable_all_log_levels(void);
 extern void
 switch_off_all_log(void);
 
+/**
+ * Add a log sink writing log lines to a file descriptor (through the
+ * asynchronous log ring when it is active). Once a sink is added, log
+ * lines are no longer written to stdout/stderr but to the sinks.
+ *
+ * @param fd file descriptor to write to (not closed by the logger).
+ * @param log_level lowest log level written to the sink, regardless of the active
+ *        log level (see set_log_level).
+ *
+ * @return ID of the sink (positive), zero if there is no room for it.
+ */
+extern int
+log_add_fd_sink(int fd, log_level_e log_level);
+
+/**
+ * Add a log sink passing log lines to a callback.
+ *
+ * @param callback callback to call with every log line.
+ * @param arg argument to pass to the callback.
+ * @param log_level lowest log level passed to the sink, regardless of the active
+ *        log level (see set_log_level).
+ *
+ * @return ID of the sink (positive), zero if there is no room for it.
+ */
+extern int
+log_add_callback_sink(log_sink_callback callback, void *arg, log_level_e log_level);
+
+/**
+ * Add a log sink keeping the most recent log lines in a memory ring.
+ *
+ * @param capacity size of the ring (bytes).
+ * @param log_level lowest log level kept by the sink, regardless of the active
+ *        log level (see set_log_level).
+ *
+ * @return ID of the sink (positive), zero if there is no room for it.
+ */
+extern int
+log_add_memory_sink(size_t capacity, log_level_e log_level);
+
+/**
+ * Read the most recent (complete) log lines kept by a memory sink.
+ *
+ * @param sink ID of a memory sink.
+ * @param buffer buffer to copy the lines into (null terminated).
+ * @param size size of the buffer.
+ *
+ * @return length of the lines copied.
+ */
+extern size_t
+log_memory_sink_read(int sink, char *buffer, size_t size);
+
+/**
+ * Remove a log sink. Once the last sink is removed, log lines are written
+ * to stdout/stderr again. Waits for other threads still writing to the
+ * sink, so a callback is not called anymore once this returns (unless it
+ * is the calling thread's own callback removing its sink).
+ *
+ * @param sink ID of the sink.
+ */
+extern void
+log_remove_sink(int sink);
+
+/**
+ * Set a context tag of the calling thread (e.g. "worker" or "message"),
+ * prefixed to every log line the thread logs as "[key=value ...]".
+ *
+ * @param key key of the tag.
+ * @param value value of the tag (NULL to remove the tag).
+ *
+ * @return Non-zero if the tag was set, zero otherwise (too many tags, or
+ *         not supported).
+ */
+extern int
+log_context_set(const char *key, const char *value);
+
+/**
+ * Get a context tag of the calling thread.
+ *
+ * @param key key of the tag.
+ *
+ * @return value of the tag, NULL if not set.
+ */
+extern const char *
+log_context_get(const char *key);
+
+/**
+ * Remove all context tags of the calling thread.
+ */
+extern void
+log_context_clear(void);
+
+/**
+ * Limit the rate of every call site logging (through the CLOG_* macros) at
+ * the provided log level, with a token bucket: a call site may log bursts
+ * of up to `burst` calls, and `rate` calls per second on average. The
+ * number of calls suppressed is reported periodically by the call site
+ * (see log_set_suppressed_report_interval).
+ *
+ * @param log_level log level to limit.
+ * @param rate calls per second allowed per call site (zero for no limit).
+ * @param burst calls allowed in a burst (at least one).
+ */
+extern void
+log_set_rate_limit(log_level_e log_level, unsigned long rate, unsigned long burst);
+
+/**
+ * Sample every call site logging (through the CLOG_* macros) at the
+ * provided log level: only one in `every` calls of a call site is logged
+ * (before any rate limit applies). The number of calls suppressed is
+ * reported periodically by the call site.
+ *
+ * @param log_level log level to sample.
+ * @param every log one in `every` calls (zero or one for all calls).
+ */
+extern void
+log_set_sampling(log_level_e log_level, unsigned long every);
+
+/**
+ * Set how often a call site reports the number of calls it suppressed.
+ * The report is logged along with the next call the call site logs; calls
+ * suppressed by a call site that is not logging again are reported once
+ * the interval elapsed, by the next call logged or rate limited anywhere
+ * (or by the asynchronous flush thread, see log_async_start).
+ *
+ * @param ms minimum interval between two reports of a call site
+ *        (milliseconds, 1000 by default).
+ */
+extern void
+log_set_suppressed_report_interval(unsigned long ms);
+
+/**
+ * Report the number of calls suppressed by every call site and not
+ * reported yet, regardless of the report interval. Called automatically
+ * once the report interval elapsed (see log_set_suppressed_report_interval)
+ * and by log_async_flush and log_async_stop.
+ */
+extern void
+log_report_suppressed(void);
+
+/**
+ * Tests whether a rate limited or sampled call site may log, first
+ * reporting the number of calls it suppressed when due. Use the CLOG_*
+ * macros instead of calling this directly.
+ *
+ * @param site call site state (see LOG_LIMIT_SITE_INIT).
+ * @param log_level log level of the call site.
+ *
+ * @return Non-zero if the call may be logged, zero if it is suppressed.
+ */
+extern int
+log_limit_pass(log_limit_site *site, log_level_e log_level);
+
+/**
+ * Switch to asynchronous logging: log lines are formatted on the calling
+ * thread and pushed into a lock-free ring, while a background thread writes
+ * them out in batches.
+ *
+ * @param capacity number of log lines the ring can hold (rounded up to a
+ *        power of two).
+ * @param policy what to do when the ring is full.
+ *
+ * @return Non-zero if asynchronous logging was started, zero otherwise
+ *         (already started or not supported).
+ */
+extern int
+log_async_start(size_t capacity, log_async_policy_e policy);
+
+/**
+ * Wait until all log lines pushed so far have been written out.
+ */
+extern void
+log_async_flush(void);
+
+/**
+ * Switch back to synchronous logging, after writing out all pending
+ * log lines.
+ */
+extern void
+log_async_stop(void);
+
+/**
+ * Get the number of log lines dropped because the asynchronous log ring
+ * was full (DROP_ASYNC_LOG_POLICY).
+ *
+ * @return number of dropped log lines since asynchronous logging started.
+ */
+extern unsigned long
+log_async_dropped(void);
+
 #ifdef    __cplusplus
 }
 #endif
@@ -0,0 +1,779 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Binary structured logging. Records are encoded straight into a stack
+ * buffer in the serialized dynamic message format, so that logging costs
+ * a few stores and memcpy's plus the write (or the push into the
+ * asynchronous log ring), and no dynamic message is built.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "cerializer.h"
+#include "dynmessage.h"
+#include "stdlib_util.h"
+#include "log.h"
+#include "log_binary.h"
+
+#if defined(__GNUC__)
+#define LOG_LOAD_ACQUIRE(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define LOG_STORE_RELEASE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#else
+#define LOG_LOAD_ACQUIRE(p) (*(p))
+#define LOG_STORE_RELEASE(p, v) (*(p) = (v))
+#endif /* __GNUC__ */
+
+/* length of the stack buffer of a binary log record (longer records move to the heap) */
+#define LOG_BINARY_RECORD_LEN 1024
+
+/* fixed part of a serialized dynamic message and of a field */
+#define LOG_BINARY_MESSAGE_FIXED_LEN 16
+#define LOG_BINARY_FIELD_FIXED_LEN 16
+
+/* 'Dynamic Message Start' identifier */
+#define LOG_BINARY_MSG_START 1044266557
+
+/* names of the records */
+#define LOG_BINARY_RECORD_NAME "log"
+#define LOG_BINARY_FORMAT_NAME "logfmt"
+
+/**
+ * Kind of a format argument, i.e. how it is fetched from the variable
+ * argument list.
+ */
+typedef enum {
+    LOG_ARG_NONE,     /* no argument (%%) */
+    LOG_ARG_INT,      /* int */
+    LOG_ARG_SCHAR,    /* int, converted to signed char */
+    LOG_ARG_SHORT,    /* int, converted to short */
+    LOG_ARG_LONG,     /* long */
+    LOG_ARG_LLONG,    /* long long */
+    LOG_ARG_INTMAX,   /* intmax_t */
+    LOG_ARG_PTRDIFF,  /* ptrdiff_t */
+    LOG_ARG_UINT,     /* unsigned int */
+    LOG_ARG_UCHAR,    /* unsigned int, converted to unsigned char */
+    LOG_ARG_USHORT,   /* unsigned int, converted to unsigned short */
+    LOG_ARG_ULONG,    /* unsigned long */
+    LOG_ARG_ULLONG,   /* unsigned long long */
+    LOG_ARG_UINTMAX,  /* uintmax_t */
+    LOG_ARG_SIZE,     /* size_t */
+    LOG_ARG_DOUBLE,   /* double */
+    LOG_ARG_LDOUBLE,  /* long double */
+    LOG_ARG_STRING,   /* char * */
+    LOG_ARG_POINTER,  /* void * */
+    LOG_ARG_SKIP      /* pointer argument not recorded (%n) */
+} log_arg_kind;
+
+/**
+ * Conversion specification of a format string.
+ */
+typedef struct {
+    /* length of '%', flags, width and precision */
+    size_t prefix_len;
+    /* non-zero if width is given as an argument ('*') */
+    int width_arg;
+    /* non-zero if precision is given as an argument ('*') */
+    int precision_arg;
+    /* kind of the converted argument */
+    log_arg_kind kind;
+    /* conversion character */
+    char conversion;
+} log_conversion;
+
+/* names of the argument fields */
+static const char *LOG_ARG_NAMES[LOG_BINARY_MAX_ARGS] = {
+    "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7",
+    "a8", "a9", "a10", "a11", "a12", "a13", "a14", "a15" };
+
+/* binary log and dictionary file descriptors */
+static int log_fd = -1;
+static int dict_fd = -1;
+
+/* incremented by every log_binary_start */
+static unsigned int log_generation = 0;
+
+/* last assigned format ID */
+static unsigned int last_format_id = 0;
+
+/* serializes call site registration and dictionary writes */
+static pthread_mutex_t site_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Parse a conversion specification.
+ *
+ * @param p pointer to the '%' character.
+ * @param conversion parsed conversion specification.
+ *
+ * @return pointer past the conversion specification.
+ */
+static const char *
+log_parse_conversion(const char *p, log_conversion *conversion) {
+    const char *start = p++;
+    int length = 0; /* 'h' -1, 'hh' -2, 'l' 1, 'll' 2, 'j' 3, 'z' 4, 't' 5, 'L' 6 */
+    memset(conversion, 0, sizeof(log_conversion));
+    /* flags */
+    while (*p && strchr("-+ #0'", *p)) {
+        p++;
+    }
+    /* width */
+    if (*p == '*') {
+        conversion->width_arg = 1;
+        p++;
+    } else {
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    /* precision */
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            conversion->precision_arg = 1;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') {
+                p++;
+            }
+        }
+    }
+    conversion->prefix_len = (size_t)(p - start);
+    /* length modifier */
+    switch (*p) {
+    case 'h':
+        length = (p[1] == 'h') ? -2 : -1;
+        p += (p[1] == 'h') ? 2 : 1;
+        break;
+    case 'l':
+        length = (p[1] == 'l') ? 2 : 1;
+        p += (p[1] == 'l') ? 2 : 1;
+        break;
+    case 'q':
+        length = 2;
+        p++;
+        break;
+    case 'j':
+        length = 3;
+        p++;
+        break;
+    case 'z':
+        length = 4;
+        p++;
+        break;
+    case 't':
+        length = 5;
+        p++;
+        break;
+    case 'L':
+        length = 6;
+        p++;
+        break;
+    }
+    conversion->conversion = *p;
+    switch (*p) {
+    case 'd':
+    case 'i':
+        switch (length) {
+        case -2: conversion->kind = LOG_ARG_SCHAR; break;
+        case -1: conversion->kind = LOG_ARG_SHORT; break;
+        case 1: conversion->kind = LOG_ARG_LONG; break;
+        case 2: conversion->kind = LOG_ARG_LLONG; break;
+        case 3: conversion->kind = LOG_ARG_INTMAX; break;
+        case 4: conversion->kind = LOG_ARG_SIZE; break;
+        case 5: conversion->kind = LOG_ARG_PTRDIFF; break;
+        default: conversion->kind = LOG_ARG_INT; break;
+        }
+        break;
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+        switch (length) {
+        case -2: conversion->kind = LOG_ARG_UCHAR; break;
+        case -1: conversion->kind = LOG_ARG_USHORT; break;
+        case 1: conversion->kind = LOG_ARG_ULONG; break;
+        case 2: conversion->kind = LOG_ARG_ULLONG; break;
+        case 3: conversion->kind = LOG_ARG_UINTMAX; break;
+        case 4: conversion->kind = LOG_ARG_SIZE; break;
+        case 5: conversion->kind = LOG_ARG_PTRDIFF; break;
+        default: conversion->kind = LOG_ARG_UINT; break;
+        }
+        break;
+    case 'c':
+        /* int or wint_t, both promoted */
+        conversion->kind = (length == 1) ? LOG_ARG_UINT : LOG_ARG_INT;
+        break;
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'F':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        conversion->kind = (length == 6) ? LOG_ARG_LDOUBLE : LOG_ARG_DOUBLE;
+        break;
+    case 's':
+        /* wide strings are recorded by address */
+        conversion->kind = (length == 1) ? LOG_ARG_POINTER : LOG_ARG_STRING;
+        break;
+    case 'p':
+        conversion->kind = LOG_ARG_POINTER;
+        break;
+    case 'n':
+        conversion->kind = LOG_ARG_SKIP;
+        break;
+    case '\0':
+        /* dangling '%' */
+        conversion->kind = LOG_ARG_NONE;
+        return p;
+    default: /* '%' or unknown conversion */
+        conversion->kind = LOG_ARG_NONE;
+        break;
+    }
+    return p + 1;
+}
+
+/**
+ * Append a field header to a record.
+ *
+ * @param p position in the record.
+ * @param name name of the field.
+ * @param type type of the field.
+ * @param value_len length of the field value.
+ *
+ * @return position of the field value.
+ */
+static unsigned char *
+log_put_field_header(unsigned char *p, const char *name, dyn_field_type type, size_t value_len) {
+    size_t name_len = strlen(name);
+    serialize_int32(p, LOG_BINARY_FIELD_FIXED_LEN + name_len + value_len);
+    serialize_int32(p + 4, name_len);
+    memcpy(p + 8, name, name_len);
+    p += 8 + name_len;
+    serialize_int32(p, type);
+    serialize_int32(p + 4, value_len);
+    return p + 8;
+}
+
+/**
+ * Start a record: write the dynamic message header, leaving total length
+ * and number of fields to log_end_record.
+ *
+ * @param record start of the record.
+ * @param name name of the record.
+ *
+ * @return position of the first field.
+ */
+static unsigned char *
+log_begin_record(unsigned char *record, const char *name) {
+    size_t name_len = strlen(name);
+    serialize_int32(record, LOG_BINARY_MSG_START);
+    serialize_int32(record + 8, name_len);
+    memcpy(record + 12, name, name_len);
+    return record + 16 + name_len;
+}
+
+/**
+ * Complete a record started with log_begin_record.
+ *
+ * @param record start of the record.
+ * @param end end of the record.
+ * @param name name of the record.
+ * @param field_count number of fields.
+ *
+ * @return length of the record.
+ */
+static size_t
+log_end_record(unsigned char *record, unsigned char *end, const char *name, int field_count) {
+    size_t len = (size_t)(end - record);
+    serialize_int32(record + 4, len);
+    serialize_int32(record + 12 + strlen(name), field_count);
+    return len;
+}
+
+/**
+ * Make room for the next bytes of a record, moving the record from the
+ * stack buffer it started in to the heap once it outgrows that buffer.
+ *
+ * @param record start of the record (updated when moved).
+ * @param end end of the record buffer (updated when moved).
+ * @param stack stack buffer the record started in.
+ * @param p position in the record.
+ * @param need number of bytes needed at the position.
+ *
+ * @return position in the (possibly moved) record.
+ */
+static unsigned char *
+log_reserve_record(
+    unsigned char **record,
+    unsigned char **end,
+    unsigned char *stack,
+    unsigned char *p,
+    size_t need) {
+
+    size_t used = (size_t)(p - *record);
+    size_t size = (size_t)(*end - *record);
+    unsigned char *moved;
+    if (need <= size - used) {
+        return p;
+    }
+    while (size - used < need) {
+        size *= 2;
+    }
+    if (*record == stack) {
+        moved = (unsigned char *)SAFE_MALLOC(size);
+        memcpy(moved, stack, used);
+    } else {
+        moved = (unsigned char *)SAFE_REALLOC(*record, size);
+    }
+    *record = moved;
+    *end = moved + size;
+    return moved + used;
+}
+
+/**
+ * Register a call site with the open binary log: parse its format (on
+ * first use) and write the format to the dictionary.
+ *
+ * @param site call site.
+ * @param format format of the call site.
+ */
+static void
+log_binary_register(log_binary_site *site, const char *format) {
+    pthread_mutex_lock(&site_lock);
+    if (site->generation != log_generation) {
+        unsigned char *record;
+        unsigned char *p;
+        size_t format_len = strlen(format);
+        size_t len;
+        if (site->id == 0) {
+            const char *it = format;
+            site->argc = 0;
+            while ((it = strchr(it, '%')) != NULL) {
+                log_conversion conversion;
+                it = log_parse_conversion(it, &conversion);
+                if (conversion.width_arg && site->argc < LOG_BINARY_MAX_ARGS) {
+                    site->argk[site->argc++] = LOG_ARG_INT;
+                }
+                if (conversion.precision_arg && site->argc < LOG_BINARY_MAX_ARGS) {
+                    site->argk[site->argc++] = LOG_ARG_INT;
+                }
+                if (conversion.kind != LOG_ARG_NONE && site->argc < LOG_BINARY_MAX_ARGS) {
+                    site->argk[site->argc++] = conversion.kind;
+                }
+            }
+            site->id = ++last_format_id;
+        }
+        /* dictionary entry */
+        record = (unsigned char *)SAFE_MALLOC(
+            LOG_BINARY_MESSAGE_FIXED_LEN + sizeof(LOG_BINARY_FORMAT_NAME)
+            + 2 * LOG_BINARY_FIELD_FIXED_LEN + 16 + format_len);
+        p = log_begin_record(record, LOG_BINARY_FORMAT_NAME);
+        p = log_put_field_header(p, "fmt", UNSIGNED_INT32_TYPE, 4);
+        serialize_int32(p, site->id);
+        p += 4;
+        p = log_put_field_header(p, "format", STRING_TYPE, format_len);
+        memcpy(p, format, format_len);
+        p += format_len;
+        len = log_end_record(record, p, LOG_BINARY_FORMAT_NAME, 2);
+        if (write(dict_fd, record, len) != (ssize_t)len) {
+            log_error_message("log_binary: cannot write format dictionary");
+        }
+        SAFE_FREE(record);
+        LOG_STORE_RELEASE(&site->generation, log_generation);
+    }
+    pthread_mutex_unlock(&site_lock);
+}
+
+/**
+ * Open a binary log (and its format dictionary), truncating both files.
+ * Binary logging must not be started or stopped while other threads log.
+ *
+ * @param log_path path of the binary log file.
+ * @param dict_path path of the format dictionary file.
+ *
+ * @return Non-zero if the binary log was opened, zero otherwise.
+ */
+extern int
+log_binary_start(const char *log_path, const char *dict_path) {
+    int result = 0;
+    log_binary_stop();
+    if (log_path != NULL && dict_path != NULL) {
+        int fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if (fd >= 0) {
+            dict_fd = open(dict_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+            if (dict_fd >= 0) {
+                pthread_mutex_lock(&site_lock);
+                log_generation++;
+                pthread_mutex_unlock(&site_lock);
+                LOG_STORE_RELEASE(&log_fd, fd);
+                result++;
+            } else {
+                close(fd);
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * Close the binary log (pending asynchronous records are flushed first).
+ */
+extern void
+log_binary_stop(void) {
+    int fd = LOG_LOAD_ACQUIRE(&log_fd);
+    if (fd >= 0) {
+        LOG_STORE_RELEASE(&log_fd, -1);
+        log_async_flush();
+        close(fd);
+        close(dict_fd);
+        dict_fd = -1;
+    }
+}
+
+/**
+ * Log a number of elements with the provided output format as a binary
+ * record. Use the CLOG_BIN macro instead of calling this directly.
+ *
+ * @param site call site (zero initialized before first use).
+ * @param log_level log level to use.
+ * @param func_name the name of the logging function.
+ * @param format the output format to use (the same on every call of a site).
+ * @param ... elements to log.
+ */
+extern void
+log_binary(
+    log_binary_site *site,
+    log_level_e log_level,
+    const char *func_name,
+    const char *format, ...) {
+
+    unsigned char buffer[LOG_BINARY_RECORD_LEN];
+    unsigned char *record = buffer;
+    unsigned char *p;
+    unsigned char *end = buffer + LOG_BINARY_RECORD_LEN;
+    struct timespec now;
+    size_t func_len = strlen(func_name);
+    int fd = LOG_LOAD_ACQUIRE(&log_fd);
+    int field_count = 4;
+    int i;
+    va_list args;
+
+    va_start(args, format);
+    if (fd < 0) {
+        /* no binary log, fall back to text */
+        log_vformat(log_level, format, args);
+        va_end(args);
+        return;
+    }
+    if (!log_level_enabled(log_level)) {
+        /* enabled for the log sinks only */
+        va_end(args);
+        return;
+    }
+    if (LOG_LOAD_ACQUIRE(&site->generation) != log_generation) {
+        log_binary_register(site, format);
+    }
+#ifdef CLOCK_REALTIME_COARSE
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+#else
+    clock_gettime(CLOCK_REALTIME, &now);
+#endif /* CLOCK_REALTIME_COARSE */
+    /* fixed fields */
+    p = log_begin_record(record, LOG_BINARY_RECORD_NAME);
+    p = log_reserve_record(&record, &end, buffer, p, 4 * LOG_BINARY_FIELD_FIXED_LEN + 32 + func_len);
+    p = log_put_field_header(p, "ts", UNSIGNED_INT64_TYPE, 8);
+    serialize_int64(p, (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec);
+    p += 8;
+    p = log_put_field_header(p, "level", UNSIGNED_INT8_TYPE, 1);
+    *p++ = (unsigned char)log_level;
+    p = log_put_field_header(p, "func", STRING_TYPE, func_len);
+    memcpy(p, func_name, func_len);
+    p += func_len;
+    p = log_put_field_header(p, "fmt", UNSIGNED_INT32_TYPE, 4);
+    serialize_int32(p, site->id);
+    p += 4;
+    /* arguments */
+    for (i = 0; i < site->argc; i++) {
+        const char *name = LOG_ARG_NAMES[field_count - 4];
+        size_t len = 8;
+        long long sval = 0;
+        unsigned long long uval = 0;
+        double dval = 0;
+        const char *str = NULL;
+        dyn_field_type type = INT64_TYPE;
+        switch (site->argk[i]) {
+        case LOG_ARG_INT: sval = va_arg(args, int); break;
+        case LOG_ARG_SCHAR: sval = (signed char)va_arg(args, int); break;
+        case LOG_ARG_SHORT: sval = (short)va_arg(args, int); break;
+        case LOG_ARG_LONG: sval = va_arg(args, long); break;
+        case LOG_ARG_LLONG: sval = va_arg(args, long long); break;
+        case LOG_ARG_INTMAX: sval = (long long)va_arg(args, intmax_t); break;
+        case LOG_ARG_PTRDIFF: sval = (long long)va_arg(args, ptrdiff_t); break;
+        case LOG_ARG_UINT: type = UNSIGNED_INT64_TYPE; uval = va_arg(args, unsigned int); break;
+        case LOG_ARG_UCHAR: type = UNSIGNED_INT64_TYPE; uval = (unsigned char)va_arg(args, unsigned int); break;
+        case LOG_ARG_USHORT: type = UNSIGNED_INT64_TYPE; uval = (unsigned short)va_arg(args, unsigned int); break;
+        case LOG_ARG_ULONG: type = UNSIGNED_INT64_TYPE; uval = va_arg(args, unsigned long); break;
+        case LOG_ARG_ULLONG: type = UNSIGNED_INT64_TYPE; uval = va_arg(args, unsigned long long); break;
+        case LOG_ARG_UINTMAX: type = UNSIGNED_INT64_TYPE; uval = (unsigned long long)va_arg(args, uintmax_t); break;
+        case LOG_ARG_SIZE: type = UNSIGNED_INT64_TYPE; uval = (unsigned long long)va_arg(args, size_t); break;
+        case LOG_ARG_DOUBLE: type = FLOAT64_TYPE; dval = va_arg(args, double); break;
+        case LOG_ARG_LDOUBLE: type = FLOAT64_TYPE; dval = (double)va_arg(args, long double); break;
+        case LOG_ARG_STRING:
+            type = STRING_TYPE;
+            str = va_arg(args, const char *);
+            if (str == NULL) {
+                str = "(null)";
+            }
+            break;
+        case LOG_ARG_POINTER:
+            type = UNSIGNED_INT64_TYPE;
+            uval = (unsigned long long)(uintptr_t)va_arg(args, void *);
+            break;
+        case LOG_ARG_SKIP:
+            (void)va_arg(args, void *);
+            continue;
+        }
+        if (type == STRING_TYPE) {
+            len = strlen(str);
+        }
+        p = log_reserve_record(&record, &end, buffer, p, LOG_BINARY_FIELD_FIXED_LEN + strlen(name) + len);
+        if (type == STRING_TYPE) {
+            p = log_put_field_header(p, name, STRING_TYPE, len);
+            memcpy(p, str, len);
+            p += len;
+        } else {
+            p = log_put_field_header(p, name, type, 8);
+            if (type == FLOAT64_TYPE) {
+                serialize_float64(p, dval);
+            } else if (type == INT64_TYPE) {
+                serialize_int64(p, (unsigned long long)sval);
+            } else {
+                serialize_int64(p, uval);
+            }
+            p += 8;
+        }
+        field_count++;
+    }
+    va_end(args);
+    log_write_record(fd, (const char *)record,
+        log_end_record(record, p, LOG_BINARY_RECORD_NAME, field_count));
+    if (record != buffer) {
+        SAFE_FREE(record);
+    }
+}
+
+/**
+ * Append formatted text to a buffer, truncating it if needed.
+ *
+ * @param buffer buffer to append to.
+ * @param size size of the buffer.
+ * @param pos current length of the text in the buffer (updated).
+ * @param format the output format to use.
+ * @param ... elements to append.
+ */
+static void
+log_append(char *buffer, size_t size, size_t *pos, const char *format, ...) {
+    if (*pos + 1 < size) {
+        int n;
+        va_list args;
+        va_start(args, format);
+        n = vsnprintf(buffer + *pos, size - *pos, format, args);
+        va_end(args);
+        if (n > 0) {
+            *pos += ((size_t)n < size - *pos) ? (size_t)n : size - *pos - 1;
+        }
+    }
+}
+
+/**
+ * Get an argument field of a record.
+ *
+ * @param record de-serialized "log" record.
+ * @param index index of the argument.
+ * @param field field to fill (type NO_TYPE if missing).
+ */
+static void
+log_get_arg(dynamicmessage *record, int index, dyn_field *field) {
+    field->type = NO_TYPE;
+    field->value = NULL;
+    if (index < LOG_BINARY_MAX_ARGS) {
+        dynmessage_get_field(record, (char *)LOG_ARG_NAMES[index], field);
+    }
+}
+
+/**
+ * Get an integer argument field of a record (used for '*' width and
+ * precision).
+ *
+ * @param record de-serialized "log" record.
+ * @param index index of the argument.
+ *
+ * @return value of the argument (zero if missing).
+ */
+static long long
+log_get_int_arg(dynamicmessage *record, int index) {
+    dyn_field field;
+    log_get_arg(record, index, &field);
+    if (field.type == INT64_TYPE) {
+        return field.value->int64_value;
+    } else if (field.type == UNSIGNED_INT64_TYPE) {
+        return (long long)field.value->uint64_value;
+    }
+    return 0;
+}
+
+/**
+ * Render a binary log record as a text log line (without new line).
+ *
+ * @param record de-serialized "log" record.
+ * @param format format string of the record format ID.
+ * @param buffer buffer to render into.
+ * @param size size of the buffer.
+ *
+ * @return length of the rendered line (truncated to size - 1).
+ */
+extern size_t
+log_binary_render(
+    dynamicmessage *record,
+    const char *format,
+    char *buffer,
+    size_t size) {
+
+    size_t pos = 0;
+    int arg = 0;
+    dyn_field field;
+    const char *it = format;
+
+    if (buffer == NULL || size == 0) {
+        return 0;
+    }
+    buffer[0] = '\0';
+    /* timestamp */
+    dynmessage_get_field(record, "ts", &field);
+    if (field.type == UNSIGNED_INT64_TYPE) {
+        unsigned long long ts = field.value->uint64_value;
+        time_t sec = (time_t)(ts / 1000000000ULL);
+        struct tm tm;
+        char text[32];
+        localtime_r(&sec, &tm);
+        if (strftime(text, sizeof(text), "%a %b %e %H:%M:%S", &tm) == 0) {
+            /* locale names too long, contents unspecified */
+            text[0] = '\0';
+        }
+        log_append(buffer, size, &pos, "%s.%03u", text,
+            (unsigned int)((ts % 1000000000ULL) / 1000000ULL));
+    }
+    /* level and function */
+    dynmessage_get_field(record, "level", &field);
+    log_append(buffer, size, &pos, " - %s:",
+        log_level_text(field.type == UNSIGNED_INT8_TYPE ? field.value->uint8_value : -1));
+    dynmessage_get_field(record, "func", &field);
+    if (field.type == STRING_TYPE) {
+        log_append(buffer, size, &pos, "%s:", field.value->string_value);
+    }
+    /* formatted elements */
+    while (it != NULL && *it) {
+        const char *percent = strchr(it, '%');
+        log_conversion conversion;
+        char spec[64];
+        size_t spec_len = 0;
+        size_t k;
+        if (percent == NULL) {
+            log_append(buffer, size, &pos, "%s", it);
+            break;
+        }
+        log_append(buffer, size, &pos, "%.*s", (int)(percent - it), it);
+        it = log_parse_conversion(percent, &conversion);
+        if (conversion.kind == LOG_ARG_NONE) {
+            if (conversion.conversion == '%') {
+                log_append(buffer, size, &pos, "%%");
+            }
+            continue;
+        }
+        /* rebuild the specification with '*' replaced by recorded values */
+        for (k = 0; k < conversion.prefix_len && spec_len < sizeof(spec) - 32; k++) {
+            if (percent[k] == '*') {
+                long long value = log_get_int_arg(record, arg++);
+                if (k > 0 && percent[k - 1] == '.' && value < 0) {
+                    spec_len--; /* negative precision: as if omitted */
+                } else {
+                    spec_len += (size_t)snprintf(spec + spec_len, sizeof(spec) - spec_len, "%lld", value);
+                }
+            } else {
+                spec[spec_len++] = percent[k];
+            }
+        }
+        spec[spec_len] = '\0';
+        if (conversion.kind == LOG_ARG_SKIP) {
+            continue;
+        }
+        log_get_arg(record, arg++, &field);
+        switch (field.type) {
+        case INT64_TYPE:
+            if (conversion.conversion == 'c') {
+                strcat(spec, "c");
+                log_append(buffer, size, &pos, spec, (int)field.value->int64_value);
+            } else {
+                spec[spec_len++] = 'l';
+                spec[spec_len++] = 'l';
+                spec[spec_len++] = conversion.conversion;
+                spec[spec_len] = '\0';
+                log_append(buffer, size, &pos, spec, field.value->int64_value);
+            }
+            break;
+        case UNSIGNED_INT64_TYPE:
+            if (conversion.kind == LOG_ARG_POINTER) {
+                strcat(spec, "p");
+                log_append(buffer, size, &pos, spec,
+                    (void *)(uintptr_t)field.value->uint64_value);
+            } else if (conversion.conversion == 'c') {
+                strcat(spec, "c");
+                log_append(buffer, size, &pos, spec, (int)field.value->uint64_value);
+            } else {
+                spec[spec_len++] = 'l';
+                spec[spec_len++] = 'l';
+                spec[spec_len++] = conversion.conversion;
+                spec[spec_len] = '\0';
+                log_append(buffer, size, &pos, spec, field.value->uint64_value);
+            }
+            break;
+        case FLOAT64_TYPE:
+            spec[spec_len++] = conversion.conversion;
+            spec[spec_len] = '\0';
+            log_append(buffer, size, &pos, spec, field.value->float64_value);
+            break;
+        case STRING_TYPE:
+            strcat(spec, "s");
+            log_append(buffer, size, &pos, spec, field.value->string_value);
+            break;
+        default:
+            /* argument was not recorded */
+            log_append(buffer, size, &pos, "?");
+            break;
+        }
+    }
+    return pos;
+}
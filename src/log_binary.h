@@ -0,0 +1,140 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Binary structured logging. Every log call writes a compact record,
+ * encoded as a serialized dynamic message named "log", with the fields
+ *
+ *  ts      UNSIGNED_INT64_TYPE  nanoseconds since the epoch
+ *  level   UNSIGNED_INT8_TYPE   log level
+ *  func    STRING_TYPE          name of the logging function
+ *  fmt     UNSIGNED_INT32_TYPE  format ID
+ *  a0..aN  INT64_TYPE, UNSIGNED_INT64_TYPE, FLOAT64_TYPE or STRING_TYPE
+ *                               arguments of the format
+ *
+ * The format strings are written once per format ID into a separate
+ * dictionary file, as dynamic messages named "logfmt" with the fields
+ * fmt (UNSIGNED_INT32_TYPE) and format (STRING_TYPE). The cerializerlog
+ * tool renders both files back into text log lines.
+ */
+
+#ifndef LOG_BINARY_H_
+#define LOG_BINARY_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "dynmessage.h"
+#include "log.h"
+
+/* maximum number of format arguments recorded (extra ones are dropped) */
+#define LOG_BINARY_MAX_ARGS 16
+
+/**
+ * Binary log call site: the format of a call site is parsed and written
+ * to the dictionary once, on first use.
+ */
+typedef struct {
+    /* format ID (zero until first use) */
+    unsigned int id;
+    /* binary log the format was last written to the dictionary of */
+    unsigned int generation;
+    /* number of recorded format arguments */
+    int argc;
+    /* kind of each recorded format argument */
+    unsigned char argk[LOG_BINARY_MAX_ARGS];
+} log_binary_site;
+
+/**
+ * Log a number of elements with the provided output format as a binary
+ * record, unless the log level is removed at compile time or disabled,
+ * or the call site is rate limited or sampled out (see CLOG). Arguments
+ * are only evaluated when the call is actually logged. While no
+ * binary log is open, the elements are logged as text.
+ *
+ * CLOG_BIN(log_level, format, ...)
+ */
+#define CLOG_BIN(log_level, ...) \
+    do { \
+        static log_binary_site clog_bin_site; \
+        static log_limit_site clog_limit_site = LOG_LIMIT_SITE_INIT; \
+        if ((log_level) >= CERIALIZER_MIN_LOG_LEVEL \
+            && LOG_UNLIKELY((log_level) >= LOG_LOAD_RELAXED(log_level_threshold)) \
+            && CLOG_LIMIT_PASS(&clog_limit_site, (log_level))) { \
+            log_binary(&clog_bin_site, (log_level), __func__, __VA_ARGS__); \
+        } \
+    } while (0)
+
+/**
+ * Open a binary log (and its format dictionary), truncating both files.
+ * Binary logging must not be started or stopped while other threads log.
+ *
+ * @param log_path path of the binary log file.
+ * @param dict_path path of the format dictionary file.
+ *
+ * @return Non-zero if the binary log was opened, zero otherwise.
+ */
+extern int
+log_binary_start(const char *log_path, const char *dict_path);
+
+/**
+ * Close the binary log (pending asynchronous records are flushed first).
+ */
+extern void
+log_binary_stop(void);
+
+/**
+ * Log a number of elements with the provided output format as a binary
+ * record. Use the CLOG_BIN macro instead of calling this directly.
+ *
+ * @param site call site (zero initialized before first use).
+ * @param log_level log level to use.
+ * @param func_name the name of the logging function.
+ * @param format the output format to use (the same on every call of a site).
+ * @param ... elements to log.
+ */
+extern void
+log_binary(
+    log_binary_site *site,
+    log_level_e log_level,
+    const char *func_name,
+    const char *format, ...);
+
+/**
+ * Render a binary log record as a text log line (without new line).
+ *
+ * @param record de-serialized "log" record.
+ * @param format format string of the record format ID.
+ * @param buffer buffer to render into.
+ * @param size size of the buffer.
+ *
+ * @return length of the rendered line (truncated to size - 1).
+ */
+extern size_t
+log_binary_render(
+    dynamicmessage *record,
+    const char *format,
+    char *buffer,
+    size_t size);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* LOG_BINARY_H_ */
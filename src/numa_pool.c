@@ -0,0 +1,501 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * NUMA-aware pool allocator. Small blocks are carved out of per-node
+ * memory regions (bound with `mbind`, using raw system calls so libnuma
+ * is not required), allocations are served from the node of the calling
+ * thread, and blocks freed by a thread of another node are batched back
+ * to their owning node. Larger blocks, and all blocks on systems
+ * without NUMA support, use the standard library allocator.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__) && defined(__GNUC__)
+#define USE_NUMA_POOL
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "numa_pool.h"
+
+#ifdef USE_NUMA_POOL
+
+/* memory policies and get_mempolicy flags (see linux/mempolicy.h) */
+#define NUMA_MPOL_PREFERRED 1
+#define NUMA_MPOL_F_MEMS_ALLOWED 4
+
+/* number of size classes (16 bytes up to CERIALIZER_NUMA_MAX_SIZE) */
+#define NUMA_CLASSES 7
+
+/* smallest size class */
+#define NUMA_MIN_SIZE 16
+
+/* size of a slab carved into blocks of one size class */
+#define NUMA_SLAB_SIZE 65536
+
+/* address space reserved per node (pages are only backed once touched) */
+#define NUMA_REGION_SIZE ((size_t)1 << (sizeof(void *) == 8 ? 32 : 26))
+
+/* number of slabs in a node region */
+#define NUMA_REGION_SLABS (NUMA_REGION_SIZE / NUMA_SLAB_SIZE)
+
+/* number of blocks a thread caches per size class */
+#define NUMA_MAGAZINE_SIZE 64
+
+/* number of remote frees returned to their owning node at once */
+#define NUMA_REMOTE_BATCH 32
+
+/* bits of a node mask word */
+#define NUMA_MASK_BITS (8 * sizeof(unsigned long))
+
+/* Free block of a size class, linked in the node depot. */
+typedef struct _numa_block_struct {
+    struct _numa_block_struct *next;
+} numa_block;
+
+/* Structure to hold the pool of a node. */
+typedef struct _numa_node_pool_struct {
+    pthread_mutex_t lock; /* protects all members */
+    char *region; /* start of the node region */
+    size_t slabs; /* slabs carved out of the region */
+    unsigned char *slab_classes; /* size class of every carved slab */
+    numa_block *free_list[NUMA_CLASSES]; /* depot of free blocks */
+    char *cursor[NUMA_CLASSES]; /* next uncarved block of the current slab */
+    char *end[NUMA_CLASSES]; /* end of the current slab */
+    size_t remote_frees; /* blocks returned by threads of other nodes */
+    size_t remote_batches; /* batches of returned blocks */
+} numa_node_pool;
+
+/* Structure to hold blocks a thread caches for a size class. */
+typedef struct _numa_magazine_struct {
+    int node; /* node owning the cached blocks (-1 if none) */
+    size_t count; /* number of cached blocks */
+    void *blocks[NUMA_MAGAZINE_SIZE]; /* cached blocks */
+} numa_magazine;
+
+/* Structure to hold the pool state of a thread. */
+typedef struct _numa_thread_cache_struct {
+    int node; /* node the thread runs on (-1 before first use) */
+    numa_magazine local[NUMA_CLASSES]; /* blocks of the thread node */
+    numa_magazine remote[NUMA_CLASSES]; /* blocks freed for another node */
+} numa_thread_cache;
+
+/* pools of all nodes, in a single address space reservation */
+static numa_node_pool numa_pools[CERIALIZER_NUMA_MAX_NODES];
+static char *numa_region_base = NULL;
+static int numa_nodes = 1;
+static pthread_once_t numa_once = PTHREAD_ONCE_INIT;
+
+/* key used to return the cached blocks of exiting threads */
+static pthread_key_t numa_key;
+
+/* pool state of the current thread */
+static __thread numa_thread_cache numa_cache = { -1 };
+
+/**
+ * Get the NUMA node the calling thread runs on.
+ *
+ * @return the node identifier (0 if unknown).
+ */
+static int
+numa_current_node(void) {
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0 || (int)node >= numa_nodes) {
+        node = 0;
+    }
+    return (int)node;
+}
+
+/**
+ * Release the cached blocks of an exiting thread.
+ *
+ * @param data thread cache of the exiting thread.
+ */
+static void numa_thread_exit(void *data);
+
+/**
+ * Initialize the node pools: discover the allowed nodes, reserve the
+ * node regions and bind each region to its node.
+ */
+static void
+numa_init(void) {
+    unsigned long mask[CERIALIZER_NUMA_MAX_NODES / NUMA_MASK_BITS + 1];
+    int max_node = 0;
+    int i;
+    void *base;
+
+    memset(mask, 0, sizeof(mask));
+    if (syscall(SYS_get_mempolicy, NULL, mask, (unsigned long)CERIALIZER_NUMA_MAX_NODES + 1,
+            NULL, NUMA_MPOL_F_MEMS_ALLOWED) == 0) {
+        for (i = 0; i < CERIALIZER_NUMA_MAX_NODES; i++) {
+            if (mask[i / NUMA_MASK_BITS] & (1UL << (i % NUMA_MASK_BITS))) {
+                max_node = i;
+            }
+        }
+    } else {
+        /* no NUMA support in the kernel, a single node */
+        mask[0] = 1;
+    }
+
+    base = mmap(NULL, (max_node + 1) * NUMA_REGION_SIZE, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        return; /* all blocks will come from the standard library allocator */
+    }
+    for (i = 0; i <= max_node; i++) {
+        numa_node_pool *pool = &numa_pools[i];
+        pthread_mutex_init(&pool->lock, NULL);
+        pool->region = (char *)base + i * NUMA_REGION_SIZE;
+        pool->slab_classes = (unsigned char *)calloc(NUMA_REGION_SLABS, 1);
+        if (max_node > 0 && (mask[i / NUMA_MASK_BITS] & (1UL << (i % NUMA_MASK_BITS)))) {
+            unsigned long node_mask[CERIALIZER_NUMA_MAX_NODES / NUMA_MASK_BITS + 1];
+            memset(node_mask, 0, sizeof(node_mask));
+            node_mask[i / NUMA_MASK_BITS] = 1UL << (i % NUMA_MASK_BITS);
+            /* preferred rather than bound, so a full node falls back */
+            syscall(SYS_mbind, pool->region, NUMA_REGION_SIZE, NUMA_MPOL_PREFERRED,
+                node_mask, (unsigned long)CERIALIZER_NUMA_MAX_NODES + 1, 0);
+        }
+    }
+    pthread_key_create(&numa_key, numa_thread_exit);
+    numa_nodes = max_node + 1;
+    numa_region_base = (char *)base;
+}
+
+/**
+ * Get the size class serving the provided size.
+ *
+ * @param size block size (not greater than CERIALIZER_NUMA_MAX_SIZE).
+ *
+ * @return index of the size class.
+ */
+static int
+numa_class_index(size_t size) {
+    int index = 0;
+    size_t block_size = NUMA_MIN_SIZE;
+    while (block_size < size) {
+        block_size <<= 1;
+        index++;
+    }
+    return index;
+}
+
+/**
+ * Get the node and size class of a pool block.
+ *
+ * @param ptr pointer to test.
+ * @param class_index where to store the size class of the block.
+ *
+ * @return the node owning the block, -1 if ptr is not a pool block.
+ */
+static int
+numa_block_owner(void *ptr, int *class_index) {
+    uintptr_t offset;
+    int node;
+    if (numa_region_base == NULL || (char *)ptr < numa_region_base) {
+        return -1;
+    }
+    offset = (char *)ptr - numa_region_base;
+    if (offset >= numa_nodes * NUMA_REGION_SIZE) {
+        return -1;
+    }
+    node = (int)(offset / NUMA_REGION_SIZE);
+    *class_index = numa_pools[node].slab_classes[(offset % NUMA_REGION_SIZE) / NUMA_SLAB_SIZE];
+    return node;
+}
+
+/**
+ * Fill half of an empty magazine from a node pool, carving new slabs
+ * as needed.
+ *
+ * @param node the node to allocate from.
+ * @param index index of the size class.
+ * @param magazine the magazine to fill.
+ */
+static void
+numa_refill(int node, int index, numa_magazine *magazine) {
+    numa_node_pool *pool = &numa_pools[node];
+    size_t block_size = (size_t)NUMA_MIN_SIZE << index;
+
+    pthread_mutex_lock(&pool->lock);
+    while (magazine->count < NUMA_MAGAZINE_SIZE / 2) {
+        if (pool->free_list[index] != NULL) {
+            numa_block *block = pool->free_list[index];
+            pool->free_list[index] = block->next;
+            magazine->blocks[magazine->count++] = block;
+        } else {
+            if (pool->cursor[index] == pool->end[index]) {
+                char *slab;
+                if (pool->slab_classes == NULL || pool->slabs == NUMA_REGION_SLABS) {
+                    break; /* region exhausted */
+                }
+                slab = pool->region + pool->slabs * NUMA_SLAB_SIZE;
+                pool->slab_classes[pool->slabs++] = (unsigned char)index;
+                pool->cursor[index] = slab;
+                pool->end[index] = slab + NUMA_SLAB_SIZE;
+            }
+            magazine->blocks[magazine->count++] = pool->cursor[index];
+            pool->cursor[index] += block_size;
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    magazine->node = node;
+}
+
+/**
+ * Return cached blocks to their node pool, keeping the provided number.
+ *
+ * @param index index of the size class.
+ * @param magazine the magazine to drain.
+ * @param keep number of blocks to keep.
+ * @param remote non-zero if the blocks were freed by another node.
+ */
+static void
+numa_flush(int index, numa_magazine *magazine, size_t keep, int remote) {
+    numa_node_pool *pool;
+    if (magazine->count <= keep) {
+        return;
+    }
+    pool = &numa_pools[magazine->node];
+    pthread_mutex_lock(&pool->lock);
+    if (remote) {
+        pool->remote_frees += magazine->count - keep;
+        pool->remote_batches++;
+    }
+    while (magazine->count > keep) {
+        numa_block *block = (numa_block *)magazine->blocks[--magazine->count];
+        block->next = pool->free_list[index];
+        pool->free_list[index] = block;
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Release the cached blocks of an exiting thread.
+ *
+ * @param data thread cache of the exiting thread.
+ */
+static void
+numa_thread_exit(void *data) {
+    numa_thread_cache *cache = (numa_thread_cache *)data;
+    int i;
+    for (i = 0; i < NUMA_CLASSES; i++) {
+        numa_flush(i, &cache->local[i], 0, 0);
+        numa_flush(i, &cache->remote[i], 0, 1);
+    }
+}
+
+/**
+ * Get the pool state of the current thread, initializing it on first use.
+ *
+ * @return the thread cache of the current thread.
+ */
+static numa_thread_cache *
+numa_get_thread_cache(void) {
+    numa_thread_cache *cache = &numa_cache;
+    if (__builtin_expect(cache->node < 0, 0)) {
+        int i;
+        pthread_once(&numa_once, numa_init);
+        cache->node = numa_current_node();
+        for (i = 0; i < NUMA_CLASSES; i++) {
+            cache->local[i].node = cache->node;
+            cache->local[i].count = 0;
+            cache->remote[i].node = -1;
+            cache->remote[i].count = 0;
+        }
+        if (numa_region_base != NULL) {
+            pthread_setspecific(numa_key, cache);
+        }
+    }
+    return cache;
+}
+
+#endif /* USE_NUMA_POOL */
+
+/**
+ * NUMA pool `malloc` adapter.
+ *
+ * @param ctx unused allocator context.
+ * @param size amount of memory to allocate.
+ *
+ * @return pointer to allocated memory, NULL on failure.
+ */
+static void *
+numa_pool_alloc(void *ctx, size_t size) {
+#ifdef USE_NUMA_POOL
+    if (size > 0 && size <= CERIALIZER_NUMA_MAX_SIZE) {
+        numa_thread_cache *cache = numa_get_thread_cache();
+        int index = numa_class_index(size);
+        numa_magazine *magazine = &cache->local[index];
+
+        if (numa_region_base != NULL) {
+            if (magazine->count == 0) {
+                /* the thread may have migrated since the last refill */
+                int node = numa_current_node();
+                if (node != cache->node) {
+                    int i;
+                    for (i = 0; i < NUMA_CLASSES; i++) {
+                        numa_flush(i, &cache->local[i], 0, 0);
+                        cache->local[i].node = node;
+                    }
+                    cache->node = node;
+                }
+                numa_refill(cache->node, index, magazine);
+            }
+            if (magazine->count > 0) {
+                return magazine->blocks[--magazine->count];
+            }
+        }
+    }
+#endif
+    return malloc(size);
+}
+
+/**
+ * NUMA pool `free` adapter. Blocks of another node are batched before
+ * they are returned to their owning node.
+ *
+ * @param ctx unused allocator context.
+ * @param ptr pointer to de-allocate.
+ */
+static void
+numa_pool_free(void *ctx, void *ptr) {
+#ifdef USE_NUMA_POOL
+    int index;
+    int node = numa_block_owner(ptr, &index);
+    if (node >= 0) {
+        numa_thread_cache *cache = numa_get_thread_cache();
+        numa_magazine *magazine;
+        if (node == cache->node) {
+            magazine = &cache->local[index];
+            if (magazine->count == NUMA_MAGAZINE_SIZE) {
+                numa_flush(index, magazine, NUMA_MAGAZINE_SIZE / 2, 0);
+            }
+        } else {
+            magazine = &cache->remote[index];
+            if (magazine->node != node) {
+                /* batch holds blocks of yet another node */
+                numa_flush(index, magazine, 0, 1);
+                magazine->node = node;
+            } else if (magazine->count == NUMA_REMOTE_BATCH) {
+                numa_flush(index, magazine, 0, 1);
+            }
+        }
+        magazine->blocks[magazine->count++] = ptr;
+        return;
+    }
+#endif
+    free(ptr);
+}
+
+/**
+ * NUMA pool `realloc` adapter.
+ *
+ * @param ctx unused allocator context.
+ * @param ptr pointer to memory to be re-allocated.
+ * @param size amount of memory to allocate.
+ *
+ * @return pointer to re-allocated memory, NULL on failure.
+ */
+static void *
+numa_pool_realloc(void *ctx, void *ptr, size_t size) {
+#ifdef USE_NUMA_POOL
+    int index;
+    if (ptr != NULL && numa_block_owner(ptr, &index) >= 0) {
+        size_t block_size = (size_t)NUMA_MIN_SIZE << index;
+        void *new_ptr;
+        if (size <= block_size) {
+            return ptr;
+        }
+        new_ptr = numa_pool_alloc(ctx, size);
+        if (new_ptr != NULL) {
+            memcpy(new_ptr, ptr, block_size);
+            numa_pool_free(ctx, ptr);
+        }
+        return new_ptr;
+    }
+#endif
+    return realloc(ptr, size);
+}
+
+/* the NUMA-aware pool allocator */
+static const cerializer_allocator numa_pool_allocator = {
+    numa_pool_alloc, numa_pool_realloc, numa_pool_free, NULL
+};
+
+/**
+ * Get the NUMA-aware pool allocator, e.g. to pass to
+ * dynmessage_deserialize_bin_with_allocator or cerializer_set_allocator.
+ *
+ * @return the NUMA-aware pool allocator.
+ */
+extern const cerializer_allocator *
+cerializer_numa_pool_allocator(void) {
+    return &numa_pool_allocator;
+}
+
+/**
+ * Get the number of NUMA nodes served by the pool allocator.
+ *
+ * @return number of nodes (1 on systems without NUMA support).
+ */
+extern int
+cerializer_numa_node_count(void) {
+#ifdef USE_NUMA_POOL
+    pthread_once(&numa_once, numa_init);
+    return numa_nodes;
+#else
+    return 1;
+#endif
+}
+
+/**
+ * Get the statistics of the NUMA node pools.
+ *
+ * @param stats array to fill in.
+ * @param max_nodes maximum number of entries to fill in.
+ *
+ * @return number of entries filled in.
+ */
+extern int
+cerializer_numa_pool_get_stats(cerializer_numa_node_stats *stats, int max_nodes) {
+    int count = 0;
+#ifdef USE_NUMA_POOL
+    int i;
+    pthread_once(&numa_once, numa_init);
+    if (numa_region_base == NULL || stats == NULL) {
+        return 0;
+    }
+    for (i = 0; i < numa_nodes && count < max_nodes; i++) {
+        numa_node_pool *pool = &numa_pools[i];
+        pthread_mutex_lock(&pool->lock);
+        stats[count].node = i;
+        stats[count].slabs = pool->slabs;
+        stats[count].remote_frees = pool->remote_frees;
+        stats[count].remote_batches = pool->remote_batches;
+        pthread_mutex_unlock(&pool->lock);
+        count++;
+    }
+#endif
+    return count;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * NUMA-aware pool allocator. Small blocks are carved out of per-node
+ * memory regions (bound with `mbind`, using raw system calls so libnuma
+ * is not required), allocations are served from the node of the calling
+ * thread, and blocks freed by a thread of another node are batched back
+ * to their owning node. Larger blocks, and all blocks on systems
+ * without NUMA support, use the standard library allocator.
+ */
+
+#ifndef NUMA_POOL_H_
+#define NUMA_POOL_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "stdlib_util.h"
+
+/* maximum number of NUMA nodes served by dedicated pools */
+#define CERIALIZER_NUMA_MAX_NODES 64
+
+/* largest block size served from the per-node pools */
+#define CERIALIZER_NUMA_MAX_SIZE 1024
+
+/* Structure to hold statistics of a NUMA node pool. */
+typedef struct _cerializer_numa_node_stats_struct {
+    int node; /* NUMA node identifier */
+    size_t slabs; /* slabs carved out of the node region */
+    size_t remote_frees; /* blocks freed by threads of other nodes */
+    size_t remote_batches; /* batches the remote frees were returned in */
+} cerializer_numa_node_stats;
+
+/**
+ * Get the NUMA-aware pool allocator, e.g. to pass to
+ * dynmessage_deserialize_bin_with_allocator or cerializer_set_allocator.
+ *
+ * @return the NUMA-aware pool allocator.
+ */
+extern const cerializer_allocator *
+cerializer_numa_pool_allocator(void);
+
+/**
+ * Get the number of NUMA nodes served by the pool allocator.
+ *
+ * @return number of nodes (1 on systems without NUMA support).
+ */
+extern int
+cerializer_numa_node_count(void);
+
+/**
+ * Get the statistics of the NUMA node pools.
+ *
+ * @param stats array to fill in.
+ * @param max_nodes maximum number of entries to fill in.
+ *
+ * @return number of entries filled in.
+ */
+extern int
+cerializer_numa_pool_get_stats(cerializer_numa_node_stats *stats, int max_nodes);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* NUMA_POOL_H_ */
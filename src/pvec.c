@@ -0,0 +1,176 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Implementation of a growable (contiguous) vector of pointers.
+ */
+
+#include <stdlib.h>
+
+#include "stdlib_util.h"
+#include "pvec.h"
+
+/* initial room of a vector upon first append */
+#define PVEC_MIN_CAPACITY 8
+
+/**
+ * Create (and initialize) a vector.
+ *
+ * @return a new vector structure.
+ */
+extern pvec *
+pvec_create(void) {
+    pvec * vec = (pvec *)SAFE_MALLOC(sizeof(pvec));
+    pvec_init(vec);
+    return vec;
+}
+
+/**
+ * Initialize a vector.
+ *
+ * @param vec vector structure.
+ */
+extern void
+pvec_init(pvec *vec) {
+    if (vec != NULL) {
+        vec->data = NULL;
+        vec->size = 0;
+        vec->capacity = 0;
+    }
+}
+
+/**
+ * Make sure the vector can hold at least the provided number of data
+ * pointers without growing.
+ *
+ * @param vec vector structure.
+ * @param capacity number of data pointers to reserve room for.
+ */
+extern void
+pvec_reserve(pvec *vec, size_t capacity) {
+    if (vec != NULL && capacity > vec->capacity) {
+        vec->data = (void **)SAFE_REALLOC(vec->data, capacity * sizeof(void *));
+        vec->capacity = capacity;
+    }
+}
+
+/**
+ * Append data to the vector (amortized constant time).
+ *
+ * @param vec vector structure.
+ * @param data data to append.
+ */
+extern void
+pvec_append(pvec *vec, void *data) {
+    if (vec != NULL) {
+        if (vec->size == vec->capacity) {
+            /* grow geometrically to keep appends amortized O(1) */
+            size_t capacity = 2 * vec->capacity;
+            if (capacity < PVEC_MIN_CAPACITY) {
+                capacity = PVEC_MIN_CAPACITY;
+            }
+            pvec_reserve(vec, capacity);
+        }
+        vec->data[vec->size++] = data;
+    }
+}
+
+/**
+ * Get the data stored at the provided index.
+ *
+ * @param vec vector structure.
+ * @param index index of the data.
+ *
+ * @return the data stored at index, NULL if index is out of range.
+ */
+extern void *
+pvec_get(pvec *vec, size_t index) {
+    if (vec == NULL || index >= vec->size) {
+        return NULL;
+    }
+    return vec->data[index];
+}
+
+/**
+ * Sort the data of the vector.
+ *
+ * @param vec vector structure.
+ * @param compare function to compare data pointers.
+ */
+extern void
+pvec_sort(pvec *vec, pvec_data_compare compare) {
+    if (!pvec_empty(vec) && compare != NULL) {
+        qsort(vec->data, vec->size, sizeof(void *), compare);
+    }
+}
+
+/**
+ * Tests whether the provided vector is empty.
+ *
+ * @param vec vector structure.
+ *
+ * @return Non-zero if vector is empty, zero otherwise.
+ */
+extern int
+pvec_empty(pvec *vec) {
+    int result = 0;
+    if (vec == NULL) {
+        result++;
+    } else {
+        if (vec->size == 0) {
+            result++;
+        }
+    }
+    return result;
+}
+
+/**
+ * Removes all data from the vector, keeping the allocated room.
+ * Note that stored data remains intact(not free'd).
+ *
+ * @param vec vector structure.
+ */
+extern void
+pvec_clear(pvec *vec) {
+    if (vec != NULL) {
+        vec->size = 0;
+    }
+}
+
+/**
+ * Free the vector storage and all its data. Uses pvec_data_dealloc
+ * function passed.
+ * Note that in case pvec_data_dealloc was not provided, stored
+ * data remains intact(not free'd);
+ *
+ * @param vec vector structure.
+ * @param free_data data de-allocation function.
+ */
+extern void
+pvec_free(pvec *vec, pvec_data_dealloc free_data) {
+    if (vec != NULL) {
+        if (free_data != NULL) {
+            size_t i;
+            for (i = 0; i < vec->size; i++) {
+                free_data(vec->data[i]);
+            }
+        }
+        if (vec->data != NULL) {
+            SAFE_FREE(vec->data);
+        }
+        pvec_init(vec);
+    }
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Implementation of a growable (contiguous) vector of pointers.
+ */
+
+#ifndef PVEC_H_
+#define PVEC_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * Function to free stored data pointers.
+ */
+typedef void (*pvec_data_dealloc)(void *data);
+
+/**
+ * Function to compare two stored data pointers (qsort style).
+ *
+ * @param l pointer to the first stored data pointer.
+ * @param r pointer to the second stored data pointer.
+ *
+ * @return negative, zero or positive if `l` is less than, equal to
+ *         or greater than `r` respectively.
+ */
+typedef int (*pvec_data_compare)(const void *l, const void *r);
+
+/**
+ * Vector structure.
+ */
+typedef struct {
+    /* Contiguous array of stored data pointers */
+    void **data;
+    /* Number of stored data pointers */
+    size_t size;
+    /* Number of data pointers the array can hold without growing */
+    size_t capacity;
+} pvec;
+
+/**
+ * Create (and initialize) a vector.
+ *
+ * @return a new vector structure.
+ */
+extern pvec *
+pvec_create(void);
+
+/**
+ * Initialize a vector.
+ *
+ * @param vec vector structure.
+ */
+extern void
+pvec_init(pvec *vec);
+
+/**
+ * Make sure the vector can hold at least the provided number of data
+ * pointers without growing.
+ *
+ * @param vec vector structure.
+ * @param capacity number of data pointers to reserve room for.
+ */
+extern void
+pvec_reserve(pvec *vec, size_t capacity);
+
+/**
+ * Append data to the vector (amortized constant time).
+ *
+ * @param vec vector structure.
+ * @param data data to append.
+ */
+extern void
+pvec_append(pvec *vec, void *data);
+
+/**
+ * Get the data stored at the provided index.
+ *
+ * @param vec vector structure.
+ * @param index index of the data.
+ *
+ * @return the data stored at index, NULL if index is out of range.
+ */
+extern void *
+pvec_get(pvec *vec, size_t index);
+
+/**
+ * Sort the data of the vector.
+ *
+ * @param vec vector structure.
+ * @param compare function to compare data pointers.
+ */
+extern void
+pvec_sort(pvec *vec, pvec_data_compare compare);
+
+/**
+ * Tests whether the provided vector is empty.
+ *
+ * @param vec vector structure.
+ *
+ * @return Non-zero if vector is empty, zero otherwise.
+ */
+extern int
+pvec_empty(pvec *vec);
+
+/**
+ * Removes all data from the vector, keeping the allocated room.
+ * Note that stored data remains intact(not free'd).
+ *
+ * @param vec vector structure.
+ */
+extern void
+pvec_clear(pvec *vec);
+
+/**
+ * Free the vector storage and all its data. Uses pvec_data_dealloc
+ * function passed.
+ * Note that in case pvec_data_dealloc was not provided, stored
+ * data remains intact(not free'd);
+ *
+ * @param vec vector structure.
+ * @param free_data data de-allocation function.
+ */
+extern void
+pvec_free(pvec *vec, pvec_data_dealloc free_data);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* PVEC_H_ */
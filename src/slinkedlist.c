@@ -64,6 +64,7 @@ slinkedlist_init(slinkedlist *list) {
         list->head = NULL;
         list->tail = NULL;
         list->size = 0;
+        list->allocator = NULL;
     }
 }
 
@@ -77,7 +78,7 @@ extern void
 slinkedlist_append(slinkedlist *list, void *data) {
     if (list != NULL) {
         slinkedlist_node_t *new_node =
-            (slinkedlist_node_t *)SAFE_MALLOC(sizeof(slinkedlist_node_t));
+            (slinkedlist_node_t *)SAFE_SLAB_ALLOC_WITH(list->allocator, sizeof(slinkedlist_node_t));
         new_node->data = data;
         new_node->next = NULL;
         if (list->head == NULL) {
@@ -100,7 +101,7 @@ extern void
 slinkedlist_prepend(slinkedlist *list, void *data) {
     if (list != NULL) {
         slinkedlist_node_t *new_node =
-            (slinkedlist_node_t *)SAFE_MALLOC(sizeof(slinkedlist_node_t));
+            (slinkedlist_node_t *)SAFE_SLAB_ALLOC_WITH(list->allocator, sizeof(slinkedlist_node_t));
 
         new_node->data = data;
         new_node->next = list->head;
@@ -166,7 +167,7 @@ slinkedlist_delete_head(slinkedlist *list) {
         return NULL;
     } else {
         data = head->data;
-        SAFE_FREE(head);
+        SAFE_SLAB_FREE_WITH(list->allocator, head, sizeof(slinkedlist_node_t));
         return data;
     }
 }
@@ -213,7 +214,7 @@ slinkedlist_delete_tail(slinkedlist *list){
         return NULL;
     } else {
     	data = tail->data;
-    	SAFE_FREE(tail);
+    	SAFE_SLAB_FREE_WITH(list->allocator, tail, sizeof(slinkedlist_node_t));
         return data;
     }
 }
@@ -254,7 +255,7 @@ slinkedlist_delete_data(slinkedlist *list, void *data) {
         if (current_node == list->tail) {
             list->tail = previous_node;
         }
-        SAFE_FREE(current_node);
+        SAFE_SLAB_FREE_WITH(list->allocator, current_node, sizeof(slinkedlist_node_t));
         /* decrement structure sizes */
         list->size--;
     }
@@ -392,7 +393,7 @@ slinkedlist_free(slinkedlist *list, slinkedlist_data_dealloc free_data) {
             if (free_data != NULL) {
                 free_data(current_node->data);
             }
-            SAFE_FREE(current_node);
+            SAFE_SLAB_FREE_WITH(list->allocator, current_node, sizeof(slinkedlist_node_t));
             current_node = next_node;
             next_node = current_node->next;
         }
@@ -400,7 +401,7 @@ slinkedlist_free(slinkedlist *list, slinkedlist_data_dealloc free_data) {
         if (free_data != NULL) {
             free_data(current_node->data);
         }
-        SAFE_FREE(current_node);
+        SAFE_SLAB_FREE_WITH(list->allocator, current_node, sizeof(slinkedlist_node_t));
     }
     list->head = NULL;
     list->tail = NULL;
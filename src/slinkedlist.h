@@ -27,6 +27,8 @@ extern "C" {
 
 #include <stddef.h>
 
+#include "stdlib_util.h"
+
 /**
  * Function to free stored data pointers.
  */
@@ -52,6 +54,8 @@ typedef struct {
     size_t size;
     /* Pointer to last node */
     slinkedlist_node_t *tail;
+    /* Allocator of the nodes (NULL for the global allocator) */
+    const cerializer_allocator *allocator;
 } slinkedlist;
 
 /**
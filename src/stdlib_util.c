@@ -21,14 +21,113 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "alloc_stats.h"
 #include "log.h"
 #include "stdlib_util.h"
 
+/* the slab allocator needs thread-local storage and atomic builtins,
+ * and is bypassed while counting allocations */
+#if defined(__GNUC__) && !defined(TEST) && !defined(CERIALIZER_ALLOC_STATS) \
+    && !defined(CERIALIZER_NO_SLAB)
+#define USE_SLAB_ALLOCATOR
+#include <pthread.h>
+#endif
+
 #ifdef TEST
 int __malloc_counter = 0;
 #endif
 
+/**
+ * Standard library `malloc` adapter.
+ *
+ * @param ctx unused allocator context.
+ * @param size amount of memory to allocate.
+ *
+ * @return pointer to allocated memory.
+ */
+static void *
+std_alloc(void *ctx, size_t size) {
+    return malloc(size);
+}
+
+/**
+ * Standard library `realloc` adapter.
+ *
+ * @param ctx unused allocator context.
+ * @param ptr pointer to memory to be re-allocated.
+ * @param size amount of memory to allocate.
+ *
+ * @return pointer to re-allocated memory.
+ */
+static void *
+std_realloc(void *ctx, void *ptr, size_t size) {
+    return realloc(ptr, size);
+}
+
+/**
+ * Standard library `free` adapter.
+ *
+ * @param ctx unused allocator context.
+ * @param ptr pointer to de-allocate.
+ */
+static void
+std_free(void *ctx, void *ptr) {
+    free(ptr);
+}
+
+/* standard library allocator */
+static const cerializer_allocator std_allocator = {
+    std_alloc, std_realloc, std_free, NULL
+};
+
+/* global allocator used by the library */
+static cerializer_allocator global_allocator = {
+    std_alloc, std_realloc, std_free, NULL
+};
+
+/**
+ * Set the global allocator used by the library. The allocator should
+ * be set once, before any library memory is allocated, since memory must
+ * be released through the allocator that allocated it. It must keep all
+ * its memory valid until released: an arena (see arena.h) is passed per
+ * message instead (e.g. to dynmessage_init_with_allocator).
+ *
+ * @param allocator the allocator to use, NULL to restore the standard
+ *        library allocator. The structure is copied.
+ */
+extern void
+cerializer_set_allocator(const cerializer_allocator *allocator) {
+    if (allocator == NULL) {
+        global_allocator = std_allocator;
+    } else {
+        global_allocator = *allocator;
+    }
+}
+
+/**
+ * Get the global allocator used by the library.
+ *
+ * @return reference to the global allocator.
+ */
+extern const cerializer_allocator *
+cerializer_get_allocator(void) {
+    return &global_allocator;
+}
+
+/**
+ * Get the standard library allocator, used for the process-wide state of
+ * the library (e.g. the string interning table) whatever the global
+ * allocator.
+ *
+ * @return reference to the standard library allocator.
+ */
+extern const cerializer_allocator *
+cerializer_get_std_allocator(void) {
+    return &std_allocator;
+}
+
 /**
  * Allocate memory while exiting on failure. Also used to count
  * references during testing. All code could call this instead of
@@ -47,15 +146,85 @@ safe_malloc(
     const char * modulename,
     const char * funcname,
     unsigned long lineno) {
-    void *ptr = malloc(size);
+    return safe_malloc_with(NULL, size, modulename, funcname, lineno);
+}
+
+/**
+ * Re-allocate the previously allocated block in ptr, making
+ * the new block SIZE bytes long, while exiting on failure.
+ * All code could call this instead of `realloc`.
+ *
+ * @param ptr pointer to memory to be re-allocated.
+ * @param size amount of memory to allocate
+ * @param modulename name of the module which uses safe_realloc.
+ * @param funcname name of the function which uses safe_realloc.
+ * @param lineno line number of the code which calls safe_realloc.
+ *
+ * @return pointer to re-allocated memory.
+ */
+extern void *
+safe_realloc(
+    void *ptr,
+    size_t size,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno) {
+    return safe_realloc_with(NULL, ptr, size, modulename, funcname, lineno);
+}
+
+/**
+ * Pass-through call to free. Also used to count references during
+ * testing. All code should call this instead of `free`.
+ *
+ * @param ptr pointer to de-allocate.
+ * @param modulename name of the module which uses safe_free.
+ * @param funcname name of the function which uses safe_free.
+ * @param lineno line number of the code which calls safe_free.
+ */
+extern void
+safe_free(
+    void *ptr,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno) {
+    safe_free_with(NULL, ptr, modulename, funcname, lineno);
+}
+
+/**
+ * Allocate memory through the provided allocator, while exiting on failure.
+ *
+ * @param allocator allocator to use, NULL for the global allocator.
+ * @param size amount of memory to allocate.
+ * @param modulename name of the module which uses safe_malloc_with.
+ * @param funcname name of the function which uses safe_malloc_with.
+ * @param lineno line number of the code which calls safe_malloc_with.
+ *
+ * @return pointer to allocated memory.
+ */
+extern void *
+safe_malloc_with(
+    const cerializer_allocator *allocator,
+    size_t size,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno) {
+    void *ptr;
+    if (allocator == NULL) {
+        allocator = &global_allocator;
+    }
+    ptr = allocator->alloc(allocator->ctx, size);
     if (!ptr) {
         log_function_error_message("stdlib_util.safe_malloc", "out of memory!");
         if (modulename != NULL && funcname != NULL && lineno > 0) {
-            log_error_format("[safe_malloc stacktrace] %s:%s:%u\n", modulename, funcname, lineno);
+            CLOG_ERROR("[safe_malloc stacktrace] %s:%s:%u\n", modulename, funcname, lineno);
         }
         exit(1);
     }
 
+#ifdef CERIALIZER_ALLOC_STATS
+    alloc_stats_record_alloc(ptr, size, modulename, funcname, lineno);
+#endif
+
 #ifdef TEST
     __malloc_counter++;
     fprintf(stdout, "safe_malloc: %p, counter: %d\n", ptr, __malloc_counter);
@@ -68,56 +237,74 @@ safe_malloc(
 }
 
 /**
- * Re-allocate the previously allocated block in ptr, making
- * the new block SIZE bytes long, while exiting on failure.
- * All code could call this instead of `realloc`.
+ * Re-allocate memory through the provided allocator, while exiting on failure.
  *
+ * @param allocator allocator to use, NULL for the global allocator.
  * @param ptr pointer to memory to be re-allocated.
  * @param size amount of memory to allocate
- * @param modulename name of the module which uses safe_realloc.
- * @param funcname name of the function which uses safe_realloc.
- * @param lineno line number of the code which calls safe_realloc.
+ * @param modulename name of the module which uses safe_realloc_with.
+ * @param funcname name of the function which uses safe_realloc_with.
+ * @param lineno line number of the code which calls safe_realloc_with.
  *
  * @return pointer to re-allocated memory.
  */
 extern void *
-safe_realloc(
+safe_realloc_with(
+    const cerializer_allocator *allocator,
     void *ptr,
     size_t size,
     const char *modulename,
     const char *funcname,
     unsigned long lineno) {
-    void *new_ptr = realloc(ptr, size);
+    void *new_ptr;
+    if (allocator == NULL) {
+        allocator = &global_allocator;
+    }
+#ifdef CERIALIZER_ALLOC_STATS
+    /* forget ptr before it is released, its address may be reused at once */
+    alloc_stats_record_free(ptr);
+#endif
+    new_ptr = allocator->realloc(allocator->ctx, ptr, size);
     if (new_ptr == NULL) {
         log_function_error_message("stdlib_util.safe_realloc", "out of memory!");
         if (modulename != NULL && funcname != NULL && lineno > 0) {
-            log_error_format("[safe_realloc stacktrace] %s:%s:%u\n", modulename, funcname, lineno);
+            CLOG_ERROR("[safe_realloc stacktrace] %s:%s:%u\n", modulename, funcname, lineno);
         }
         exit(1);
     }
+#ifdef CERIALIZER_ALLOC_STATS
+    alloc_stats_record_alloc(new_ptr, size, modulename, funcname, lineno);
+#endif
     return new_ptr;
 }
 
 /**
- * Pass-through call to free. Also used to count references during
- * testing. All code should call this instead of `free`.
+ * De-allocate memory through the provided allocator.
  *
+ * @param allocator allocator to use, NULL for the global allocator.
  * @param ptr pointer to de-allocate.
- * @param modulename name of the module which uses safe_free.
- * @param funcname name of the function which uses safe_free.
- * @param lineno line number of the code which calls safe_free.
+ * @param modulename name of the module which uses safe_free_with.
+ * @param funcname name of the function which uses safe_free_with.
+ * @param lineno line number of the code which calls safe_free_with.
  */
 extern void
-safe_free(
+safe_free_with(
+    const cerializer_allocator *allocator,
     void *ptr,
     const char *modulename,
     const char *funcname,
     unsigned long lineno) {
+    if (allocator == NULL) {
+        allocator = &global_allocator;
+    }
 #ifdef TEST
     fprintf(stdout, "free: %p,", ptr);
 #endif
 
-    free(ptr);
+#ifdef CERIALIZER_ALLOC_STATS
+    alloc_stats_record_free(ptr);
+#endif
+    allocator->free(allocator->ctx, ptr);
 
 #ifdef TEST
     __malloc_counter--;
@@ -127,3 +314,396 @@ safe_free(
 //    }
 #endif
 }
+
+/**
+ * Duplicate a c string through the provided allocator, while exiting
+ * on failure.
+ *
+ * @param allocator allocator to use, NULL for the global allocator.
+ * @param s proper c string to duplicate(not NULL).
+ * @param modulename name of the module which uses safe_strdup_with.
+ * @param funcname name of the function which uses safe_strdup_with.
+ * @param lineno line number of the code which calls safe_strdup_with.
+ *
+ * @return pointer to the duplicated c string.
+ */
+extern char *
+safe_strdup_with(
+    const cerializer_allocator *allocator,
+    const char *s,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno) {
+    size_t len = strlen(s) + 1; /* +1 for \0 */
+    char *d = (char *)safe_malloc_with(allocator, len, modulename, funcname, lineno);
+    memcpy(d, s, len);
+    return d;
+}
+
+/**
+ * Get the object size of a slab allocator size class.
+ *
+ * @param index index of the size class.
+ *
+ * @return size in bytes of the class objects.
+ */
+static size_t
+slab_class_size(int index) {
+    return (size_t)(CERIALIZER_SLAB_MAX_SIZE >> (CERIALIZER_SLAB_CLASSES - 1)) << index;
+}
+
+#ifdef USE_SLAB_ALLOCATOR
+
+/**
+ * Get the slab allocator size class serving the provided size.
+ *
+ * @param size object size (not greater than CERIALIZER_SLAB_MAX_SIZE).
+ *
+ * @return index of the size class.
+ */
+static int
+slab_class_index(size_t size) {
+    int index = 0;
+    size_t object_size = CERIALIZER_SLAB_MAX_SIZE >> (CERIALIZER_SLAB_CLASSES - 1);
+    while (object_size < size) {
+        object_size <<= 1;
+        index++;
+    }
+    return index;
+}
+
+/* size in bytes of a slab carved into objects of one size class */
+#define SLAB_SIZE 65536
+
+/* number of objects a thread caches per size class */
+#define SLAB_MAGAZINE_SIZE 64
+
+/* Free object of a size class, linked in the class depot. */
+typedef struct _slab_object_struct {
+    struct _slab_object_struct *next;
+} slab_object;
+
+/* Structure to hold the objects a thread caches for a size class. */
+typedef struct _slab_magazine_struct {
+    size_t count; /* number of cached objects */
+    void *objects[SLAB_MAGAZINE_SIZE]; /* cached objects */
+} slab_magazine;
+
+/* Structure to hold the slab allocator state of a thread. */
+typedef struct _slab_thread_cache_struct {
+    slab_magazine magazines[CERIALIZER_SLAB_CLASSES]; /* per class magazines */
+    size_t allocs[CERIALIZER_SLAB_CLASSES]; /* objects allocated by the thread */
+    size_t frees[CERIALIZER_SLAB_CLASSES]; /* objects freed by the thread */
+    struct _slab_thread_cache_struct *next; /* next registered thread cache */
+    struct _slab_thread_cache_struct *prev; /* previous registered thread cache */
+    int registered; /* non-zero once linked in the registry */
+} slab_thread_cache;
+
+/* Structure to hold the shared state of a size class. */
+typedef struct _slab_class_struct {
+    slab_object *free_list; /* depot of free objects */
+    char *cursor; /* next uncarved object of the current slab */
+    char *end; /* end of the current slab */
+    size_t reserved; /* objects carved out of slabs */
+    size_t slabs; /* slabs allocated */
+} slab_class;
+
+/* shared state protected by slab_lock */
+static pthread_mutex_t slab_lock = PTHREAD_MUTEX_INITIALIZER;
+static slab_class slab_classes[CERIALIZER_SLAB_CLASSES];
+static slab_thread_cache *slab_caches = NULL;
+static size_t slab_retired_allocs[CERIALIZER_SLAB_CLASSES];
+static size_t slab_retired_frees[CERIALIZER_SLAB_CLASSES];
+
+/* key used to return the magazines of exiting threads */
+static pthread_key_t slab_key;
+static pthread_once_t slab_key_once = PTHREAD_ONCE_INIT;
+
+/* slab allocator state of the current thread */
+static __thread slab_thread_cache slab_cache;
+
+/**
+ * Move objects from the magazine of an exiting thread back to the
+ * class depots and un-register its cache.
+ *
+ * @param data thread cache of the exiting thread.
+ */
+static void
+slab_thread_exit(void *data) {
+    slab_thread_cache *cache = (slab_thread_cache *)data;
+    int i;
+
+    pthread_mutex_lock(&slab_lock);
+    for (i = 0; i < CERIALIZER_SLAB_CLASSES; i++) {
+        slab_magazine *magazine = &cache->magazines[i];
+        while (magazine->count > 0) {
+            slab_object *object = (slab_object *)magazine->objects[--magazine->count];
+            object->next = slab_classes[i].free_list;
+            slab_classes[i].free_list = object;
+        }
+        slab_retired_allocs[i] += cache->allocs[i];
+        slab_retired_frees[i] += cache->frees[i];
+        cache->allocs[i] = 0;
+        cache->frees[i] = 0;
+    }
+    if (cache->prev != NULL) {
+        cache->prev->next = cache->next;
+    } else {
+        slab_caches = cache->next;
+    }
+    if (cache->next != NULL) {
+        cache->next->prev = cache->prev;
+    }
+    cache->registered = 0;
+    pthread_mutex_unlock(&slab_lock);
+}
+
+/**
+ * Create the key used to return the magazines of exiting threads.
+ */
+static void
+slab_create_key(void) {
+    pthread_key_create(&slab_key, slab_thread_exit);
+}
+
+/**
+ * Get the slab allocator state of the current thread, registering it
+ * on first use.
+ *
+ * @return the thread cache of the current thread.
+ */
+static slab_thread_cache *
+slab_get_thread_cache(void) {
+    slab_thread_cache *cache = &slab_cache;
+    if (__builtin_expect(!cache->registered, 0)) {
+        pthread_once(&slab_key_once, slab_create_key);
+        pthread_mutex_lock(&slab_lock);
+        cache->prev = NULL;
+        cache->next = slab_caches;
+        if (slab_caches != NULL) {
+            slab_caches->prev = cache;
+        }
+        slab_caches = cache;
+        cache->registered = 1;
+        pthread_mutex_unlock(&slab_lock);
+        pthread_setspecific(slab_key, cache);
+    }
+    return cache;
+}
+
+/**
+ * Fill half of an empty magazine from the class depot, carving new
+ * slabs as needed.
+ *
+ * @param index index of the size class.
+ * @param magazine the magazine to fill.
+ *
+ * @return Non-zero if at least one object is available, zero otherwise.
+ */
+static int
+slab_refill(int index, slab_magazine *magazine) {
+    slab_class *size_class = &slab_classes[index];
+    size_t object_size = slab_class_size(index);
+
+    pthread_mutex_lock(&slab_lock);
+    while (magazine->count < SLAB_MAGAZINE_SIZE / 2) {
+        if (size_class->free_list != NULL) {
+            slab_object *object = size_class->free_list;
+            size_class->free_list = object->next;
+            magazine->objects[magazine->count++] = object;
+        } else {
+            if (size_class->cursor == size_class->end) {
+                /* slabs are never returned, their objects are recycled */
+                char *slab = (char *)malloc(SLAB_SIZE);
+                if (slab == NULL) {
+                    break;
+                }
+                size_class->cursor = slab;
+                size_class->end = slab + (SLAB_SIZE / object_size) * object_size;
+                size_class->slabs++;
+            }
+            magazine->objects[magazine->count++] = size_class->cursor;
+            size_class->cursor += object_size;
+            size_class->reserved++;
+        }
+    }
+    pthread_mutex_unlock(&slab_lock);
+    return magazine->count > 0;
+}
+
+/**
+ * Return half of a full magazine to the class depot.
+ *
+ * @param index index of the size class.
+ * @param magazine the magazine to drain.
+ */
+static void
+slab_flush(int index, slab_magazine *magazine) {
+    slab_class *size_class = &slab_classes[index];
+
+    pthread_mutex_lock(&slab_lock);
+    while (magazine->count > SLAB_MAGAZINE_SIZE / 2) {
+        slab_object *object = (slab_object *)magazine->objects[--magazine->count];
+        object->next = size_class->free_list;
+        size_class->free_list = object;
+    }
+    pthread_mutex_unlock(&slab_lock);
+}
+
+/**
+ * Test whether the slab allocator serves the provided allocation.
+ *
+ * @param allocator allocator requested, NULL for the global allocator.
+ * @param size amount of memory requested.
+ *
+ * @return Non-zero if the slab allocator serves the allocation, zero otherwise.
+ */
+static int
+slab_serves(const cerializer_allocator *allocator, size_t size) {
+    int result = 0;
+    if (allocator == NULL) {
+        allocator = &global_allocator;
+    }
+    /* custom allocators see every allocation */
+    if (allocator->alloc == std_alloc && size > 0 && size <= CERIALIZER_SLAB_MAX_SIZE) {
+        result++;
+    }
+    return result;
+}
+
+#endif /* USE_SLAB_ALLOCATOR */
+
+/**
+ * Allocate a small fixed-size object, while exiting on failure.
+ * When the standard library allocator is in effect, objects up to
+ * CERIALIZER_SLAB_MAX_SIZE bytes are served from per-thread magazines
+ * of a size-class slab allocator, otherwise this is identical to
+ * safe_malloc_with. Memory must be released with safe_slab_free_with.
+ *
+ * @param allocator allocator to use, NULL for the global allocator.
+ * @param size amount of memory to allocate.
+ * @param modulename name of the module which uses safe_slab_alloc_with.
+ * @param funcname name of the function which uses safe_slab_alloc_with.
+ * @param lineno line number of the code which calls safe_slab_alloc_with.
+ *
+ * @return pointer to allocated memory.
+ */
+extern void *
+safe_slab_alloc_with(
+    const cerializer_allocator *allocator,
+    size_t size,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno) {
+#ifdef USE_SLAB_ALLOCATOR
+    if (slab_serves(allocator, size)) {
+        int index = slab_class_index(size);
+        slab_thread_cache *cache = slab_get_thread_cache();
+        slab_magazine *magazine = &cache->magazines[index];
+
+        if (magazine->count == 0 && !slab_refill(index, magazine)) {
+            log_function_error_message("stdlib_util.safe_slab_alloc_with", "out of memory!");
+            if (modulename != NULL && funcname != NULL && lineno > 0) {
+                CLOG_ERROR("[safe_slab_alloc_with stacktrace] %s:%s:%u\n", modulename, funcname, lineno);
+            }
+            exit(1);
+        }
+        /* single writer, the store is only atomic for the statistics readers */
+        __atomic_store_n(&cache->allocs[index], cache->allocs[index] + 1, __ATOMIC_RELAXED);
+        return magazine->objects[--magazine->count];
+    }
+#endif
+    return safe_malloc_with(allocator, size, modulename, funcname, lineno);
+}
+
+/**
+ * De-allocate an object allocated with safe_slab_alloc_with.
+ *
+ * @param allocator allocator used for the allocation.
+ * @param ptr pointer to de-allocate.
+ * @param size size passed when allocating the object.
+ * @param modulename name of the module which uses safe_slab_free_with.
+ * @param funcname name of the function which uses safe_slab_free_with.
+ * @param lineno line number of the code which calls safe_slab_free_with.
+ */
+extern void
+safe_slab_free_with(
+    const cerializer_allocator *allocator,
+    void *ptr,
+    size_t size,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno) {
+#ifdef USE_SLAB_ALLOCATOR
+    if (slab_serves(allocator, size)) {
+        if (ptr != NULL) {
+            int index = slab_class_index(size);
+            slab_thread_cache *cache = slab_get_thread_cache();
+            slab_magazine *magazine = &cache->magazines[index];
+
+            if (magazine->count == SLAB_MAGAZINE_SIZE) {
+                slab_flush(index, magazine);
+            }
+            magazine->objects[magazine->count++] = ptr;
+            __atomic_store_n(&cache->frees[index], cache->frees[index] + 1, __ATOMIC_RELAXED);
+        }
+        return;
+    }
+#endif
+    safe_free_with(allocator, ptr, modulename, funcname, lineno);
+}
+
+/**
+ * Get the statistics of all slab allocator size classes.
+ *
+ * @param stats array of CERIALIZER_SLAB_CLASSES entries to fill in.
+ *
+ * @return number of entries filled in.
+ */
+extern int
+cerializer_get_slab_stats(cerializer_slab_stats *stats) {
+    int i;
+    if (stats == NULL) {
+        return 0;
+    }
+    for (i = 0; i < CERIALIZER_SLAB_CLASSES; i++) {
+        stats[i].object_size = slab_class_size(i);
+        stats[i].live = 0;
+        stats[i].reserved = 0;
+        stats[i].slabs = 0;
+    }
+#ifdef USE_SLAB_ALLOCATOR
+    pthread_mutex_lock(&slab_lock);
+    for (i = 0; i < CERIALIZER_SLAB_CLASSES; i++) {
+        /* objects may be freed by another thread than the allocating
+         * one, so only the sum over all threads is meaningful */
+        size_t live = slab_retired_allocs[i] - slab_retired_frees[i];
+        slab_thread_cache *it = slab_caches;
+        while (it) {
+            live += __atomic_load_n(&it->allocs[i], __ATOMIC_RELAXED);
+            live -= __atomic_load_n(&it->frees[i], __ATOMIC_RELAXED);
+            it = it->next;
+        }
+        stats[i].live = live;
+        stats[i].reserved = slab_classes[i].reserved;
+        stats[i].slabs = slab_classes[i].slabs;
+    }
+    pthread_mutex_unlock(&slab_lock);
+#endif
+    return CERIALIZER_SLAB_CLASSES;
+}
+
+/**
+ * Log (at INFO level) the statistics of all slab allocator size classes.
+ */
+extern void
+cerializer_log_slab_stats(void) {
+    cerializer_slab_stats stats[CERIALIZER_SLAB_CLASSES];
+    int count = cerializer_get_slab_stats(stats);
+    int i;
+    for (i = 0; i < count; i++) {
+        CLOG_INFO("slab class %lu bytes: live %lu, reserved %lu, slabs %lu\n",
+            (unsigned long)stats[i].object_size, (unsigned long)stats[i].live,
+            (unsigned long)stats[i].reserved, (unsigned long)stats[i].slabs);
+    }
+}
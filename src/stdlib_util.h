@@ -28,20 +28,100 @@ extern "C" {
 
 #include <stddef.h>
 
+/* allocation instrumentation needs the call site of every allocation */
+#if defined(CERIALIZER_ALLOC_STATS) && !defined(USE_SAFE_MEMORY_TRACE)
+#define USE_SAFE_MEMORY_TRACE
+#endif
+
 #ifdef USE_SAFE_MEMORY_TRACE
 #define SAFE_MALLOC(n) safe_malloc(n, __FILE__, __func__, __LINE__)
 #define SAFE_REALLOC(ptr, n) safe_realloc(ptr, n, __FILE__, __func__, __LINE__)
 #define SAFE_FREE(ptr) safe_free(ptr, __FILE__, __func__, __LINE__)
+#define SAFE_STRDUP(s) safe_strdup_with(NULL, s, __FILE__, __func__, __LINE__)
+#define SAFE_MALLOC_WITH(a, n) safe_malloc_with(a, n, __FILE__, __func__, __LINE__)
+#define SAFE_REALLOC_WITH(a, ptr, n) safe_realloc_with(a, ptr, n, __FILE__, __func__, __LINE__)
+#define SAFE_FREE_WITH(a, ptr) safe_free_with(a, ptr, __FILE__, __func__, __LINE__)
+#define SAFE_STRDUP_WITH(a, s) safe_strdup_with(a, s, __FILE__, __func__, __LINE__)
+#define SAFE_SLAB_ALLOC_WITH(a, n) safe_slab_alloc_with(a, n, __FILE__, __func__, __LINE__)
+#define SAFE_SLAB_FREE_WITH(a, ptr, n) safe_slab_free_with(a, ptr, n, __FILE__, __func__, __LINE__)
 #else
 #define SAFE_MALLOC(n) safe_malloc(n, NULL, NULL, 0)
 #define SAFE_REALLOC(ptr, n) safe_realloc(ptr, n, NULL, NULL, 0)
 #define SAFE_FREE(ptr) safe_free(ptr, NULL, NULL, 0)
+#define SAFE_STRDUP(s) safe_strdup_with(NULL, s, NULL, NULL, 0)
+#define SAFE_MALLOC_WITH(a, n) safe_malloc_with(a, n, NULL, NULL, 0)
+#define SAFE_REALLOC_WITH(a, ptr, n) safe_realloc_with(a, ptr, n, NULL, NULL, 0)
+#define SAFE_FREE_WITH(a, ptr) safe_free_with(a, ptr, NULL, NULL, 0)
+#define SAFE_STRDUP_WITH(a, s) safe_strdup_with(a, s, NULL, NULL, 0)
+#define SAFE_SLAB_ALLOC_WITH(a, n) safe_slab_alloc_with(a, n, NULL, NULL, 0)
+#define SAFE_SLAB_FREE_WITH(a, ptr, n) safe_slab_free_with(a, ptr, n, NULL, NULL, 0)
 #endif
 
+/* number of slab allocator size classes (8, 16, 32 and 64 bytes) */
+#define CERIALIZER_SLAB_CLASSES 4
+
+/* largest object size served by the slab allocator */
+#define CERIALIZER_SLAB_MAX_SIZE 64
+
+/**
+ * Memory allocator interface. All library memory management is routed
+ * through an allocator, which defaults to the standard library
+ * `malloc`, `realloc` and `free` functions.
+ */
+typedef struct _cerializer_allocator_struct {
+    /* allocate size bytes (NULL on failure) */
+    void *(*alloc)(void *ctx, size_t size);
+    /* re-allocate ptr to size bytes (NULL on failure) */
+    void *(*realloc)(void *ctx, void *ptr, size_t size);
+    /* de-allocate ptr */
+    void (*free)(void *ctx, void *ptr);
+    /* allocator specific context passed to all functions */
+    void *ctx;
+} cerializer_allocator;
+
+/* Structure to hold statistics of a slab allocator size class. */
+typedef struct _cerializer_slab_stats_struct {
+    size_t object_size; /* size in bytes of the class objects */
+    size_t live; /* objects currently in use */
+    size_t reserved; /* objects carved out of slabs (in use or cached) */
+    size_t slabs; /* number of slabs allocated for the class */
+} cerializer_slab_stats;
+
 #ifdef TEST
 extern int __malloc_counter;
 #endif
 
+/**
+ * Set the global allocator used by the library. The allocator should
+ * be set once, before any library memory is allocated, since memory must
+ * be released through the allocator that allocated it. It must keep all
+ * its memory valid until released: an arena (see arena.h) is passed per
+ * message instead (e.g. to dynmessage_init_with_allocator).
+ *
+ * @param allocator the allocator to use, NULL to restore the standard
+ *        library allocator. The structure is copied.
+ */
+extern void
+cerializer_set_allocator(const cerializer_allocator *allocator);
+
+/**
+ * Get the global allocator used by the library.
+ *
+ * @return reference to the global allocator.
+ */
+extern const cerializer_allocator *
+cerializer_get_allocator(void);
+
+/**
+ * Get the standard library allocator, used for the process-wide state of
+ * the library (e.g. the string interning table) whatever the global
+ * allocator.
+ *
+ * @return reference to the standard library allocator.
+ */
+extern const cerializer_allocator *
+cerializer_get_std_allocator(void);
+
 /**
  * Allocate memory while exiting on failure. Also used to count
  * references during testing. All code could call this instead of
@@ -98,6 +178,141 @@ safe_free(
     const char *funcname,
     unsigned long lineno);
 
+/**
+ * Allocate memory through the provided allocator, while exiting on failure.
+ *
+ * @param allocator allocator to use, NULL for the global allocator.
+ * @param size amount of memory to allocate.
+ * @param modulename name of the module which uses safe_malloc_with.
+ * @param funcname name of the function which uses safe_malloc_with.
+ * @param lineno line number of the code which calls safe_malloc_with.
+ *
+ * @return pointer to allocated memory.
+ */
+extern void *
+safe_malloc_with(
+    const cerializer_allocator *allocator,
+    size_t size,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno);
+
+/**
+ * Re-allocate memory through the provided allocator, while exiting on failure.
+ *
+ * @param allocator allocator to use, NULL for the global allocator.
+ * @param ptr pointer to memory to be re-allocated.
+ * @param size amount of memory to allocate
+ * @param modulename name of the module which uses safe_realloc_with.
+ * @param funcname name of the function which uses safe_realloc_with.
+ * @param lineno line number of the code which calls safe_realloc_with.
+ *
+ * @return pointer to re-allocated memory.
+ */
+extern void *
+safe_realloc_with(
+    const cerializer_allocator *allocator,
+    void *ptr,
+    size_t size,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno);
+
+/**
+ * De-allocate memory through the provided allocator.
+ *
+ * @param allocator allocator to use, NULL for the global allocator.
+ * @param ptr pointer to de-allocate.
+ * @param modulename name of the module which uses safe_free_with.
+ * @param funcname name of the function which uses safe_free_with.
+ * @param lineno line number of the code which calls safe_free_with.
+ */
+extern void
+safe_free_with(
+    const cerializer_allocator *allocator,
+    void *ptr,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno);
+
+/**
+ * Duplicate a c string through the provided allocator, while exiting
+ * on failure.
+ *
+ * @param allocator allocator to use, NULL for the global allocator.
+ * @param s proper c string to duplicate(not NULL).
+ * @param modulename name of the module which uses safe_strdup_with.
+ * @param funcname name of the function which uses safe_strdup_with.
+ * @param lineno line number of the code which calls safe_strdup_with.
+ *
+ * @return pointer to the duplicated c string.
+ */
+extern char *
+safe_strdup_with(
+    const cerializer_allocator *allocator,
+    const char *s,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno);
+
+/**
+ * Allocate a small fixed-size object, while exiting on failure.
+ * When the standard library allocator is in effect, objects up to
+ * CERIALIZER_SLAB_MAX_SIZE bytes are served from per-thread magazines
+ * of a size-class slab allocator, otherwise this is identical to
+ * safe_malloc_with. Memory must be released with safe_slab_free_with.
+ *
+ * @param allocator allocator to use, NULL for the global allocator.
+ * @param size amount of memory to allocate.
+ * @param modulename name of the module which uses safe_slab_alloc_with.
+ * @param funcname name of the function which uses safe_slab_alloc_with.
+ * @param lineno line number of the code which calls safe_slab_alloc_with.
+ *
+ * @return pointer to allocated memory.
+ */
+extern void *
+safe_slab_alloc_with(
+    const cerializer_allocator *allocator,
+    size_t size,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno);
+
+/**
+ * De-allocate an object allocated with safe_slab_alloc_with.
+ *
+ * @param allocator allocator used for the allocation.
+ * @param ptr pointer to de-allocate.
+ * @param size size passed when allocating the object.
+ * @param modulename name of the module which uses safe_slab_free_with.
+ * @param funcname name of the function which uses safe_slab_free_with.
+ * @param lineno line number of the code which calls safe_slab_free_with.
+ */
+extern void
+safe_slab_free_with(
+    const cerializer_allocator *allocator,
+    void *ptr,
+    size_t size,
+    const char *modulename,
+    const char *funcname,
+    unsigned long lineno);
+
+/**
+ * Get the statistics of all slab allocator size classes.
+ *
+ * @param stats array of CERIALIZER_SLAB_CLASSES entries to fill in.
+ *
+ * @return number of entries filled in.
+ */
+extern int
+cerializer_get_slab_stats(cerializer_slab_stats *stats);
+
+/**
+ * Log (at INFO level) the statistics of all slab allocator size classes.
+ */
+extern void
+cerializer_log_slab_stats(void);
+
 #ifdef  __cplusplus
 }
 #endif
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Growable string buffer with amortized constant time appends.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stdlib_util.h"
+#include "strbuf.h"
+
+/* initial room of a string buffer upon first append */
+#define STRBUF_MIN_CAPACITY 64
+
+/**
+ * Initialize a string buffer.
+ *
+ * @param sb string buffer structure.
+ */
+extern void
+strbuf_init(strbuf *sb) {
+    if (sb != NULL) {
+        sb->len = 0;
+        sb->cap = 0;
+        sb->data = NULL;
+    }
+}
+
+/**
+ * Make sure the string buffer can hold a string of the provided
+ * length (plus null terminator) without growing.
+ *
+ * @param sb string buffer structure.
+ * @param len string length to reserve room for.
+ */
+extern void
+strbuf_reserve(strbuf *sb, size_t len) {
+    if (sb != NULL && len + 1 > sb->cap) {
+        /* grow geometrically to keep appends amortized O(1) */
+        size_t cap = 2 * sb->cap;
+        if (cap < STRBUF_MIN_CAPACITY) {
+            cap = STRBUF_MIN_CAPACITY;
+        }
+        if (cap < len + 1) {
+            cap = len + 1;
+        }
+        sb->data = (char *)SAFE_REALLOC(sb->data, cap);
+        sb->cap = cap;
+        sb->data[sb->len] = '\0';
+    }
+}
+
+/**
+ * Append a number of bytes to the string buffer.
+ *
+ * @param sb string buffer structure.
+ * @param data bytes to append.
+ * @param len number of bytes to append.
+ */
+extern void
+strbuf_append(strbuf *sb, const char *data, size_t len) {
+    if (sb != NULL && data != NULL) {
+        strbuf_reserve(sb, sb->len + len);
+        memcpy(sb->data + sb->len, data, len);
+        sb->len += len;
+        sb->data[sb->len] = '\0';
+    }
+}
+
+/**
+ * Append a c string to the string buffer.
+ *
+ * @param sb string buffer structure.
+ * @param s proper c string to append.
+ */
+extern void
+strbuf_append_str(strbuf *sb, const char *s) {
+    if (s != NULL) {
+        strbuf_append(sb, s, strlen(s));
+    }
+}
+
+/**
+ * Append a character to the string buffer.
+ *
+ * @param sb string buffer structure.
+ * @param c character to append.
+ */
+extern void
+strbuf_append_char(strbuf *sb, char c) {
+    if (sb != NULL) {
+        strbuf_reserve(sb, sb->len + 1);
+        sb->data[sb->len++] = c;
+        sb->data[sb->len] = '\0';
+    }
+}
+
+/**
+ * Append a number of elements with the provided output format
+ * (printf style) to the string buffer.
+ *
+ * @param sb string buffer structure.
+ * @param format the output format to use.
+ * @param ... elements to append.
+ */
+extern void
+strbuf_appendf(strbuf *sb, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    strbuf_vappendf(sb, format, args);
+    va_end(args);
+}
+
+/**
+ * Append a variable argument list with the provided output format
+ * (vprintf style) to the string buffer.
+ *
+ * @param sb string buffer structure.
+ * @param format the output format to use.
+ * @param args variable argument list to append.
+ */
+extern void
+strbuf_vappendf(strbuf *sb, const char *format, va_list args) {
+    if (sb != NULL && format != NULL) {
+        va_list args_copy;
+        size_t room;
+        int len;
+
+        /* format in place, growing once if the room left is too small */
+        strbuf_reserve(sb, sb->len);
+        room = sb->cap - sb->len;
+        va_copy(args_copy, args);
+        len = vsnprintf(sb->data + sb->len, room, format, args_copy);
+        va_end(args_copy);
+        if (len < 0) {
+            sb->data[sb->len] = '\0';
+            return;
+        }
+        if ((size_t)len >= room) {
+            strbuf_reserve(sb, sb->len + len);
+            vsnprintf(sb->data + sb->len, sb->cap - sb->len, format, args);
+        }
+        sb->len += len;
+    }
+}
+
+/**
+ * Removes the string of the buffer, keeping the allocated room.
+ *
+ * @param sb string buffer structure.
+ */
+extern void
+strbuf_clear(strbuf *sb) {
+    if (sb != NULL) {
+        sb->len = 0;
+        if (sb->data != NULL) {
+            sb->data[0] = '\0';
+        }
+    }
+}
+
+/**
+ * Take ownership of the string of the buffer, leaving the buffer empty.
+ * The string must be released with SAFE_FREE.
+ *
+ * @param sb string buffer structure(not NULL).
+ *
+ * @return the null terminated string of the buffer (never NULL).
+ */
+extern char *
+strbuf_steal(strbuf *sb) {
+    char *data;
+    strbuf_reserve(sb, sb->len);
+    data = sb->data;
+    strbuf_init(sb);
+    return data;
+}
+
+/**
+ * Free the string buffer storage.
+ *
+ * @param sb string buffer structure.
+ */
+extern void
+strbuf_free(strbuf *sb) {
+    if (sb != NULL) {
+        if (sb->data != NULL) {
+            SAFE_FREE(sb->data);
+        }
+        strbuf_init(sb);
+    }
+}
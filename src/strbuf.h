@@ -0,0 +1,148 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Growable string buffer with amortized constant time appends.
+ */
+
+#ifndef STRBUF_H_
+#define STRBUF_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/**
+ * String buffer structure. The data is always null terminated once
+ * anything was appended.
+ */
+typedef struct {
+    /* Length of the string (excluding the null terminator) */
+    size_t len;
+    /* Number of bytes the data can hold without growing */
+    size_t cap;
+    /* String data (NULL until the first append) */
+    char *data;
+} strbuf;
+
+/**
+ * Initialize a string buffer.
+ *
+ * @param sb string buffer structure.
+ */
+extern void
+strbuf_init(strbuf *sb);
+
+/**
+ * Make sure the string buffer can hold a string of the provided
+ * length (plus null terminator) without growing.
+ *
+ * @param sb string buffer structure.
+ * @param len string length to reserve room for.
+ */
+extern void
+strbuf_reserve(strbuf *sb, size_t len);
+
+/**
+ * Append a number of bytes to the string buffer.
+ *
+ * @param sb string buffer structure.
+ * @param data bytes to append.
+ * @param len number of bytes to append.
+ */
+extern void
+strbuf_append(strbuf *sb, const char *data, size_t len);
+
+/**
+ * Append a c string to the string buffer.
+ *
+ * @param sb string buffer structure.
+ * @param s proper c string to append.
+ */
+extern void
+strbuf_append_str(strbuf *sb, const char *s);
+
+/**
+ * Append a character to the string buffer.
+ *
+ * @param sb string buffer structure.
+ * @param c character to append.
+ */
+extern void
+strbuf_append_char(strbuf *sb, char c);
+
+/**
+ * Append a number of elements with the provided output format
+ * (printf style) to the string buffer.
+ *
+ * @param sb string buffer structure.
+ * @param format the output format to use.
+ * @param ... elements to append.
+ */
+extern void
+strbuf_appendf(strbuf *sb, const char *format, ...)
+#ifdef __GNUC__
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+/**
+ * Append a variable argument list with the provided output format
+ * (vprintf style) to the string buffer.
+ *
+ * @param sb string buffer structure.
+ * @param format the output format to use.
+ * @param args variable argument list to append.
+ */
+extern void
+strbuf_vappendf(strbuf *sb, const char *format, va_list args);
+
+/**
+ * Removes the string of the buffer, keeping the allocated room.
+ *
+ * @param sb string buffer structure.
+ */
+extern void
+strbuf_clear(strbuf *sb);
+
+/**
+ * Take ownership of the string of the buffer, leaving the buffer empty.
+ * The string must be released with SAFE_FREE.
+ *
+ * @param sb string buffer structure(not NULL).
+ *
+ * @return the null terminated string of the buffer (never NULL).
+ */
+extern char *
+strbuf_steal(strbuf *sb);
+
+/**
+ * Free the string buffer storage.
+ *
+ * @param sb string buffer structure.
+ */
+extern void
+strbuf_free(strbuf *sb);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* STRBUF_H_ */
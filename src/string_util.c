@@ -21,6 +21,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "stdlib_util.h"
+#include "strkernel.h"
 #include "string_util.h"
 
 /**
@@ -28,6 +30,9 @@
  * and assigning the character value to the new memory cell. Note that this function
  * assumes that the provided c string is null terminated in case it is not null,
  * as it also appends a null terminator character at the end properly.
+ * Memory is obtained through the library allocator (see cerializer_set_allocator).
+ * Note that every call scans and reallocates the whole string, so prefer strbuf
+ * (see strbuf.h) when building a string incrementally.
  *
  * @param str pointer to a proper(null terminated) c string or to a NULL c string.
  * @param c character to append.
@@ -37,13 +42,13 @@ append_char(char ** str, char c) {
     char * b = NULL;
 
     if (*str == NULL) {
-        b = (char *) malloc(2 * sizeof(char));
+        b = (char *) SAFE_MALLOC(2 * sizeof(char));
         b[0] = c;
         b[1] = '\0';
     } else {
       char * d = *str;
       size_t len = strlen(d);
-      b = (char *) realloc(*str, len + sizeof(char) + 1);
+      b = (char *) SAFE_REALLOC(*str, len + sizeof(char) + 1);
       b[len] = c;
       b[len + 1] = '\0';
     }
@@ -55,7 +60,9 @@ append_char(char ** str, char c) {
  * and assigning all characters, including the new one to the new memory cells.
  * Note that this function assumes that the provided c string is null terminated
  * in case it is not null, as it also appends a null terminator character at the
- * end properly.
+ * end properly. Memory is obtained through the library allocator
+ * (see cerializer_set_allocator). Prefer strbuf (see strbuf.h) when building
+ * a string incrementally.
  *
  * @param str proper c string.
  * @param c character to append.
@@ -67,13 +74,13 @@ append_char_to_new_string(char * str, char c) {
     char * b = NULL;
 
     if (str == NULL) {
-        b = (char *) malloc(2 * sizeof(char));
+        b = (char *) SAFE_MALLOC(2 * sizeof(char));
         b[0] = c;
         b[1] = '\0';
     } else {
       size_t len = strlen(str);
       int i;
-      b = (char *) malloc(len + sizeof(char) + 1);
+      b = (char *) SAFE_MALLOC(len + sizeof(char) + 1);
       for (i=0; i<len; i++) {
           b[i] = str[i];
       }
@@ -93,9 +100,17 @@ append_char_to_new_string(char * str, char c) {
  */
 extern int
 test_string_equal(const void *l, const void *r) {
-    int result = 0;
-    if (strcmp((char*)l, (char *)r) == 0) {
-        result = 1;
-    }
-    return result;
+    return strkernel_equal((const char *)l, (const char *)r);
+}
+
+/**
+ * Hash a string value.
+ *
+ * @param key pointer to the string value.
+ *
+ * @return hash value of the string.
+ */
+extern size_t
+string_hash(const void *key) {
+    return strkernel_hash((const char *)key);
 }
@@ -25,11 +25,16 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
+
 /**
  * Append a character to the provided c string by (re)allocating required memory,
  * and assigning the character value to the new memory cell. Note that this function
  * assumes that the provided c string is null terminated in case it is not null,
  * as it also appends a null terminator character at the end properly.
+ * Memory is obtained through the library allocator (see cerializer_set_allocator).
+ * Note that every call scans and reallocates the whole string, so prefer strbuf
+ * (see strbuf.h) when building a string incrementally.
  *
  * @param str proper c string.
  * @param c character to append
@@ -42,7 +47,9 @@ append_char(char ** str, char c);
  * and assigning all characters, including the new one to the new memory cells.
  * Note that this function assumes that the provided c string is null terminated
  * in case it is not null, as it also appends a null terminator character at the
- * end properly.
+ * end properly. Memory is obtained through the library allocator
+ * (see cerializer_set_allocator). Prefer strbuf (see strbuf.h) when building
+ * a string incrementally.
  *
  * @param str proper c string.
  * @param c character to append.
@@ -62,6 +69,16 @@ append_char_to_new_string(char * str, char c);
 extern int
 test_string_equal(const void *l, const void *r);
 
+/**
+ * Hash a string value.
+ *
+ * @param key pointer to the string value.
+ *
+ * @return hash value of the string.
+ */
+extern size_t
+string_hash(const void *key);
+
 #ifdef  __cplusplus
 }
 #endif
@@ -0,0 +1,458 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * String equality and hashing kernels used for name lookups.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "strkernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+    && !defined(CERIALIZER_NO_SIMD)
+#define USE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+/* vector loads of null terminated strings may read past the terminator
+ * (never past the page holding it), which address sanitizer reports */
+#if defined(__SANITIZE_ADDRESS__)
+#define NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#endif
+#endif
+#ifndef NO_SANITIZE_ADDRESS
+#define NO_SANITIZE_ADDRESS
+#endif
+
+/* smallest page size of the supported targets */
+#define STRKERNEL_PAGE_SIZE 4096
+
+/* non-zero if reading `n` bytes at `p` may touch the next page */
+#define STRKERNEL_CROSSES_PAGE(p, n) \
+    ((((uintptr_t)(p)) & (STRKERNEL_PAGE_SIZE - 1)) > (STRKERNEL_PAGE_SIZE - (n)))
+
+/* reflected CRC-32C (Castagnoli) polynomial, as used by the crc32 instruction */
+#define STRKERNEL_CRC32C_POLY 0x82F63B78U
+
+/**
+ * Set of kernel functions.
+ */
+typedef struct {
+    /* name of the kernel */
+    const char *name;
+    /* equality of null terminated strings */
+    int (*equal)(const char *l, const char *r);
+    /* equality of `len` bytes */
+    int (*equal_n)(const char *l, const char *r, size_t len);
+    /* CRC-32C update over `len` bytes */
+    uint32_t (*crc)(uint32_t crc, const char *str, size_t len);
+} strkernel_ops;
+
+/* table driven CRC-32C of the scalar kernel */
+static uint32_t crc32c_table[256];
+
+/* selected kernel */
+static const strkernel_ops *kernel = NULL;
+static pthread_once_t kernel_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Scalar equality of null terminated strings.
+ *
+ * @param l first string.
+ * @param r second string.
+ *
+ * @return Non-zero if equal, zero otherwise.
+ */
+static int
+scalar_equal(const char *l, const char *r) {
+    return strcmp(l, r) == 0;
+}
+
+/**
+ * Scalar equality of `len` bytes.
+ *
+ * @param l first string.
+ * @param r second string.
+ * @param len number of bytes to compare.
+ *
+ * @return Non-zero if equal, zero otherwise.
+ */
+static int
+scalar_equal_n(const char *l, const char *r, size_t len) {
+    return memcmp(l, r, len) == 0;
+}
+
+/**
+ * Scalar (table driven) CRC-32C update.
+ *
+ * @param crc current CRC value.
+ * @param str bytes to process.
+ * @param len number of bytes to process.
+ *
+ * @return updated CRC value.
+ */
+static uint32_t
+scalar_crc(uint32_t crc, const char *str, size_t len) {
+    const unsigned char *p = (const unsigned char *)str;
+    while (len--) {
+        crc = crc32c_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static const strkernel_ops scalar_kernel = {
+    "scalar", scalar_equal, scalar_equal_n, scalar_crc
+};
+
+#ifdef USE_X86_KERNELS
+/**
+ * SSE4.2 equality of null terminated strings, 16 bytes per step.
+ * Bytes are compared one at a time while a 16-byte load would touch
+ * the next page of either string.
+ *
+ * @param l first string.
+ * @param r second string.
+ *
+ * @return Non-zero if equal, zero otherwise.
+ */
+NO_SANITIZE_ADDRESS __attribute__((target("sse4.2"))) static int
+sse42_equal(const char *l, const char *r) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (;;) {
+        if (STRKERNEL_CROSSES_PAGE(l + i, 16) || STRKERNEL_CROSSES_PAGE(r + i, 16)) {
+            size_t end = i + 16;
+            for (; i < end; i++) {
+                if (l[i] != r[i]) {
+                    return 0;
+                }
+                if (l[i] == '\0') {
+                    return 1;
+                }
+            }
+        } else {
+            __m128i a = _mm_loadu_si128((const __m128i *)(l + i));
+            __m128i b = _mm_loadu_si128((const __m128i *)(r + i));
+            /* first byte that differs or terminates `l` */
+            unsigned int mask =
+                (~(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) & 0xFFFFU)
+                | (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(a, zero));
+            if (mask != 0) {
+                size_t k = i + (size_t)__builtin_ctz(mask);
+                return l[k] == r[k];
+            }
+            i += 16;
+        }
+    }
+}
+
+/**
+ * SSE4.2 equality of `len` bytes, 16 bytes per step.
+ *
+ * @param l first string.
+ * @param r second string.
+ * @param len number of bytes to compare.
+ *
+ * @return Non-zero if equal, zero otherwise.
+ */
+__attribute__((target("sse4.2"))) static int
+sse42_equal_n(const char *l, const char *r, size_t len) {
+    size_t i;
+    if (len < 16) {
+        return memcmp(l, r, len) == 0;
+    }
+    for (i = 0; i + 16 <= len; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(l + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(r + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF) {
+            return 0;
+        }
+    }
+    if (i < len) {
+        /* last (overlapping) block */
+        __m128i a = _mm_loadu_si128((const __m128i *)(l + len - 16));
+        __m128i b = _mm_loadu_si128((const __m128i *)(r + len - 16));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * SSE4.2 CRC-32C update, 16 bytes per step.
+ *
+ * @param crc current CRC value.
+ * @param str bytes to process.
+ * @param len number of bytes to process.
+ *
+ * @return updated CRC value.
+ */
+__attribute__((target("sse4.2"))) static uint32_t
+sse42_crc(uint32_t crc, const char *str, size_t len) {
+#ifdef __x86_64__
+    uint64_t c = crc;
+    while (len >= 16) {
+        uint64_t w0, w1;
+        memcpy(&w0, str, 8);
+        memcpy(&w1, str + 8, 8);
+        c = _mm_crc32_u64(c, w0);
+        c = _mm_crc32_u64(c, w1);
+        str += 16;
+        len -= 16;
+    }
+    if (len >= 8) {
+        uint64_t w;
+        memcpy(&w, str, 8);
+        c = _mm_crc32_u64(c, w);
+        str += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)c;
+#else
+    while (len >= 16) {
+        uint32_t w[4];
+        memcpy(w, str, 16);
+        crc = _mm_crc32_u32(crc, w[0]);
+        crc = _mm_crc32_u32(crc, w[1]);
+        crc = _mm_crc32_u32(crc, w[2]);
+        crc = _mm_crc32_u32(crc, w[3]);
+        str += 16;
+        len -= 16;
+    }
+    while (len >= 8) {
+        uint32_t w[2];
+        memcpy(w, str, 8);
+        crc = _mm_crc32_u32(crc, w[0]);
+        crc = _mm_crc32_u32(crc, w[1]);
+        str += 8;
+        len -= 8;
+    }
+#endif
+    if (len >= 4) {
+        uint32_t w;
+        memcpy(&w, str, 4);
+        crc = _mm_crc32_u32(crc, w);
+        str += 4;
+        len -= 4;
+    }
+    while (len--) {
+        crc = _mm_crc32_u8(crc, (unsigned char)*str++);
+    }
+    return crc;
+}
+
+/**
+ * AVX2 equality of null terminated strings, 32 bytes per step.
+ * Bytes are compared one at a time while a 32-byte load would touch
+ * the next page of either string.
+ *
+ * @param l first string.
+ * @param r second string.
+ *
+ * @return Non-zero if equal, zero otherwise.
+ */
+NO_SANITIZE_ADDRESS __attribute__((target("avx2"))) static int
+avx2_equal(const char *l, const char *r) {
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (;;) {
+        if (STRKERNEL_CROSSES_PAGE(l + i, 32) || STRKERNEL_CROSSES_PAGE(r + i, 32)) {
+            size_t end = i + 32;
+            for (; i < end; i++) {
+                if (l[i] != r[i]) {
+                    return 0;
+                }
+                if (l[i] == '\0') {
+                    return 1;
+                }
+            }
+        } else {
+            __m256i a = _mm256_loadu_si256((const __m256i *)(l + i));
+            __m256i b = _mm256_loadu_si256((const __m256i *)(r + i));
+            /* first byte that differs or terminates `l` */
+            unsigned int mask =
+                ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b))
+                | (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, zero));
+            if (mask != 0) {
+                size_t k = i + (size_t)__builtin_ctz(mask);
+                return l[k] == r[k];
+            }
+            i += 32;
+        }
+    }
+}
+
+/**
+ * AVX2 equality of `len` bytes, 32 bytes per step.
+ *
+ * @param l first string.
+ * @param r second string.
+ * @param len number of bytes to compare.
+ *
+ * @return Non-zero if equal, zero otherwise.
+ */
+__attribute__((target("avx2"))) static int
+avx2_equal_n(const char *l, const char *r, size_t len) {
+    size_t i;
+    if (len < 32) {
+        return sse42_equal_n(l, r, len);
+    }
+    for (i = 0; i + 32 <= len; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(l + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(r + i));
+        if ((unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) != 0xFFFFFFFFU) {
+            return 0;
+        }
+    }
+    if (i < len) {
+        /* last (overlapping) block */
+        __m256i a = _mm256_loadu_si256((const __m256i *)(l + len - 32));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(r + len - 32));
+        if ((unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) != 0xFFFFFFFFU) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static const strkernel_ops sse42_kernel = {
+    "sse4.2", sse42_equal, sse42_equal_n, sse42_crc
+};
+
+static const strkernel_ops avx2_kernel = {
+    "avx2", avx2_equal, avx2_equal_n, sse42_crc
+};
+#endif /* USE_X86_KERNELS */
+
+/**
+ * Build the CRC-32C table and select the best kernel for the running CPU.
+ */
+static void
+strkernel_select(void) {
+    uint32_t i, j;
+    for (i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (j = 0; j < 8; j++) {
+            crc = (crc & 1) ? (crc >> 1) ^ STRKERNEL_CRC32C_POLY : crc >> 1;
+        }
+        crc32c_table[i] = crc;
+    }
+    kernel = &scalar_kernel;
+#ifdef USE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        kernel = &sse42_kernel;
+        if (__builtin_cpu_supports("avx2")) {
+            kernel = &avx2_kernel;
+        }
+    }
+#endif
+}
+
+/**
+ * Get the selected kernel.
+ *
+ * @return the selected kernel.
+ */
+static inline const strkernel_ops *
+strkernel_get(void) {
+    pthread_once(&kernel_once, strkernel_select);
+    return kernel;
+}
+
+/**
+ * Test whether two null terminated strings are equal.
+ *
+ * @param l first string (not NULL).
+ * @param r second string (not NULL).
+ *
+ * @return Non-zero if equal, zero otherwise.
+ */
+extern int
+strkernel_equal(const char *l, const char *r) {
+    if (l == r) {
+        return 1;
+    }
+    return strkernel_get()->equal(l, r);
+}
+
+/**
+ * Test whether two strings of known length are equal.
+ *
+ * @param l first string.
+ * @param l_len length of the first string.
+ * @param r second string.
+ * @param r_len length of the second string.
+ *
+ * @return Non-zero if equal, zero otherwise.
+ */
+extern int
+strkernel_equal_len(const char *l, size_t l_len, const char *r, size_t r_len) {
+    int result = 0;
+    if (l_len == r_len) {
+        if (l == r || l_len == 0) {
+            result++;
+        } else if (strkernel_get()->equal_n(l, r, l_len)) {
+            result++;
+        }
+    }
+    return result;
+}
+
+/**
+ * Hash a null terminated string.
+ *
+ * @param str string to hash (not NULL).
+ *
+ * @return hash value of the string.
+ */
+extern size_t
+strkernel_hash(const char *str) {
+    return strkernel_hash_len(str, strlen(str));
+}
+
+/**
+ * Hash a string of known length.
+ *
+ * @param str string to hash.
+ * @param len length of the string.
+ *
+ * @return hash value of the string.
+ */
+extern size_t
+strkernel_hash_len(const char *str, size_t len) {
+    uint32_t crc = ~strkernel_get()->crc(0xFFFFFFFFU, str, len);
+    /* spread the 32-bit CRC (and the length) over all bits of the result */
+    uint64_t h = ((uint64_t)crc ^ ((uint64_t)len << 32)) * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h ^ (h >> 32));
+}
+
+/**
+ * Get the name of the selected kernel ("avx2", "sse4.2" or "scalar").
+ *
+ * @return name of the selected kernel.
+ */
+extern const char *
+strkernel_name(void) {
+    return strkernel_get()->name;
+}
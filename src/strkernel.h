@@ -0,0 +1,93 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * String equality and hashing kernels used for name lookups.
+ *
+ * On x86 the kernel is selected once at run time: AVX2 compares 32 bytes
+ * per step, SSE4.2 compares 16 bytes per step and both hash 16 bytes per
+ * step with the crc32 instruction. Other targets (or builds defining
+ * CERIALIZER_NO_SIMD) use a portable scalar kernel. Hash values are the
+ * same whatever kernel is selected.
+ */
+
+#ifndef STRKERNEL_H_
+#define STRKERNEL_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * Test whether two null terminated strings are equal.
+ *
+ * @param l first string (not NULL).
+ * @param r second string (not NULL).
+ *
+ * @return Non-zero if equal, zero otherwise.
+ */
+extern int
+strkernel_equal(const char *l, const char *r);
+
+/**
+ * Test whether two strings of known length are equal.
+ *
+ * @param l first string.
+ * @param l_len length of the first string.
+ * @param r second string.
+ * @param r_len length of the second string.
+ *
+ * @return Non-zero if equal, zero otherwise.
+ */
+extern int
+strkernel_equal_len(const char *l, size_t l_len, const char *r, size_t r_len);
+
+/**
+ * Hash a null terminated string.
+ *
+ * @param str string to hash (not NULL).
+ *
+ * @return hash value of the string.
+ */
+extern size_t
+strkernel_hash(const char *str);
+
+/**
+ * Hash a string of known length.
+ *
+ * @param str string to hash.
+ * @param len length of the string.
+ *
+ * @return hash value of the string.
+ */
+extern size_t
+strkernel_hash_len(const char *str, size_t len);
+
+/**
+ * Get the name of the selected kernel ("avx2", "sse4.2" or "scalar").
+ *
+ * @return name of the selected kernel.
+ */
+extern const char *
+strkernel_name(void);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* STRKERNEL_H_ */
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Implementation of an unrolled single linked list, where every node
+ * is a 64-byte block holding several data pointers.
+ */
+
+#include <stdlib.h>
+
+#include "stdlib_util.h"
+#include "ulinkedlist.h"
+
+/**
+ * Create (and initialize) an unrolled linked list.
+ *
+ * @return a new unrolled linked list structure.
+ */
+extern ulinkedlist *
+ulinkedlist_create(void) {
+    ulinkedlist * list = (ulinkedlist *)SAFE_MALLOC(sizeof(ulinkedlist));
+    ulinkedlist_init(list);
+    return list;
+}
+
+/**
+ * Initialize an unrolled linked list.
+ *
+ * @param list unrolled linked list structure.
+ */
+extern void
+ulinkedlist_init(ulinkedlist *list) {
+    if (list != NULL) {
+        list->head = NULL;
+        list->tail = NULL;
+        list->size = 0;
+    }
+}
+
+/**
+ * Append data to the unrolled linked list.
+ *
+ * @param list unrolled linked list structure.
+ * @param data data to append.
+ */
+extern void
+ulinkedlist_append(ulinkedlist *list, void *data) {
+    if (list != NULL) {
+        ulinkedlist_node_t *tail = list->tail;
+        if (tail == NULL || tail->count == ULINKEDLIST_NODE_CAPACITY) {
+            /* last node block is full (or missing), chain a new one */
+            ulinkedlist_node_t *new_node =
+                (ulinkedlist_node_t *)SAFE_SLAB_ALLOC_WITH(NULL, sizeof(ulinkedlist_node_t));
+            new_node->next = NULL;
+            new_node->count = 0;
+            if (tail == NULL) {
+                list->head = new_node;
+            } else {
+                tail->next = new_node;
+            }
+            list->tail = new_node;
+            tail = new_node;
+        }
+        tail->data[tail->count++] = data;
+        list->size++;
+    }
+}
+
+/**
+ * Return an array containing all data of the provided unrolled linked list.
+ *
+ * @param list unrolled linked list structure to use.
+ *
+ * @return array containing all data of the provided unrolled linked list
+ *         structure (can be NULL if the list is empty or failed to
+ *         allocate enough memory).
+ */
+extern void **
+ulinkedlist_to_array(ulinkedlist *list) {
+    void ** array = NULL;
+    if (!ulinkedlist_empty(list)) {
+        /* do not use SAFE_MALLOC since it is user responsibility to free */
+        array = (void **)malloc(list->size * sizeof(void *));
+        if (array != NULL) {
+            size_t i = 0;
+            size_t j;
+            ulinkedlist_node_t *it = list->head;
+            while (it) {
+                for (j = 0; j < it->count; j++) {
+                    array[i++] = it->data[j];
+                }
+                it = it->next;
+            }
+        }
+    }
+    return array;
+}
+
+/**
+ * Tests whether the provided unrolled linked list is empty.
+ *
+ * @param list unrolled linked list structure to use.
+ *
+ * @return Non-zero if unrolled linked list is empty, zero otherwise.
+ */
+extern int
+ulinkedlist_empty(ulinkedlist *list) {
+    int result = 0;
+    if (list == NULL) {
+        result++;
+    } else {
+        if (list->size == 0) {
+            result++;
+        }
+    }
+    return result;
+}
+
+/**
+ * Free the unrolled linked list and all its nodes and data. Uses
+ * ulinkedlist_data_dealloc function passed.
+ * Note that in case ulinkedlist_data_dealloc was not provided,
+ * stored data remains intact(not free'd);
+ *
+ * @param list unrolled linked list structure.
+ * @param free_data data de-allocation function.
+ */
+extern void
+ulinkedlist_free(ulinkedlist *list, ulinkedlist_data_dealloc free_data) {
+    if (list != NULL) {
+        ulinkedlist_node_t *it = list->head;
+        while (it) {
+            ulinkedlist_node_t *next = it->next;
+            if (free_data != NULL) {
+                size_t j;
+                for (j = 0; j < it->count; j++) {
+                    free_data(it->data[j]);
+                }
+            }
+            SAFE_SLAB_FREE_WITH(NULL, it, sizeof(ulinkedlist_node_t));
+            it = next;
+        }
+        ulinkedlist_init(list);
+    }
+}
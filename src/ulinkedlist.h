@@ -0,0 +1,130 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Implementation of an unrolled single linked list, where every node
+ * is a 64-byte block holding several data pointers.
+ */
+
+#ifndef ULINKEDLIST_H_
+#define ULINKEDLIST_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/* size in bytes of an unrolled linked list node block (one cache line) */
+#define ULINKEDLIST_NODE_SIZE 64
+
+/* number of data pointers that fit in an unrolled linked list node block */
+#define ULINKEDLIST_NODE_CAPACITY \
+    ((ULINKEDLIST_NODE_SIZE - sizeof(void *) - sizeof(size_t)) / sizeof(void *))
+
+/**
+ * Function to free stored data pointers.
+ */
+typedef void (*ulinkedlist_data_dealloc)(void *data);
+
+/**
+ * Unrolled linked list node structure.
+ */
+typedef struct _ulinkedlist_node_struct {
+    /* Pointer to the next node */
+    struct _ulinkedlist_node_struct *next;
+    /* Number of data pointers stored in the node */
+    size_t count;
+    /* Data pointers of the current node */
+    void *data[ULINKEDLIST_NODE_CAPACITY];
+} ulinkedlist_node_t;
+
+/**
+ * Unrolled linked list structure.
+ */
+typedef struct {
+    /* Pointer to leading node */
+    ulinkedlist_node_t *head;
+    /* Number of data pointers stored in the unrolled linked list */
+    size_t size;
+    /* Pointer to last node */
+    ulinkedlist_node_t *tail;
+} ulinkedlist;
+
+/**
+ * Create (and initialize) an unrolled linked list.
+ *
+ * @return a new unrolled linked list structure.
+ */
+extern ulinkedlist *
+ulinkedlist_create(void);
+
+/**
+ * Initialize an unrolled linked list.
+ *
+ * @param list unrolled linked list structure.
+ */
+extern void
+ulinkedlist_init(ulinkedlist *list);
+
+/**
+ * Append data to the unrolled linked list.
+ *
+ * @param list unrolled linked list structure.
+ * @param data data to append.
+ */
+extern void
+ulinkedlist_append(ulinkedlist *list, void *data);
+
+/**
+ * Return an array containing all data of the provided unrolled linked list.
+ *
+ * @param list unrolled linked list structure to use.
+ *
+ * @return array containing all data of the provided unrolled linked list
+ *         structure (can be NULL if the list is empty or failed to
+ *         allocate enough memory).
+ */
+extern void **
+ulinkedlist_to_array(ulinkedlist *list);
+
+/**
+ * Tests whether the provided unrolled linked list is empty.
+ *
+ * @param list unrolled linked list structure to use.
+ *
+ * @return Non-zero if unrolled linked list is empty, zero otherwise.
+ */
+extern int
+ulinkedlist_empty(ulinkedlist *list);
+
+/**
+ * Free the unrolled linked list and all its nodes and data. Uses
+ * ulinkedlist_data_dealloc function passed.
+ * Note that in case ulinkedlist_data_dealloc was not provided,
+ * stored data remains intact(not free'd);
+ *
+ * @param list unrolled linked list structure.
+ * @param free_data data de-allocation function.
+ */
+extern void
+ulinkedlist_free(ulinkedlist *list, ulinkedlist_data_dealloc free_data);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* ULINKEDLIST_H_ */
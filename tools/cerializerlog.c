@@ -0,0 +1,217 @@
+/*
+ * Copyright 2016 Dimitrios Dimakos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * Utility program which renders a binary log (see log_binary.h) as
+ * text log lines, using the format dictionary written along with it.
+ *
+ * usage: cerializerlog -d <dictionary file> -f <binary log file>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cerializer.h"
+#include "dynmessage.h"
+#include "dynmessage_cerializer.h"
+#include "log_binary.h"
+
+/* 'Dynamic Message Start' identifier */
+#define DYN_MSG_START 1044266557
+
+/* largest format ID accepted from a dictionary */
+#define MAX_FORMAT_ID (1UL << 20)
+
+/* initial length of the rendered log line buffer (grown for longer lines) */
+#define LINE_LEN 4096
+
+/**
+ * Tests whether a provided reference is null an exits program execution if so,
+ * printing on screen a related error message.
+ *
+ * @param ptr the provided reference to be tested.
+ * @param message error message.
+ */
+static void
+exit_if_null(void * ptr, char * message) {
+    if (ptr == NULL) {
+        fprintf(stderr, "[ERROR]: %s\n", message);
+        exit(-1);
+    }
+}
+
+/**
+ * Read a whole file into memory.
+ *
+ * @param fname name of the file.
+ * @param len length of the file contents (set).
+ *
+ * @return file contents (to be freed), NULL on failure.
+ */
+static unsigned char *
+read_file(const char *fname, long *len) {
+    unsigned char *data = NULL;
+    FILE *f_ptr = fopen(fname, "rb");
+    if (f_ptr == NULL) {
+        fprintf(stderr, "[ERROR]: cannot open %s for reading\n", fname);
+        return NULL;
+    }
+    fseek(f_ptr, 0, SEEK_END);
+    *len = ftell(f_ptr);
+    fseek(f_ptr, 0, SEEK_SET);
+    data = (unsigned char *)malloc(*len > 0 ? *len : 1);
+    if (data != NULL && fread(data, 1, *len, f_ptr) != (size_t)*len) {
+        fprintf(stderr, "[ERROR]: cannot read %s\n", fname);
+        free(data);
+        data = NULL;
+    }
+    fclose(f_ptr);
+    return data;
+}
+
+/**
+ * Get the next record of a sequence of serialized dynamic messages.
+ *
+ * @param data sequence of serialized dynamic messages.
+ * @param len length of the sequence.
+ * @param offset offset of the next record (advanced past it).
+ *
+ * @return de-serialized record (to be destroyed), NULL at the end of the
+ *         sequence or on a malformed record.
+ */
+static dynamicmessage *
+next_record(unsigned char *data, long len, long *offset) {
+    long record_len;
+    if (len - *offset < 8) {
+        return NULL;
+    }
+    if ((unsigned long)deserialize_uint32(data + *offset) != DYN_MSG_START) {
+        fprintf(stderr, "[ERROR]: malformed record at offset %ld\n", *offset);
+        return NULL;
+    }
+    record_len = (long)deserialize_uint32(data + *offset + 4);
+    if (record_len < 8 || record_len > len - *offset) {
+        fprintf(stderr, "[ERROR]: truncated record at offset %ld\n", *offset);
+        return NULL;
+    }
+    *offset += record_len;
+    return (dynamicmessage *)dynmessage_deserialize_bin(data + *offset - record_len, (int)record_len);
+}
+
+/**
+ * Print on screen instructions on how to use this tool.
+ *
+ * @param tool_name name of the tool.
+ */
+static void
+print_usage(char * tool_name) {
+    fprintf(stdout, "usage: %s -d <dictionary file> -f <binary log file>\n", tool_name);
+    exit(1);
+}
+
+/**
+ * Main function.
+ */
+int
+main(int argc, char ** argv) {
+    char *dict_fname = NULL;
+    char *log_fname = NULL;
+    unsigned char *dict, *log;
+    long dict_len, log_len, offset;
+    char **formats = NULL;
+    unsigned long format_count = 0;
+    dynamicmessage *record;
+    char *line;
+    size_t line_len = LINE_LEN;
+    int i;
+
+    /* validate command line arguments */
+    for (i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-d") == 0) {
+            dict_fname = argv[i + 1];
+        } else if (strcmp(argv[i], "-f") == 0) {
+            log_fname = argv[i + 1];
+        }
+    }
+    if (argc != 5 || dict_fname == NULL || log_fname == NULL) {
+        print_usage(argv[0]);
+    }
+    if ((dict = read_file(dict_fname, &dict_len)) == NULL
+        || (log = read_file(log_fname, &log_len)) == NULL) {
+        exit(1);
+    }
+
+    /* format dictionary */
+    offset = 0;
+    while ((record = next_record(dict, dict_len, &offset)) != NULL) {
+        dyn_field id, format;
+        dynmessage_get_field(record, "fmt", &id);
+        dynmessage_get_field(record, "format", &format);
+        if (id.type == UNSIGNED_INT32_TYPE && format.type == STRING_TYPE) {
+            unsigned long fmt = id.value->uint32_value;
+            if (fmt > MAX_FORMAT_ID) {
+                fprintf(stderr, "[ERROR]: format ID %lu out of range, skipped\n", fmt);
+                dynmessage_destroy(record);
+                continue;
+            }
+            if (fmt >= format_count) {
+                unsigned long count = fmt + 1;
+                formats = (char **)realloc(formats, count * sizeof(char *));
+                exit_if_null(formats, "unable to allocate enough memory!");
+                memset(formats + format_count, 0, (count - format_count) * sizeof(char *));
+                format_count = count;
+            }
+            free(formats[fmt]);
+            formats[fmt] = strdup(format.value->string_value);
+            exit_if_null(formats[fmt], "unable to allocate enough memory!");
+        }
+        dynmessage_destroy(record);
+    }
+
+    /* log records */
+    line = (char *)malloc(line_len);
+    exit_if_null(line, "unable to allocate enough memory!");
+    offset = 0;
+    while ((record = next_record(log, log_len, &offset)) != NULL) {
+        dyn_field id;
+        const char *format = NULL;
+        dynmessage_get_field(record, "fmt", &id);
+        if (id.type == UNSIGNED_INT32_TYPE && id.value->uint32_value < format_count) {
+            format = formats[id.value->uint32_value];
+        }
+        if (format == NULL) {
+            format = "<unknown format>";
+        }
+        /* a line filling the whole buffer may be truncated, retry larger */
+        while (log_binary_render(record, format, line, line_len) == line_len - 1) {
+            line_len *= 2;
+            free(line);
+            line = (char *)malloc(line_len);
+            exit_if_null(line, "unable to allocate enough memory!");
+        }
+        fprintf(stdout, "%s\n", line);
+        dynmessage_destroy(record);
+    }
+
+    for (i = 0; (unsigned long)i < format_count; i++) {
+        free(formats[i]);
+    }
+    free(formats);
+    free(line);
+    free(dict);
+    free(log);
+    exit(0);
+}
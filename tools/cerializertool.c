@@ -50,6 +50,19 @@
  * FLOAT32_TYPE
  * FLOAT64_TYPE
  * STRING_TYPE
+ *
+ * Each message gets a schema fingerprint (e.g. C_MY_MESSAGE_FINGERPRINT,
+ * see dynmessage_fingerprint): messages serialized with their fingerprint
+ * (c_serialize_<msg>_with_fingerprint) are recognized with a single compare.
+ *
+ * A dispatcher of all the messages of the definition file is also
+ * generated (dmd_dispatch_h, dmd_dispatch_c): it maps the message name
+ * (with a perfect hash) or a message type ID to a message handler and
+ * decodes the message with its direct de-serialization function.
+ *
+ * With the -soa option, a structure of arrays (columnar) type is also
+ * generated for each message (e.g. my_message_soa), along with functions
+ * to append messages to it and to (de)serialize it one column at a time.
  */
 
 #include <stdio.h>
@@ -57,7 +70,10 @@
 #include <string.h>
 #include <time.h>
 
+#include "dynmessage_cerializer.h"
 #include "ezxml.h"
+#include "stdlib_util.h"
+#include "strbuf.h"
 
 #define H_SET_FNAME_POST_FIX "_set_h"
 #define H_SET_FNAME_POST_FIX_LEN 6
@@ -68,6 +84,9 @@
 #define CV_C_SET_FNAME_POST_FIX  "_set_c_c"
 #define CV_C_SET_FNAME_POST_FIX_LEN 8
 
+#define DISPATCH_H_FNAME "dmd_dispatch_h"
+#define DISPATCH_C_FNAME "dmd_dispatch_c"
+
 #ifdef TEST
 /**
  * Function to test the implementation of cerializertool.
@@ -84,21 +103,9 @@ typedef struct _message_info_struct_ {
     int field_count; /* count of message fields */
 } message_info_struct;
 
-/* allowed field value types (enumerated representation) */
-typedef enum _allowed_value_types {
-    ENUMERATION_TYPE,
-    INT8_TYPE,
-    UNSIGNED_INT8_TYPE,
-    INT16_TYPE,
-    UNSIGNED_INT16_TYPE,
-    INT32_TYPE,
-    UNSIGNED_INT32_TYPE,
-    INT64_TYPE,
-    UNSIGNED_INT64_TYPE,
-    FLOAT32_TYPE,
-    FLOAT64_TYPE,
-    STRING_TYPE,
-} allowed_value_types;
+/* allowed field value types (enumerated representation): the dynamic message
+ * field types (see dynmessage.h), but NO_TYPE */
+typedef dyn_field_type allowed_value_types;
 
 /* allowed field value types (string representation) */
 static char * allowed_value_types_text[] = {
@@ -148,6 +155,89 @@ static char * allowed_value_types_cunion[] = {
     "string_value"
 };
 
+/* allowed field value types (serialized value size, zero if variable) */
+static int allowed_value_types_size[] = {
+    4,
+    1,
+    1,
+    2,
+    2,
+    4,
+    4,
+    8,
+    8,
+    4,
+    8,
+    0
+};
+
+/* allowed field value types (direct serialization statement, provided the
+ * value offset and the field name, see generate_serializer) */
+static char * allowed_value_types_serialize[] = {
+    "serialize_int32(data + %s, object->%s);\n",
+    "data[%s] = (unsigned char)object->%s;\n",
+    "data[%s] = object->%s;\n",
+    "serialize_int16(data + %s, object->%s);\n",
+    "serialize_int16(data + %s, object->%s);\n",
+    "serialize_int32(data + %s, object->%s);\n",
+    "serialize_int32(data + %s, (unsigned long)object->%s);\n",
+    "serialize_int64(data + %s, (unsigned long long)object->%s);\n",
+    "serialize_int64(data + %s, object->%s);\n",
+    "serialize_float32(data + %s, object->%s);\n",
+    "serialize_float64(data + %s, object->%s);\n",
+    ""
+};
+
+/* allowed field value types (direct de-serialization statement, provided the
+ * destination, the field name and the value offset, see generate_decoder) */
+static char * allowed_value_types_deserialize[] = {
+    "%s%s = (unsigned int)deserialize_int32(data + %s);\n",
+    "%s%s = (char)data[%s];\n",
+    "%s%s = data[%s];\n",
+    "%s%s = deserialize_int16(data + %s);\n",
+    "%s%s = (int)deserialize_uint16(data + %s);\n",
+    "%s%s = (int)deserialize_int32(data + %s);\n",
+    "%s%s = (long)deserialize_uint32(data + %s);\n",
+    "%s%s = deserialize_int64(data + %s);\n",
+    "%s%s = deserialize_uint64(data + %s);\n",
+    "%s%s = (float)deserialize_float32(data + %s);\n",
+    "%s%s = deserialize_float64(data + %s);\n",
+    ""
+};
+
+/* allowed field value types (c value of the big-endian bytes in an unsigned long
+ * long named value, see generate_soa; single byte and floating point columns
+ * are handled apart) */
+static char * allowed_value_types_soa_decode[] = {
+    "(unsigned int)value",
+    "",
+    "",
+    "(int)(value ^ 0x8000) - 0x8000",
+    "(int)value",
+    "(int)((long long)(value ^ 0x80000000ULL) - 0x80000000LL)",
+    "(long)value",
+    "(long long)value",
+    "value",
+    "",
+    "",
+    ""
+};
+
+/* generate structure of arrays types along with message structures (-soa) */
+static int generate_soa_types = 0;
+
+/* 'Dynamic Message Start' identifier (see dynmessage_cerializer.c) */
+#define DYN_MSG_START 1044266557
+
+/* serialized dynamic message header length, without the message name */
+#define DYN_MSG_HEAD_FIXED_LEN 16
+
+/* serialized dynamic field header length, without the field name */
+#define DYN_FIELD_FIXED_LEN 16
+
+/* minimum serialized dynamic message length (see dynmessage_serialize_bin) */
+#define DYN_MSG_MIN_LEN 32
+
 /**
  * Test whether the provided character is an alphabet letter.
  *
@@ -253,6 +343,95 @@ get_field_value_type_union_text(char * field_value_type) {
     return "UNSUPPORTED";
 }
 
+/**
+ * Function to get the index (allowed_value_types) of the provided field value type.
+ *
+ * @param field_value_type field value type(represented as string).
+ * @return index of the provided field value type, -1 if not supported.
+ */
+static int
+get_field_value_type_index(char * field_value_type) {
+    int i;
+    for (i=0;i<12;i++) {
+        if (strcmp(allowed_value_types_text[i], field_value_type) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Function to append to generated source code the initializer of a
+ * big-endian 32-bit integer (as four bytes).
+ *
+ * @param buf buffer collecting the generated source code.
+ * @param value the integer value.
+ * @param comment comment describing the value.
+ * @param last Non-zero if the value ends the initializer.
+ */
+static void
+append_int32_bytes(strbuf *buf, unsigned long value, char *comment, int last) {
+    strbuf_appendf(buf, "    0x%02lx, 0x%02lx, 0x%02lx, 0x%02lx%s /* %s */\n",
+        (value >> 24) & 0xff, (value >> 16) & 0xff, (value >> 8) & 0xff, value & 0xff,
+        last ? "" : ",", comment);
+}
+
+/**
+ * Function to append to generated source code the initializer of the
+ * characters of a name (eight bytes per line).
+ *
+ * @param buf buffer collecting the generated source code.
+ * @param name the name.
+ */
+static void
+append_name_bytes(strbuf *buf, char *name) {
+    int len = strlen(name);
+    int i;
+    for (i=0; i<len; i++) {
+        strbuf_appendf(buf, "%s0x%02x,%s", (i % 8 == 0) ? "    " : " ",
+            (unsigned char)name[i], (i % 8 == 7 || i == len - 1) ? "\n" : "");
+    }
+}
+
+/**
+ * Function to append to generated source code the initializer of a
+ * number of zero bytes.
+ *
+ * @param buf buffer collecting the generated source code.
+ * @param n number of bytes.
+ * @param comment comment describing the bytes.
+ * @param last Non-zero if the bytes end the initializer.
+ */
+static void
+append_zero_bytes(strbuf *buf, int n, char *comment, int last) {
+    int i;
+    strbuf_appendf(buf, "   ");
+    for (i=0; i<n; i++) {
+        strbuf_appendf(buf, " 0x00%s", (i < n - 1 || !last) ? "," : "");
+    }
+    strbuf_appendf(buf, " /* %s */\n", comment);
+}
+
+/**
+ * Function to get the upper case version of a c name (for macro names).
+ *
+ * @param name the c name.
+ *
+ * @return upper case name (to be freed).
+ */
+static char *
+get_c_upper_name(char * name) {
+    char * upper_name = strdup(name);
+    int i;
+    exit_if_null(upper_name, "unable to allocate enough memory!");
+    for (i=0; upper_name[i] != '\0'; i++) {
+        if (upper_name[i] >= 'a' && upper_name[i] <= 'z') {
+            upper_name[i] = upper_name[i] - 'a' + 'A';
+        }
+    }
+    return upper_name;
+}
+
 /**
  * Function to get a proper name for a c language element, taking into
  * account the name specified from the user. In case there are no
@@ -340,37 +519,38 @@ open_standard_gen_files(FILE **h_fptr, FILE **cv_h_fptr, FILE **cv_c_fptr, char
  * Function to prepare standard generated files that will contain the source code for the
  * given message name.
  *
- * @param h_fptr header file containing the c structure of the message.
- * @param cv_h_fptr header file that will contain the declaration of convenience
+ * @param h_buf buffer collecting the header file containing the c structure of the message.
+ * @param cv_h_buf buffer collecting the header file that will contain the declaration of convenience
  *        (de)serialization functions for the message.
- * @param cv_c_fptr header file that will contain the implementation of convenience
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
  *        (de)serialization functions for the message.
  * @param message_name name of the message.
  */
 static void
-prepare_standard_gen_files(FILE *h_fptr, FILE *cv_h_fptr, FILE *cv_c_fptr, char * message_name) {
+prepare_standard_gen_files(strbuf *h_buf, strbuf *cv_h_buf, strbuf *cv_c_buf, char * message_name) {
     time_t timeval = time(NULL);
+    char *upper_name = get_c_upper_name(message_name);
     /* common code for message c structure definition */
-    fprintf(h_fptr, "/**\n * Definition of %s message.\n * Generated by crealizertool at %s */\n\n",
+    strbuf_appendf(h_buf, "/**\n * Definition of %s message.\n * Generated by crealizertool at %s */\n\n",
         message_name, ctime(&timeval));
 
-    fprintf(h_fptr,
+    strbuf_appendf(h_buf,
         "#ifndef _%s_set_h_\n#define _%s_set_h_\n\n#ifdef  __cplusplus\nextern \"C\" {\n#endif\n",
         message_name, message_name);
 
     /* header for convenience functions */
-    fprintf(cv_h_fptr,
+    strbuf_appendf(cv_h_buf,
         "\n/**\n * Convenience functions to send/receive a serialized %s message.\n"
         " * Generated by crealizertool at %s */\n\n",
         message_name,  ctime(&timeval));
-    fprintf(cv_h_fptr,
+    strbuf_appendf(cv_h_buf,
         "#ifndef _%s_set_c_h_\n#define _%s_set_c_h_\n\n#ifdef  __cplusplus\nextern \"C\" {\n#endif\n",
         message_name, message_name);
-    fprintf(cv_h_fptr, "\n#include \"%s_set.h\"\n", message_name);
-    fprintf(cv_h_fptr, "#include \"cerializer.h\"\n");
-    fprintf(cv_h_fptr, "#include \"dynmessage.h\"\n");
+    strbuf_appendf(cv_h_buf, "\n#include \"%s_set.h\"\n", message_name);
+    strbuf_appendf(cv_h_buf, "#include \"cerializer.h\"\n");
+    strbuf_appendf(cv_h_buf, "#include \"dynmessage.h\"\n");
 
-    fprintf(cv_h_fptr,
+    strbuf_appendf(cv_h_buf,
         "\n/**\n"
         " * Test whether the provided dynamicmessage represents a %s instance.\n"
         " *\n"
@@ -381,7 +561,7 @@ prepare_standard_gen_files(FILE *h_fptr, FILE *cv_h_fptr, FILE *cv_c_fptr, char
         "extern int\n"
         "c_instance_of_%s(dynamicmessage *dm);\n", message_name, message_name);
 
-    fprintf(cv_h_fptr,
+    strbuf_appendf(cv_h_buf,
         "\n/**\n"
         " * Convenience function to serialize a %s message object\n"
         " * into a sequence of bytes(as a dynamicmessage).\n"
@@ -396,7 +576,23 @@ prepare_standard_gen_files(FILE *h_fptr, FILE *cv_h_fptr, FILE *cv_c_fptr, char
         "c_serialize_%s(%s *object, serialized_data_info *serdi);\n",
         message_name, message_name, message_name, message_name, message_name);
 
-    fprintf(cv_h_fptr,
+    strbuf_appendf(cv_h_buf,
+        "\n/**\n"
+        " * Convenience function to serialize a %s message object\n"
+        " * into a sequence of bytes(as a dynamicmessage), preceded by the\n"
+        " * schema fingerprint of the message (C_%s_FINGERPRINT).\n"
+        " *\n"
+        " * @param object reference to the %s message to serialize(not NULL).\n"
+        " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
+        " *              to store the serialized %s message object representation.\n"
+        " *\n"
+        " * @return Non-zero upon successful serialization, zero otherwise.\n"
+        " */\n"
+        "extern int\n"
+        "c_serialize_%s_with_fingerprint(%s *object, serialized_data_info *serdi);\n",
+        message_name, upper_name, message_name, message_name, message_name, message_name);
+
+    strbuf_appendf(cv_h_buf,
         "\n/**\n"
         " * Convenience function to deserialize a sequence of bytes representing\n"
         " * a %s message (as a dynamicmessage).\n"
@@ -404,14 +600,50 @@ prepare_standard_gen_files(FILE *h_fptr, FILE *cv_h_fptr, FILE *cv_c_fptr, char
         " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
         " *        containing the serialized %s message object.\n"
         " * @param object reference to the deserialized %s message(not NULL).\n"
-          " *\n"
+        " *        String field values are allocated (SAFE_MALLOC) and owned by the caller.\n"
+        " *\n"
         " * @return Non-zero upon successful de-serialization, zero otherwise.\n"
         " */\n"
         "extern int\n"
         "c_deserialize_%s(serialized_data_info *serdi, %s *object);\n",
         message_name, message_name, message_name, message_name, message_name);
 
-    fprintf(cv_h_fptr,
+    strbuf_appendf(cv_h_buf,
+        "\n/**\n"
+        " * Convenience function to serialize an array of %s message objects\n"
+        " * into a single sequence of bytes: the number of messages (4 bytes),\n"
+        " * followed by each message (as a dynamicmessage).\n"
+        " *\n"
+        " * @param objects array of the %s messages to serialize(not NULL).\n"
+        " * @param n number of messages in the array.\n"
+        " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
+        " *              to store the serialized %s message objects representation.\n"
+        " *\n"
+        " * @return Non-zero upon successful serialization, zero otherwise.\n"
+        " */\n"
+        "extern int\n"
+        "c_serialize_%s_array(%s *objects, int n, serialized_data_info *serdi);\n",
+        message_name, message_name, message_name, message_name, message_name);
+
+    strbuf_appendf(cv_h_buf,
+        "\n/**\n"
+        " * Convenience function to deserialize a sequence of bytes representing\n"
+        " * an array of %s messages (see c_serialize_%s_array).\n"
+        " *\n"
+        " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
+        " *        containing the serialized %s message objects.\n"
+        " * @param objects reference to the deserialized array of %s messages(not NULL).\n"
+        " *        The array (NULL if empty) and string field values are allocated\n"
+        " *        (SAFE_MALLOC) and owned by the caller.\n"
+        " * @param n reference to the number of deserialized messages(not NULL).\n"
+        " *\n"
+        " * @return Non-zero upon successful de-serialization, zero otherwise.\n"
+        " */\n"
+        "extern int\n"
+        "c_deserialize_%s_array(serialized_data_info *serdi, %s **objects, int *n);\n",
+        message_name, message_name, message_name, message_name, message_name, message_name);
+
+    strbuf_appendf(cv_h_buf,
         "\n/**\n"
         " * Convenience function to convert a %s message object\n"
         " * into a dynamic message object.\n"
@@ -426,7 +658,7 @@ prepare_standard_gen_files(FILE *h_fptr, FILE *cv_h_fptr, FILE *cv_c_fptr, char
         "c_conv_%s_2dm(%s *object, dynamicmessage *dm);\n",
         message_name, message_name, message_name, message_name, message_name);
 
-    fprintf(cv_h_fptr,
+    strbuf_appendf(cv_h_buf,
         "\n/**\n"
         " * Convenience function to convert dynamic message into\n"
         " * a %s message object.\n"
@@ -442,93 +674,364 @@ prepare_standard_gen_files(FILE *h_fptr, FILE *cv_h_fptr, FILE *cv_c_fptr, char
         message_name, message_name, message_name, message_name, message_name);
 
     /* implementation for convenience functions */
-    fprintf(cv_c_fptr,
+    strbuf_appendf(cv_c_buf,
         "\n/**\n * Convenience functions to send/receive a serialized %s message.\n"
         " * Generated by crealizertool at %s */\n\n",
         message_name,  ctime(&timeval));
-    fprintf(cv_c_fptr, "#include <string.h>\n\n");
-    fprintf(cv_c_fptr, "#include \"%s_set_c.h\"\n", message_name);
-    fprintf(cv_c_fptr, "#include \"cerializer.h\"\n");
-    fprintf(cv_c_fptr, "#include \"dynmessage.h\"\n");
-    fprintf(cv_c_fptr, "#include \"dynmessage_cerializer.h\"\n");
+    strbuf_appendf(cv_c_buf, "#include <limits.h>\n#include <string.h>\n\n");
+    strbuf_appendf(cv_c_buf, "#include \"%s_set_c.h\"\n", message_name);
+    strbuf_appendf(cv_c_buf, "#include \"cerializer.h\"\n");
+    strbuf_appendf(cv_c_buf, "#include \"dynmessage.h\"\n");
+    strbuf_appendf(cv_c_buf, "#include \"dynmessage_cerializer.h\"\n");
+    strbuf_appendf(cv_c_buf, "#include \"stdlib_util.h\"\n");
+    free(upper_name);
 }
 
 /**
- * Function to generate the implementation source code for the given message name.
+ * Function to get the serialized length of the provided message, without
+ * the values of its string fields.
  *
- * @param h_fptr header file containing the c structure of the message.
- * @param cv_c_fptr header file that will contain the implementation of convenience
+ * @param message_info reference to message information structure.
+ *
+ * @return serialized length of the message without string field values.
+ */
+static int
+get_fixed_serialized_len(message_info_struct *message_info) {
+    int result = DYN_MSG_HEAD_FIXED_LEN + strlen(message_info->message_name);
+    int i;
+    for (i=0; i<message_info->field_count; i++) {
+        int type = get_field_value_type_index(message_info->field_types[i]);
+        result += DYN_FIELD_FIXED_LEN + strlen(message_info->field_names[i])
+            + allowed_value_types_size[type];
+    }
+    return result;
+}
+
+/**
+ * Test whether the provided message has a fixed serialized size, known at
+ * generation time (no string fields), hence a constant wire layout.
+ *
+ * @param message_info reference to message information structure.
+ *
+ * @return Non-zero if the message has a constant wire layout, zero otherwise.
+ */
+static int
+is_fixed_size(message_info_struct *message_info) {
+    int result = 0;
+    int i;
+    if (message_info->field_count > 0
+        && get_fixed_serialized_len(message_info) > DYN_MSG_MIN_LEN) {
+        result++;
+        for (i=0; i<message_info->field_count; i++) {
+            if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+                result = 0;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * Function to generate the constant wire layout of the given fixed size
+ * message: its serialized length and field value offsets (as macros), and
+ * a serialized message template with all field values zero.
+ *
+ * @param cv_h_buf buffer collecting the header file that will contain the declaration of convenience
+ *        (de)serialization functions for the message.
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
  *        (de)serialization functions for the message.
  * @param message_info reference to message information structure.
  */
 static void
-generate_implementation(FILE *h_fptr, FILE *cv_c_fptr, message_info_struct *message_info) {
+generate_fixed_wire_layout(strbuf *cv_h_buf, strbuf *cv_c_buf, message_info_struct *message_info) {
+    char *name = message_info->message_name;
+    char *upper_name = get_c_upper_name(name);
+    int offset = DYN_MSG_HEAD_FIXED_LEN + strlen(name);
     int i;
-    /* definition of the c structure for the message */
-    fprintf(h_fptr, "\n/* structure to store %s message information */\n"
-        "typedef struct _%s_struct_ {\n", message_info->message_name, message_info->message_name);
+    strbuf_appendf(cv_h_buf,
+        "\n/* serialized length of a %s message (all fields have a fixed size) */\n"
+        "#define C_%s_SERIALIZED_LEN %d\n"
+        "\n/* offsets of the field values of a serialized %s message */\n",
+        name, upper_name, get_fixed_serialized_len(message_info), name);
+    strbuf_appendf(cv_c_buf,
+        "\n/* serialized %s message, all field values zero */\n"
+        "static const unsigned char c_%s_template[C_%s_SERIALIZED_LEN] = {\n",
+        name, name, upper_name);
+    append_int32_bytes(cv_c_buf, DYN_MSG_START, "'Dynamic Message Start'", 0);
+    append_int32_bytes(cv_c_buf, get_fixed_serialized_len(message_info), "message length", 0);
+    append_int32_bytes(cv_c_buf, strlen(name), "message name length", 0);
+    append_name_bytes(cv_c_buf, name);
+    append_int32_bytes(cv_c_buf, message_info->field_count, "number of fields", 0);
     for (i=0; i<message_info->field_count; i++) {
-        fprintf(h_fptr, "    %s %s;\n",
-            get_field_value_type_text(message_info->field_types[i]), message_info->field_names[i]);
+        char *field_name = message_info->field_names[i];
+        char *upper_field_name = get_c_upper_name(field_name);
+        int type = get_field_value_type_index(message_info->field_types[i]);
+        int size = allowed_value_types_size[type];
+        char comment[strlen(field_name) + 7];
+        offset += DYN_FIELD_FIXED_LEN + strlen(field_name);
+        strbuf_appendf(cv_h_buf, "#define C_%s_%s_OFFSET %d\n", upper_name, upper_field_name, offset);
+        append_int32_bytes(cv_c_buf, DYN_FIELD_FIXED_LEN + strlen(field_name) + size, "field length", 0);
+        append_int32_bytes(cv_c_buf, strlen(field_name), "field name length", 0);
+        append_name_bytes(cv_c_buf, field_name);
+        append_int32_bytes(cv_c_buf, type, "field type", 0);
+        append_int32_bytes(cv_c_buf, size, "field value length", 0);
+        sprintf(comment, "%s value", field_name);
+        append_zero_bytes(cv_c_buf, size, comment, i == message_info->field_count - 1);
+        offset += size;
+        free(upper_field_name);
     }
-    fprintf(h_fptr, "} %s;\n", message_info->message_name);
+    strbuf_appendf(cv_c_buf, "};\n");
+    free(upper_name);
+}
 
-    fprintf(cv_c_fptr,
+/**
+ * Function to generate the encoding function of the given fixed size
+ * message, writing a message object into a buffer of constant size.
+ *
+ * @param cv_h_buf buffer collecting the header file that will contain the declaration of convenience
+ *        (de)serialization functions for the message.
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
+ *        (de)serialization functions for the message.
+ * @param message_info reference to message information structure.
+ */
+static void
+generate_fixed_encoder(strbuf *cv_h_buf, strbuf *cv_c_buf, message_info_struct *message_info) {
+    char *name = message_info->message_name;
+    char *upper_name = get_c_upper_name(name);
+    strbuf doc;
+    int i;
+    strbuf_init(&doc);
+    strbuf_appendf(&doc,
         "\n/**\n"
-        " * Test whether the provided dynamicmessage represents a %s instance.\n"
+        " * Convenience function to encode a %s message object into a buffer\n"
+        " * (as a serialized dynamicmessage).\n"
         " *\n"
-        " * @param dm reference to the dynamicmessage structure(not NULL).\n"
+        " * @param object reference to the %s message to encode(not NULL).\n"
+        " * @param data buffer of C_%s_SERIALIZED_LEN bytes(not NULL).\n"
+        " */\n"
+        "extern void\n",
+        name, name, upper_name);
+    strbuf_appendf(cv_h_buf, "%s" "c_encode_%s(%s *object, unsigned char *data);\n",
+        doc.data, name, name);
+    strbuf_appendf(cv_c_buf, "%s" "c_encode_%s(%s *object, unsigned char *data) {\n"
+        "    memcpy(data, c_%s_template, C_%s_SERIALIZED_LEN);\n",
+        doc.data, name, name, name, upper_name);
+    for (i=0; i<message_info->field_count; i++) {
+        char *field_name = message_info->field_names[i];
+        char *upper_field_name = get_c_upper_name(field_name);
+        int type = get_field_value_type_index(message_info->field_types[i]);
+        int len = strlen(upper_name) + strlen(upper_field_name) + 11;
+        char offset[len];
+        sprintf(offset, "C_%s_%s_OFFSET", upper_name, upper_field_name);
+        strbuf_appendf(cv_c_buf, "    ");
+        strbuf_appendf(cv_c_buf, allowed_value_types_serialize[type], offset, field_name);
+        free(upper_field_name);
+    }
+    strbuf_appendf(cv_c_buf, "}\n");
+    strbuf_free(&doc);
+    free(upper_name);
+}
+
+/**
+ * Function to generate the layout test function of the given fixed size
+ * message, comparing all header bytes of a serialized message against the
+ * message template.
+ *
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
+ *        (de)serialization functions for the message.
+ * @param message_info reference to message information structure.
+ */
+static void
+generate_fixed_layout_check(strbuf *cv_c_buf, message_info_struct *message_info) {
+    char *name = message_info->message_name;
+    char *upper_name = get_c_upper_name(name);
+    int offset = DYN_MSG_HEAD_FIXED_LEN + strlen(name);
+    int i;
+    strbuf_appendf(cv_c_buf,
+        "\n/**\n"
+        " * Test whether a serialized %s message is laid out as c_encode_%s does.\n"
         " *\n"
-        " * @return Non-zero if test succeeds, zero otherwise.\n"
+        " * @param data the serialized %s message.\n"
+        " * @param data_len length in bytes of the data.\n"
+        " *\n"
+        " * @return Non-zero if the data is laid out as expected, zero otherwise.\n"
         " */\n"
-        "extern int\n"
-        "c_instance_of_%s(dynamicmessage *dm){\n"
-        "    int ret = 0;\n"
-        "\n"
-        "    if (dm) {\n"
-        "        if (dm->name) {\n"
-        "            if (strcmp((const char *)dm->name, \"%s\") == 0\n"
-        "                && dm->field_count > 0) {\n"
-        "                ret++;\n"
-        "            }\n"
-        "            if (ret) {\n"
-        "                ret = dm->field_count == %d;\n"
-        "            }\n",
-        message_info->message_name, message_info->message_name,
-        message_info->message_name, message_info->field_count);
-    if (message_info->field_count > 0) {
-        fprintf(cv_c_fptr,
-            "            if (ret) {\n"
-            "                dyn_field field;\n"
-            "                int error = 0;\n\n"
-            "                ret = 0;\n");
+        "static int\n"
+        "c_%s_has_layout(const unsigned char *data, size_t data_len) {\n"
+        "    /* constant layout: check the length, then all header bytes at once */\n"
+        "    return data_len >= C_%s_SERIALIZED_LEN\n"
+        "        && (memcmp(data, c_%s_template, %d)",
+        name, name, name, name, upper_name, name, offset);
+    for (i=0; i<message_info->field_count; i++) {
+        int type = get_field_value_type_index(message_info->field_types[i]);
+        int head_len = DYN_FIELD_FIXED_LEN + strlen(message_info->field_names[i]);
+        strbuf_appendf(cv_c_buf,
+            "\n            | memcmp(data + %d, c_%s_template + %d, %d)",
+            offset, name, offset, head_len);
+        offset += head_len + allowed_value_types_size[type];
+    }
+    strbuf_appendf(cv_c_buf, ") == 0;\n}\n");
+    free(upper_name);
+}
 
-        for (i=0; i<message_info->field_count; i++) {
-            fprintf(cv_c_fptr,
-            "                dynmessage_get_field(dm, \"%s\", &field);\n",
-            message_info->field_names[i]);
-            fprintf(cv_c_fptr,
-            "                if (field.seq == -1) {\n"
-            "                    error++;\n"
-            "                }\n");
+/**
+ * Function to generate the serialized message header and field headers of
+ * the given message, as constant byte arrays.
+ *
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
+ *        (de)serialization functions for the message.
+ * @param message_info reference to message information structure.
+ */
+static void
+generate_wire_layout(strbuf *cv_c_buf, message_info_struct *message_info) {
+    char *name = message_info->message_name;
+    int i;
+    if (message_info->field_count == 0) {
+        return;
+    }
+    strbuf_appendf(cv_c_buf,
+        "\n/* serialized %s message header (the message length is set on serialization) */\n"
+        "static const unsigned char c_%s_head[] = {\n", name, name);
+    append_int32_bytes(cv_c_buf, DYN_MSG_START, "'Dynamic Message Start'", 0);
+    append_int32_bytes(cv_c_buf, 0, "message length", 0);
+    append_int32_bytes(cv_c_buf, strlen(name), "message name length", 0);
+    append_name_bytes(cv_c_buf, name);
+    append_int32_bytes(cv_c_buf, message_info->field_count, "number of fields", 1);
+    strbuf_appendf(cv_c_buf, "};\n");
+    for (i=0; i<message_info->field_count; i++) {
+        char *field_name = message_info->field_names[i];
+        int type = get_field_value_type_index(message_info->field_types[i]);
+        int size = allowed_value_types_size[type];
+        strbuf_appendf(cv_c_buf,
+            "\n/* serialized %s field header%s */\n"
+            "static const unsigned char c_%s_%s_head[] = {\n", field_name,
+            type == STRING_TYPE ? " (the lengths are set on serialization)" : "",
+            name, field_name);
+        append_int32_bytes(cv_c_buf, DYN_FIELD_FIXED_LEN + strlen(field_name) + size, "field length", 0);
+        append_int32_bytes(cv_c_buf, strlen(field_name), "field name length", 0);
+        append_name_bytes(cv_c_buf, field_name);
+        append_int32_bytes(cv_c_buf, type, "field type", 0);
+        append_int32_bytes(cv_c_buf, size, "field value length", 1);
+        strbuf_appendf(cv_c_buf, "};\n");
+    }
+}
+
+/**
+ * Function to generate the length and writing functions of the given
+ * message (with string fields), used to serialize one or many messages.
+ *
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
+ *        (de)serialization functions for the message.
+ * @param message_info reference to message information structure.
+ */
+static void
+generate_writer(strbuf *cv_c_buf, message_info_struct *message_info) {
+    char *name = message_info->message_name;
+    int i, j;
+    strbuf_appendf(cv_c_buf,
+        "\n/**\n"
+        " * Get the serialized length of a %s message object.\n"
+        " *\n"
+        " * @param object reference to the %s message(not NULL).\n"
+        " *\n"
+        " * @return serialized length of the message, zero if a string field is NULL.\n"
+        " */\n"
+        "static size_t\n"
+        "c_%s_serialized_len(%s *object) {\n"
+        "    size_t length = 0;\n"
+        "    if (",
+        name, name, name, name);
+    for (i=0, j=0; i<message_info->field_count; i++) {
+        if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+            strbuf_appendf(cv_c_buf, "%sobject->%s != NULL",
+                j++ > 0 ? "\n        && " : "", message_info->field_names[i]);
         }
-        fprintf(cv_c_fptr,
-            "                if (!error) {\n"
-            "                    ret++;\n"
-            "                }\n");
-           fprintf(cv_c_fptr,
-            "            }\n");
     }
-    fprintf(cv_c_fptr,
-            "        }\n"
-            "    }\n"
-            "    return ret;\n"
-            "}\n");
+    strbuf_appendf(cv_c_buf, ") {\n        length = %d", get_fixed_serialized_len(message_info));
+    for (i=0; i<message_info->field_count; i++) {
+        if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+            strbuf_appendf(cv_c_buf, "\n            + strlen(object->%s)", message_info->field_names[i]);
+        }
+    }
+    strbuf_appendf(cv_c_buf, ";\n    }\n    return length;\n}\n");
 
-    fprintf(cv_c_fptr,
+    strbuf_appendf(cv_c_buf,
         "\n/**\n"
-        " * Convenience function to serialize a %s message object\n"
-        " * into a sequence of bytes(as a dynamicmessage).\n"
+        " * Write a %s message object into a buffer, in the dynamicmessage\n"
+        " * wire format.\n"
+        " *\n"
+        " * @param object reference to the %s message(not NULL).\n"
+        " * @param data buffer to write into(not NULL).\n"
+        " * @param length serialized length of the message (see c_%s_serialized_len).\n"
+        " */\n"
+        "static void\n"
+        "c_write_%s(%s *object, unsigned char *data, size_t length) {\n"
+        "    size_t offset;\n"
+        "    size_t len;\n"
+        "    /* message header */\n"
+        "    memcpy(data, c_%s_head, sizeof(c_%s_head));\n"
+        "    serialize_int32(data + 4, length);\n"
+        "    offset = sizeof(c_%s_head);\n",
+        name, name, name, name, name, name, name, name);
+    for (i=0; i<message_info->field_count; i++) {
+        char *field_name = message_info->field_names[i];
+        int type = get_field_value_type_index(message_info->field_types[i]);
+        strbuf_appendf(cv_c_buf,
+            "    /* %s */\n"
+            "    memcpy(data + offset, c_%s_%s_head, sizeof(c_%s_%s_head));\n",
+            field_name, name, field_name, name, field_name);
+        if (type == STRING_TYPE) {
+            strbuf_appendf(cv_c_buf,
+                "    len = strlen(object->%s);\n"
+                "    serialize_int32(data + offset, %d + len);\n"
+                "    offset += sizeof(c_%s_%s_head);\n"
+                "    serialize_int32(data + offset - 4, len);\n"
+                "    memcpy(data + offset, object->%s, len);\n"
+                "    offset += len;\n",
+                field_name, (int)(DYN_FIELD_FIXED_LEN + strlen(field_name)),
+                name, field_name, field_name);
+        } else {
+            strbuf_appendf(cv_c_buf, "    offset += sizeof(c_%s_%s_head);\n    ", name, field_name);
+            strbuf_appendf(cv_c_buf, allowed_value_types_serialize[type], "offset", field_name);
+            strbuf_appendf(cv_c_buf, "    offset += %d;\n", allowed_value_types_size[type]);
+        }
+    }
+    strbuf_appendf(cv_c_buf, "}\n");
+}
+
+/**
+ * Function to generate the serialization function of the given message,
+ * writing the message fields straight into the dynamicmessage wire format.
+ *
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
+ *        (de)serialization functions for the message.
+ * @param message_info reference to message information structure.
+ * @param with_fingerprint non-zero to generate the function preceding the
+ *        message by its schema fingerprint (c_serialize_<msg>_with_fingerprint).
+ */
+static void
+generate_serializer(strbuf *cv_c_buf, message_info_struct *message_info, int with_fingerprint) {
+    char *name = message_info->message_name;
+    char *upper_name = get_c_upper_name(name);
+    /* room for the schema fingerprint */
+    const char *prefix_len = with_fingerprint ? "DYN_MSG_FINGERPRINT_LEN + " : "";
+    const char *prefix_skip = with_fingerprint ? " + DYN_MSG_FINGERPRINT_LEN" : "";
+    if (with_fingerprint) {
+        strbuf_appendf(cv_c_buf,
+            "\n/**\n"
+            " * Convenience function to serialize a %s message object\n"
+            " * into a sequence of bytes(as a dynamicmessage), preceded by the\n"
+            " * schema fingerprint of the message (C_%s_FINGERPRINT).\n",
+            name, upper_name);
+    } else {
+        strbuf_appendf(cv_c_buf,
+            "\n/**\n"
+            " * Convenience function to serialize a %s message object\n"
+            " * into a sequence of bytes(as a dynamicmessage).\n",
+            name);
+    }
+    strbuf_appendf(cv_c_buf,
         " *\n"
         " * @param object reference to the %s message to serialize(not NULL).\n"
         " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
@@ -537,63 +1040,1253 @@ generate_implementation(FILE *h_fptr, FILE *cv_c_fptr, message_info_struct *mess
         " * @return Non-zero upon successful serialization, zero otherwise.\n"
         " */\n"
         "extern int\n"
-        "c_serialize_%s(%s *object, serialized_data_info *serdi) {\n"
+        "c_serialize_%s%s(%s *object, serialized_data_info *serdi) {\n"
         "    int result = 0;\n",
-        message_info->message_name, message_info->message_name,
-        message_info->message_name, message_info->message_name,
-        message_info->message_name);
-    fprintf(cv_c_fptr,
-        "    if (object != NULL && serdi != NULL) {\n"
-        "        dynamicmessage dm;\n"
-        "        /* convert %s object to a dynamicmessage object */\n"
-        "        if (c_conv_%s_2dm(object, &dm)) {\n"
-        "            /* Serialize the '%s' dynamicmessage object */\n"
-        "            dynmessage_serialize_bin((void *)&dm, serdi);\n"
-        "            dynmessage_free(&dm);\n"
-        "            if (serdi->ser_data != NULL) {\n"
-        "                result++;\n"
-        "            }\n"
-        "        }\n"
-        "    }\n",
-        message_info->message_name, message_info->message_name,
-        message_info->message_name);
-    fprintf(cv_c_fptr, "    return (result);\n}\n");
+        name, name, name, with_fingerprint ? "_with_fingerprint" : "", name);
+    if (is_fixed_size(message_info)) {
+        strbuf_appendf(cv_c_buf,
+            "    if (object != NULL && serdi != NULL) {\n"
+            "        serdi->ser_data = (unsigned char *)SAFE_MALLOC(%sC_%s_SERIALIZED_LEN);\n"
+            "        serdi->ser_data_len = %sC_%s_SERIALIZED_LEN;\n",
+            prefix_len, upper_name, prefix_len, upper_name);
+        if (with_fingerprint) {
+            strbuf_appendf(cv_c_buf,
+                "        dynmessage_put_fingerprint(serdi->ser_data, C_%s_FINGERPRINT);\n", upper_name);
+        }
+        strbuf_appendf(cv_c_buf,
+            "        c_encode_%s(object, serdi->ser_data%s);\n"
+            "        result++;\n"
+            "    }\n", name, prefix_skip);
+    } else if (message_info->field_count > 0) {
+        strbuf_appendf(cv_c_buf,
+            "    size_t length;\n"
+            "    if (object != NULL && serdi != NULL\n"
+            "        && (length = c_%s_serialized_len(object)) > 0) {\n"
+            "        serdi->ser_data = (unsigned char *)SAFE_MALLOC(%slength);\n"
+            "        serdi->ser_data_len = (int)(%slength);\n",
+            name, prefix_len, prefix_len);
+        if (with_fingerprint) {
+            strbuf_appendf(cv_c_buf,
+                "        dynmessage_put_fingerprint(serdi->ser_data, C_%s_FINGERPRINT);\n", upper_name);
+        }
+        strbuf_appendf(cv_c_buf,
+            "        c_write_%s(object, serdi->ser_data%s, length);\n"
+            "        result++;\n"
+            "    }\n", name, prefix_skip);
+    }
+    strbuf_appendf(cv_c_buf, "    return (result);\n}\n");
+    free(upper_name);
+}
 
-    fprintf(cv_c_fptr,
+/**
+ * Function to generate the decoding function of the given message, reading
+ * the message fields straight out of the dynamicmessage wire format, as long
+ * as they are laid out as the serialization function does.
+ *
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
+ *        (de)serialization functions for the message.
+ * @param message_info reference to message information structure.
+ */
+static void
+generate_decoder(strbuf *cv_c_buf, message_info_struct *message_info) {
+    char *name = message_info->message_name;
+    int i;
+    if (message_info->field_count == 0) {
+        return;
+    }
+    strbuf_appendf(cv_c_buf,
         "\n/**\n"
-        " * Convenience function to deserialize sequence of bytes representing\n"
-        " * a %s message (as dynamicmessage).\n"
+        " * Decode a serialized %s message laid out as c_serialize_%s does\n"
+        " * (fields in definition order) directly into a %s message object.\n"
         " *\n"
-        " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
+        " * @param data the serialized %s message.\n"
+        " * @param data_len length in bytes of the data.\n"
+        " * @param trusted non-zero if the schema fingerprint of the data matched,\n"
+        " *        in which case field names and types are not compared.\n"
+        " * @param object reference to the decoded %s message(not NULL), only\n"
+        " *        modified upon successful decoding.\n"
+        " *\n"
+        " * @return Non-zero upon successful decoding, zero if the data is not\n"
+        " *         laid out as expected.\n"
+        " */\n"
+        "static int\n"
+        "c_decode_%s(unsigned char *data, size_t data_len, int trusted, %s *object) {\n",
+        name, name, name, name, name, name, name);
+    if (is_fixed_size(message_info)) {
+        char *upper_name = get_c_upper_name(name);
+        strbuf_appendf(cv_c_buf,
+            "    if (trusted ? data_len < C_%s_SERIALIZED_LEN : !c_%s_has_layout(data, data_len)) {\n"
+            "        return 0;\n"
+            "    }\n", upper_name, name);
+        for (i=0; i<message_info->field_count; i++) {
+            char *field_name = message_info->field_names[i];
+            char *upper_field_name = get_c_upper_name(field_name);
+            int type = get_field_value_type_index(message_info->field_types[i]);
+            int len = strlen(upper_name) + strlen(upper_field_name) + 11;
+            char value_offset[len];
+            sprintf(value_offset, "C_%s_%s_OFFSET", upper_name, upper_field_name);
+            strbuf_appendf(cv_c_buf, "    ");
+            strbuf_appendf(cv_c_buf, allowed_value_types_deserialize[type], "object->",
+                field_name, value_offset);
+            free(upper_field_name);
+        }
+        strbuf_appendf(cv_c_buf, "    return 1;\n}\n");
+        free(upper_name);
+        return;
+    }
+    strbuf_appendf(cv_c_buf,
+        "    %s value;\n"
+        "    size_t length;\n"
+        "    size_t offset = sizeof(c_%s_head);\n",
+        name, name);
+    for (i=0; i<message_info->field_count; i++) {
+        if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+            strbuf_appendf(cv_c_buf, "    size_t %s_offset, %s_len;\n",
+                message_info->field_names[i], message_info->field_names[i]);
+        }
+    }
+    strbuf_appendf(cv_c_buf,
+        "\n"
+        "    /* message header (but the message length) */\n"
+        "    if (data_len < sizeof(c_%s_head)\n"
+        "        || (!trusted\n"
+        "            && (memcmp(data, c_%s_head, 4) != 0\n"
+        "                || memcmp(data + 8, c_%s_head + 8, sizeof(c_%s_head) - 8) != 0))) {\n"
+        "        return 0;\n"
+        "    }\n"
+        "    length = deserialize_uint32(data + 4);\n"
+        "    if (length > data_len) {\n"
+        "        return 0;\n"
+        "    }\n",
+        name, name, name, name);
+    for (i=0; i<message_info->field_count; i++) {
+        char *field_name = message_info->field_names[i];
+        int type = get_field_value_type_index(message_info->field_types[i]);
+        if (type == STRING_TYPE) {
+            strbuf_appendf(cv_c_buf,
+                "    /* %s (but the lengths) */\n"
+                "    if (offset + sizeof(c_%s_%s_head) > length\n"
+                "        || (!trusted && memcmp(data + offset + 4, c_%s_%s_head + 4, sizeof(c_%s_%s_head) - 8) != 0)) {\n"
+                "        return 0;\n"
+                "    }\n"
+                "    %s_len = deserialize_uint32(data + offset + sizeof(c_%s_%s_head) - 4);\n"
+                "    if (%s_len > length - offset - sizeof(c_%s_%s_head)\n"
+                "        || deserialize_uint32(data + offset) != %d + %s_len) {\n"
+                "        return 0;\n"
+                "    }\n"
+                "    %s_offset = offset + sizeof(c_%s_%s_head);\n"
+                "    offset = %s_offset + %s_len;\n",
+                field_name, name, field_name, name, field_name, name, field_name,
+                field_name, name, field_name, field_name, name, field_name,
+                (int)(DYN_FIELD_FIXED_LEN + strlen(field_name)), field_name,
+                field_name, name, field_name, field_name, field_name);
+        } else {
+            strbuf_appendf(cv_c_buf,
+                "    /* %s */\n"
+                "    if (offset + sizeof(c_%s_%s_head) + %d > length\n"
+                "        || (!trusted && memcmp(data + offset, c_%s_%s_head, sizeof(c_%s_%s_head)) != 0)) {\n"
+                "        return 0;\n"
+                "    }\n"
+                "    offset += sizeof(c_%s_%s_head);\n    ",
+                field_name, name, field_name, allowed_value_types_size[type],
+                name, field_name, name, field_name, name, field_name);
+            strbuf_appendf(cv_c_buf, allowed_value_types_deserialize[type], "value.", field_name, "offset");
+            strbuf_appendf(cv_c_buf, "    offset += %d;\n", allowed_value_types_size[type]);
+        }
+    }
+    for (i=0; i<message_info->field_count; i++) {
+        char *field_name = message_info->field_names[i];
+        if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+            strbuf_appendf(cv_c_buf,
+                "    value.%s = (char *)SAFE_MALLOC(%s_len + 1);\n"
+                "    memcpy(value.%s, data + %s_offset, %s_len);\n"
+                "    value.%s[%s_len] = '\\0';\n",
+                field_name, field_name, field_name, field_name, field_name,
+                field_name, field_name);
+        }
+    }
+    strbuf_appendf(cv_c_buf,
+        "    *object = value;\n"
+        "    return 1;\n"
+        "}\n");
+}
+
+/**
+ * Function to generate the de-serialization function of the given message,
+ * decoding directly when possible and through a dynamicmessage otherwise.
+ *
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
+ *        (de)serialization functions for the message.
+ * @param message_info reference to message information structure.
+ */
+static void
+generate_deserializer(strbuf *cv_c_buf, message_info_struct *message_info) {
+    char *name = message_info->message_name;
+    int i;
+    strbuf_appendf(cv_c_buf,
+        "\n/**\n"
+        " * Convenience function to deserialize sequence of bytes representing\n"
+        " * a %s message (as dynamicmessage).\n"
+        " *\n"
+        " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
         " *        containing the serialized %s message object.\n"
         " * @param object reference to the deserialized %s message(not NULL).\n"
-          " *\n"
+        " *        String field values are allocated (SAFE_MALLOC) and owned by the caller.\n"
+        " *\n"
         " * @return Non-zero upon successful de-serialization, zero otherwise.\n"
         " */\n"
         "extern int\n"
         "c_deserialize_%s(serialized_data_info *serdi, %s *object) {\n"
         "    int result = 0;\n",
-        message_info->message_name,
-        message_info->message_name,
-        message_info->message_name,
-        message_info->message_name,
-        message_info->message_name);
-    fprintf(cv_c_fptr,
-        "    if (object != NULL && serdi != NULL) {\n"
-        "        /* decode data into a dynamicmessage object */\n"
-        "        dynamicmessage *dm = dynmessage_deserialize_bin(serdi->ser_data, serdi->ser_data_len);\n"
-        "        if (dm) {\n"
-        "            /* convert dynamicmessage object to a '%s' object */\n"
-        "            if (c_conv_dm_2%s(dm, object)) {\n"
-        "                result++;\n"
+        name, name, name, name, name);
+    if (message_info->field_count > 0) {
+        char *upper_name = get_c_upper_name(name);
+        strbuf_appendf(cv_c_buf,
+            "    if (object != NULL && serdi != NULL\n"
+            "        && serdi->ser_data != NULL && serdi->ser_data_len > 0) {\n"
+            "        unsigned char *data = serdi->ser_data;\n"
+            "        size_t data_len = serdi->ser_data_len;\n"
+            "        /* schema fingerprint (if any): a match vouches for the field layout */\n"
+            "        unsigned long long fingerprint = dynmessage_get_fingerprint(data, data_len);\n"
+            "        if (fingerprint != 0) {\n"
+            "            data += DYN_MSG_FINGERPRINT_LEN;\n"
+            "            data_len -= DYN_MSG_FINGERPRINT_LEN;\n"
+            "        }\n"
+            "        if (c_decode_%s(data, data_len, fingerprint == C_%s_FINGERPRINT, object)) {\n"
+            "            result++;\n"
+            "        } else {\n"
+            "            /* fields laid out otherwise, decode data into a dynamicmessage object */\n"
+            "            dynamicmessage *dm = dynmessage_deserialize_bin(serdi->ser_data, serdi->ser_data_len);\n"
+            "            if (dm) {\n"
+            "                /* convert dynamicmessage object to a '%s' object */\n"
+            "                if (c_conv_dm_2%s(dm, object)) {\n",
+            name, upper_name, name, name);
+        free(upper_name);
+        for (i=0; i<message_info->field_count; i++) {
+            if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+                strbuf_appendf(cv_c_buf,
+                    "                    object->%s = SAFE_STRDUP(object->%s);\n",
+                    message_info->field_names[i], message_info->field_names[i]);
+            }
+        }
+        strbuf_appendf(cv_c_buf,
+            "                    result++;\n"
+            "                }\n"
+            "                dynmessage_destroy(dm);\n"
+            "            }\n"
+            "        }\n"
+            "    }\n");
+    }
+    strbuf_appendf(cv_c_buf, "    return (result);\n}\n");
+}
+
+/**
+ * Function to generate the batch serialization function of the given message,
+ * writing an array of messages into a single length-prefixed buffer.
+ *
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
+ *        (de)serialization functions for the message.
+ * @param message_info reference to message information structure.
+ */
+static void
+generate_array_serializer(strbuf *cv_c_buf, message_info_struct *message_info) {
+    char *name = message_info->message_name;
+    int i;
+    strbuf_appendf(cv_c_buf,
+        "\n/**\n"
+        " * Convenience function to serialize an array of %s message objects\n"
+        " * into a single sequence of bytes: the number of messages (4 bytes),\n"
+        " * followed by each message (as a dynamicmessage).\n"
+        " *\n"
+        " * @param objects array of the %s messages to serialize(not NULL).\n"
+        " * @param n number of messages in the array.\n"
+        " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
+        " *              to store the serialized %s message objects representation.\n"
+        " *\n"
+        " * @return Non-zero upon successful serialization, zero otherwise.\n"
+        " */\n"
+        "extern int\n"
+        "c_serialize_%s_array(%s *objects, int n, serialized_data_info *serdi) {\n"
+        "    int result = 0;\n",
+        name, name, name, name, name);
+    if (is_fixed_size(message_info)) {
+        char *upper_name = get_c_upper_name(name);
+        strbuf_appendf(cv_c_buf,
+            "    if (objects != NULL && n >= 0 && serdi != NULL\n"
+            "        && (size_t)n <= (INT_MAX - 4) / C_%s_SERIALIZED_LEN) {\n"
+            "        size_t length = 4 + (size_t)n * C_%s_SERIALIZED_LEN;\n"
+            "        unsigned char *buffer = (unsigned char *)SAFE_MALLOC(length);\n"
+            "        int i, copied;\n"
+            "        serialize_int32(buffer, n);\n"
+            "        /* message headers: replicate the template over the whole batch */\n"
+            "        if (n > 0) {\n"
+            "            memcpy(buffer + 4, c_%s_template, C_%s_SERIALIZED_LEN);\n"
+            "        }\n"
+            "        for (copied = 1; copied < n; copied *= 2) {\n"
+            "            int count = copied < n - copied ? copied : n - copied;\n"
+            "            memcpy(buffer + 4 + (size_t)copied * C_%s_SERIALIZED_LEN,\n"
+            "                buffer + 4, (size_t)count * C_%s_SERIALIZED_LEN);\n"
+            "        }\n"
+            "        /* field values at constant offsets */\n"
+            "        for (i = 0; i < n; i++) {\n"
+            "            unsigned char *data = buffer + 4 + (size_t)i * C_%s_SERIALIZED_LEN;\n"
+            "            %s *object = objects + i;\n",
+            upper_name, upper_name, name, upper_name, upper_name, upper_name, upper_name, name);
+        for (i=0; i<message_info->field_count; i++) {
+            char *field_name = message_info->field_names[i];
+            char *upper_field_name = get_c_upper_name(field_name);
+            int type = get_field_value_type_index(message_info->field_types[i]);
+            int len = strlen(upper_name) + strlen(upper_field_name) + 11;
+            char offset[len];
+            sprintf(offset, "C_%s_%s_OFFSET", upper_name, upper_field_name);
+            strbuf_appendf(cv_c_buf, "            ");
+            strbuf_appendf(cv_c_buf, allowed_value_types_serialize[type], offset, field_name);
+            free(upper_field_name);
+        }
+        strbuf_appendf(cv_c_buf,
+            "        }\n"
+            "        serdi->ser_data = buffer;\n"
+            "        serdi->ser_data_len = (int)length;\n"
+            "        result++;\n"
+            "    }\n");
+        free(upper_name);
+    } else if (message_info->field_count > 0) {
+        strbuf_appendf(cv_c_buf,
+            "    if (objects != NULL && n >= 0 && serdi != NULL) {\n"
+            "        size_t length = 4;\n"
+            "        size_t message_length;\n"
+            "        unsigned char *data;\n"
+            "        int i;\n"
+            "        /* total length */\n"
+            "        for (i = 0; i < n; i++) {\n"
+            "            if ((message_length = c_%s_serialized_len(objects + i)) == 0\n"
+            "                || message_length > INT_MAX - length) {\n"
+            "                return (result);\n"
+            "            }\n"
+            "            length += message_length;\n"
+            "        }\n"
+            "        data = (unsigned char *)SAFE_MALLOC(length);\n"
+            "        serdi->ser_data = data;\n"
+            "        serdi->ser_data_len = (int)length;\n"
+            "        serialize_int32(data, n);\n"
+            "        data += 4;\n"
+            "        for (i = 0; i < n; i++) {\n"
+            "            message_length = c_%s_serialized_len(objects + i);\n"
+            "            c_write_%s(objects + i, data, message_length);\n"
+            "            data += message_length;\n"
+            "        }\n"
+            "        result++;\n"
+            "    }\n", name, name, name);
+    }
+    strbuf_appendf(cv_c_buf, "    return (result);\n}\n");
+}
+
+/**
+ * Function to generate the batch de-serialization function of the given
+ * message, reading an array of messages out of a length-prefixed buffer.
+ *
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
+ *        (de)serialization functions for the message.
+ * @param message_info reference to message information structure.
+ */
+static void
+generate_array_deserializer(strbuf *cv_c_buf, message_info_struct *message_info) {
+    char *name = message_info->message_name;
+    int i;
+    strbuf_appendf(cv_c_buf,
+        "\n/**\n"
+        " * Convenience function to deserialize a sequence of bytes representing\n"
+        " * an array of %s messages (see c_serialize_%s_array).\n"
+        " *\n"
+        " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
+        " *        containing the serialized %s message objects.\n"
+        " * @param objects reference to the deserialized array of %s messages(not NULL).\n"
+        " *        The array (NULL if empty) and string field values are allocated\n"
+        " *        (SAFE_MALLOC) and owned by the caller.\n"
+        " * @param n reference to the number of deserialized messages(not NULL).\n"
+        " *\n"
+        " * @return Non-zero upon successful de-serialization, zero otherwise.\n"
+        " */\n"
+        "extern int\n"
+        "c_deserialize_%s_array(serialized_data_info *serdi, %s **objects, int *n) {\n"
+        "    int result = 0;\n",
+        name, name, name, name, name, name);
+    if (message_info->field_count > 0) {
+        strbuf_appendf(cv_c_buf,
+            "    if (serdi != NULL && objects != NULL && n != NULL\n"
+            "        && serdi->ser_data != NULL && serdi->ser_data_len >= 4) {\n"
+            "        unsigned char *data = serdi->ser_data;\n"
+            "        size_t data_len = serdi->ser_data_len;\n"
+            "        size_t offset = 4;\n"
+            "        unsigned long count = deserialize_uint32(data);\n"
+            "        %s *array = NULL;\n"
+            "        unsigned long i = 0;\n"
+            "        /* every message takes more than %d bytes */\n"
+            "        if (count > (data_len - 4) / %d) {\n"
+            "            return (result);\n"
+            "        }\n"
+            "        if (count > 0) {\n"
+            "            array = (%s *)SAFE_MALLOC(count * sizeof(%s));\n"
+            "        }\n"
+            "        for (i = 0; i < count; i++) {\n"
+            "            serialized_data_info message;\n"
+            "            size_t message_len;\n"
+            "            if (data_len - offset < 8\n"
+            "                || (message_len = deserialize_uint32(data + offset + 4)) < 8\n"
+            "                || message_len > data_len - offset) {\n"
+            "                break;\n"
+            "            }\n"
+            "            message.ser_data = data + offset;\n"
+            "            message.ser_data_len = (int)message_len;\n"
+            "            if (!c_deserialize_%s(&message, array + i)) {\n"
+            "                break;\n"
+            "            }\n"
+            "            offset += message_len;\n"
+            "        }\n"
+            "        if (i == count && offset == data_len) {\n"
+            "            *objects = array;\n"
+            "            *n = (int)count;\n"
+            "            result++;\n"
+            "        } else {\n",
+            name, DYN_MSG_MIN_LEN, DYN_MSG_MIN_LEN + 1, name, name, name);
+        for (i=0; i<message_info->field_count; i++) {
+            if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+                break;
+            }
+        }
+        if (i < message_info->field_count) {
+            strbuf_appendf(cv_c_buf,
+                "            while (i-- > 0) {\n");
+            for (i=0; i<message_info->field_count; i++) {
+                if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+                    strbuf_appendf(cv_c_buf,
+                        "                SAFE_FREE(array[i].%s);\n", message_info->field_names[i]);
+                }
+            }
+            strbuf_appendf(cv_c_buf,
+                "            }\n");
+        }
+        strbuf_appendf(cv_c_buf,
+            "            SAFE_FREE(array);\n"
+            "        }\n"
+            "    }\n");
+    }
+    strbuf_appendf(cv_c_buf, "    return (result);\n}\n");
+}
+
+/**
+ * Function to append to generated source code the declaration (header file)
+ * and the start of the implementation (source file) of an extern function.
+ *
+ * @param cv_h_buf buffer collecting the header file that will contain the declaration of convenience
+ *        (de)serialization functions for the message.
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
+ *        (de)serialization functions for the message.
+ * @param doc doc comment of the function.
+ * @param signature return type and signature of the function.
+ */
+static void
+append_extern_function(strbuf *cv_h_buf, strbuf *cv_c_buf, strbuf *doc, strbuf *signature) {
+    strbuf_appendf(cv_h_buf, "%sextern %s;\n", doc->data, signature->data);
+    strbuf_appendf(cv_c_buf, "%sextern %s {\n", doc->data, signature->data);
+    strbuf_free(doc);
+    strbuf_free(signature);
+    strbuf_init(doc);
+    strbuf_init(signature);
+}
+
+/**
+ * Function to generate the structure of arrays (columnar) type of the given
+ * message, along with its conversion, append and columnar (de)serialization
+ * functions.
+ *
+ * SERIALIZED COLUMNS FORMAT
+ *
+ *  message name length                    4 bytes
+ *  message name                           m bytes
+ *  number of messages (c)                 4 bytes
+ *  number of fields (n)                   4 bytes
+ *
+ *  ---> (repeated n times, in field definition order)
+ *  |   field type                         4 bytes
+ *  |   column length                      4 bytes
+ *  |   c field values                     c * l bytes (c * (4 + k) bytes
+ *  |                                      for strings: length, characters)
+ *  --->
+ *
+ * @param h_buf buffer collecting the header file containing the c structure of the message.
+ * @param cv_h_buf buffer collecting the header file that will contain the declaration of convenience
+ *        (de)serialization functions for the message.
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
+ *        (de)serialization functions for the message.
+ * @param message_info reference to message information structure.
+ */
+static void
+generate_soa(strbuf *h_buf, strbuf *cv_h_buf, strbuf *cv_c_buf, message_info_struct *message_info) {
+    char *name = message_info->message_name;
+    int head_len = 12 + strlen(name) + 8 * message_info->field_count;
+    int row_len = 0; /* serialized bytes per message, without string characters */
+    int strings = 0; /* number of string fields */
+    strbuf doc, signature;
+    int i, k;
+    for (i=0; i<message_info->field_count; i++) {
+        int type = get_field_value_type_index(message_info->field_types[i]);
+        row_len += type == STRING_TYPE ? 4 : allowed_value_types_size[type];
+        strings += type == STRING_TYPE;
+    }
+    strbuf_init(&doc);
+    strbuf_init(&signature);
+
+    /* definition of the structure of arrays */
+    strbuf_appendf(h_buf, "\n/* structure to store %s messages, one array (column) per field */\n"
+        "typedef struct _%s_soa_struct_ {\n"
+        "    int count; /* number of stored messages */\n"
+        "    int capacity; /* number of messages the columns have room for */\n", name, name);
+    for (i=0; i<message_info->field_count; i++) {
+        strbuf_appendf(h_buf, "    %s *%s;\n",
+            get_field_value_type_text(message_info->field_types[i]), message_info->field_names[i]);
+    }
+    strbuf_appendf(h_buf, "} %s_soa;\n", name);
+
+    /* init */
+    strbuf_appendf(&doc,
+        "\n/**\n"
+        " * Initialize an (empty) %s structure of arrays.\n"
+        " *\n"
+        " * @param soa reference to the %s structure of arrays(not NULL).\n"
+        " */\n", name, name);
+    strbuf_appendf(&signature, "void\nc_%s_soa_init(%s_soa *soa)", name, name);
+    append_extern_function(cv_h_buf, cv_c_buf, &doc, &signature);
+    strbuf_appendf(cv_c_buf, "    memset(soa, 0, sizeof(%s_soa));\n}\n", name);
+
+    /* free */
+    strbuf_appendf(&doc,
+        "\n/**\n"
+        " * Free the columns (and string field values) of a %s structure of arrays,\n"
+        " * leaving it empty.\n"
+        " *\n"
+        " * @param soa reference to the %s structure of arrays(not NULL).\n"
+        " */\n", name, name);
+    strbuf_appendf(&signature, "void\nc_%s_soa_free(%s_soa *soa)", name, name);
+    append_extern_function(cv_h_buf, cv_c_buf, &doc, &signature);
+    if (strings) {
+        strbuf_appendf(cv_c_buf, "    int i;\n    for (i = 0; i < soa->count; i++) {\n");
+        for (i=0; i<message_info->field_count; i++) {
+            if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+                strbuf_appendf(cv_c_buf, "        SAFE_FREE(soa->%s[i]);\n", message_info->field_names[i]);
+            }
+        }
+        strbuf_appendf(cv_c_buf, "    }\n");
+    }
+    for (i=0; i<message_info->field_count; i++) {
+        strbuf_appendf(cv_c_buf, "    SAFE_FREE(soa->%s);\n", message_info->field_names[i]);
+    }
+    strbuf_appendf(cv_c_buf, "    c_%s_soa_init(soa);\n}\n", name);
+
+    /* reserve */
+    strbuf_appendf(&doc,
+        "\n/**\n"
+        " * Make room in the columns of a %s structure of arrays for a number\n"
+        " * of messages (the columns are allocated on first call).\n"
+        " *\n"
+        " * @param soa reference to the %s structure of arrays(not NULL).\n"
+        " * @param capacity number of messages to make room for.\n"
+        " *\n"
+        " * @return Non-zero upon success, zero otherwise.\n"
+        " */\n", name, name);
+    strbuf_appendf(&signature, "int\nc_%s_soa_reserve(%s_soa *soa, int capacity)", name, name);
+    append_extern_function(cv_h_buf, cv_c_buf, &doc, &signature);
+    strbuf_appendf(cv_c_buf,
+        "    int result = 0;\n"
+        "    if (soa != NULL && capacity >= 0) {\n"
+        "        if (capacity > soa->capacity || soa->capacity == 0) {\n"
+        "            int new_capacity = soa->capacity > 0 ? soa->capacity : 16;\n"
+        "            while (new_capacity < capacity) {\n"
+        "                new_capacity = new_capacity <= INT_MAX / 2 ? new_capacity * 2 : capacity;\n"
+        "            }\n");
+    for (i=0; i<message_info->field_count; i++) {
+        char *ctype = get_field_value_type_text(message_info->field_types[i]);
+        strbuf_appendf(cv_c_buf,
+            "            soa->%s = (%s *)SAFE_REALLOC(soa->%s, (size_t)new_capacity * sizeof(%s));\n",
+            message_info->field_names[i], ctype, message_info->field_names[i], ctype);
+    }
+    strbuf_appendf(cv_c_buf,
+        "            soa->capacity = new_capacity;\n"
+        "        }\n"
+        "        result++;\n"
+        "    }\n"
+        "    return (result);\n"
+        "}\n");
+
+    /* append */
+    strbuf_appendf(&doc,
+        "\n/**\n"
+        " * Append a %s message object to a %s structure of arrays.\n"
+        " *\n"
+        " * @param soa reference to the %s structure of arrays(not NULL).\n"
+        " * @param object reference to the %s message to append(not NULL).\n"
+        " *        String field values are copied.\n"
+        " *\n"
+        " * @return Non-zero upon success, zero otherwise.\n"
+        " */\n", name, name, name, name);
+    strbuf_appendf(&signature, "int\nc_%s_soa_append(%s_soa *soa, %s *object)", name, name, name);
+    append_extern_function(cv_h_buf, cv_c_buf, &doc, &signature);
+    strbuf_appendf(cv_c_buf, "    int result = 0;\n    if (soa != NULL && object != NULL");
+    for (i=0; i<message_info->field_count; i++) {
+        if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+            strbuf_appendf(cv_c_buf, "\n        && object->%s != NULL", message_info->field_names[i]);
+        }
+    }
+    strbuf_appendf(cv_c_buf,
+        "\n        && soa->count < INT_MAX && c_%s_soa_reserve(soa, soa->count + 1)) {\n", name);
+    for (i=0; i<message_info->field_count; i++) {
+        char *field_name = message_info->field_names[i];
+        if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+            strbuf_appendf(cv_c_buf, "        soa->%s[soa->count] = SAFE_STRDUP(object->%s);\n",
+                field_name, field_name);
+        } else {
+            strbuf_appendf(cv_c_buf, "        soa->%s[soa->count] = object->%s;\n", field_name, field_name);
+        }
+    }
+    strbuf_appendf(cv_c_buf,
+        "        soa->count++;\n"
+        "        result++;\n"
+        "    }\n"
+        "    return (result);\n"
+        "}\n");
+
+    /* append array */
+    strbuf_appendf(&doc,
+        "\n/**\n"
+        " * Append an array of %s message objects to a %s structure of arrays.\n"
+        " *\n"
+        " * @param soa reference to the %s structure of arrays(not NULL).\n"
+        " * @param objects array of the %s messages to append(not NULL).\n"
+        " *        String field values are copied.\n"
+        " * @param n number of messages in the array.\n"
+        " *\n"
+        " * @return Non-zero upon success, zero otherwise (nothing appended).\n"
+        " */\n", name, name, name, name);
+    strbuf_appendf(&signature, "int\nc_%s_soa_append_array(%s_soa *soa, %s *objects, int n)",
+        name, name, name);
+    append_extern_function(cv_h_buf, cv_c_buf, &doc, &signature);
+    strbuf_appendf(cv_c_buf,
+        "    int result = 0;\n"
+        "    if (soa != NULL && objects != NULL && n >= 0 && n <= INT_MAX - soa->count) {\n"
+        "        int i;\n");
+    if (strings) {
+        strbuf_appendf(cv_c_buf, "        for (i = 0; i < n; i++) {\n            if (");
+        for (i=0, k=0; i<message_info->field_count; i++) {
+            if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+                strbuf_appendf(cv_c_buf, "%sobjects[i].%s == NULL",
+                    k++ > 0 ? "\n                || " : "", message_info->field_names[i]);
+            }
+        }
+        strbuf_appendf(cv_c_buf, ") {\n                return (result);\n            }\n        }\n");
+    }
+    strbuf_appendf(cv_c_buf, "        if (c_%s_soa_reserve(soa, soa->count + n)) {\n", name);
+    strbuf_appendf(cv_c_buf, "            /* one column at a time */\n");
+    for (i=0; i<message_info->field_count; i++) {
+        char *field_name = message_info->field_names[i];
+        strbuf_appendf(cv_c_buf, "            for (i = 0; i < n; i++) {\n");
+        if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+            strbuf_appendf(cv_c_buf, "                soa->%s[soa->count + i] = SAFE_STRDUP(objects[i].%s);\n",
+                field_name, field_name);
+        } else {
+            strbuf_appendf(cv_c_buf, "                soa->%s[soa->count + i] = objects[i].%s;\n",
+                field_name, field_name);
+        }
+        strbuf_appendf(cv_c_buf, "            }\n");
+    }
+    strbuf_appendf(cv_c_buf,
+        "            soa->count += n;\n"
+        "            result++;\n"
+        "        }\n"
+        "    }\n"
+        "    return (result);\n"
+        "}\n");
+
+    /* get */
+    strbuf_appendf(&doc,
+        "\n/**\n"
+        " * Get a %s message object out of a %s structure of arrays.\n"
+        " *\n"
+        " * @param soa reference to the %s structure of arrays(not NULL).\n"
+        " * @param index index of the message.\n"
+        " * @param object reference to the %s message(not NULL). String field\n"
+        " *        values refer to the structure of arrays (they are not copied).\n"
+        " *\n"
+        " * @return Non-zero upon success, zero otherwise.\n"
+        " */\n", name, name, name, name);
+    strbuf_appendf(&signature, "int\nc_%s_soa_get(%s_soa *soa, int index, %s *object)", name, name, name);
+    append_extern_function(cv_h_buf, cv_c_buf, &doc, &signature);
+    strbuf_appendf(cv_c_buf,
+        "    int result = 0;\n"
+        "    if (soa != NULL && object != NULL && index >= 0 && index < soa->count) {\n");
+    for (i=0; i<message_info->field_count; i++) {
+        strbuf_appendf(cv_c_buf, "        object->%s = soa->%s[index];\n",
+            message_info->field_names[i], message_info->field_names[i]);
+    }
+    strbuf_appendf(cv_c_buf,
+        "        result++;\n"
+        "    }\n"
+        "    return (result);\n"
+        "}\n");
+
+    /* columnar serialization */
+    strbuf_appendf(&doc,
+        "\n/**\n"
+        " * Convenience function to serialize the messages of a %s structure of\n"
+        " * arrays into a sequence of bytes, one column after the other.\n"
+        " *\n"
+        " * @param object reference to the %s structure of arrays to serialize(not NULL).\n"
+        " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
+        " *              to store the serialized columns.\n"
+        " *\n"
+        " * @return Non-zero upon successful serialization, zero otherwise.\n"
+        " */\n", name, name);
+    strbuf_appendf(&signature, "int\nc_serialize_%s_soa(%s_soa *object, serialized_data_info *serdi)",
+        name, name);
+    append_extern_function(cv_h_buf, cv_c_buf, &doc, &signature);
+    strbuf_appendf(cv_c_buf,
+        "    int result = 0;\n"
+        "    if (object != NULL && serdi != NULL && object->count >= 0\n"
+        "        && (size_t)object->count <= (INT_MAX - %d) / %d) {\n"
+        "        size_t length = %d + (size_t)object->count * %d;\n",
+        head_len, row_len, head_len, row_len);
+    strbuf_appendf(cv_c_buf, "        unsigned char *data;\n%s        int i;\n",
+        strings ? "        unsigned char *column;\n" : "");
+    if (strings) {
+        strbuf_appendf(cv_c_buf,
+            "        size_t strings_len = 0;\n"
+            "        for (i = 0; i < object->count; i++) {\n"
+            "            strings_len += ");
+        for (i=0, k=0; i<message_info->field_count; i++) {
+            if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+                strbuf_appendf(cv_c_buf, "%sstrlen(object->%s[i])",
+                    k++ > 0 ? "\n                + " : "", message_info->field_names[i]);
+            }
+        }
+        strbuf_appendf(cv_c_buf,
+            ";\n"
+            "        }\n"
+            "        if (strings_len > INT_MAX - length) {\n"
+            "            return (result);\n"
+            "        }\n"
+            "        length += strings_len;\n");
+    }
+    strbuf_appendf(cv_c_buf,
+        "        data = (unsigned char *)SAFE_MALLOC(length);\n"
+        "        serdi->ser_data = data;\n"
+        "        serdi->ser_data_len = (int)length;\n"
+        "        serialize_int32(data, %d);\n"
+        "        memcpy(data + 4, \"%s\", %d);\n"
+        "        serialize_int32(data + %d, object->count);\n"
+        "        serialize_int32(data + %d, %d);\n"
+        "        data += %d;\n",
+        (int)strlen(name), name, (int)strlen(name), 4 + (int)strlen(name),
+        8 + (int)strlen(name), message_info->field_count, 12 + (int)strlen(name));
+    for (i=0; i<message_info->field_count; i++) {
+        char *field_name = message_info->field_names[i];
+        int type = get_field_value_type_index(message_info->field_types[i]);
+        int size = allowed_value_types_size[type];
+        strbuf_appendf(cv_c_buf, "        /* %s column */\n        serialize_int32(data, %d);\n", field_name, type);
+        if (type == STRING_TYPE) {
+            strbuf_appendf(cv_c_buf,
+                "        column = data;\n"
+                "        data += 8;\n"
+                "        for (i = 0; i < object->count; i++) {\n"
+                "            size_t len = strlen(object->%s[i]);\n"
+                "            serialize_int32(data, len);\n"
+                "            memcpy(data + 4, object->%s[i], len);\n"
+                "            data += 4 + len;\n"
+                "        }\n"
+                "        serialize_int32(column + 4, data - column - 8);\n", field_name, field_name);
+            continue;
+        }
+        strbuf_appendf(cv_c_buf,
+            "        serialize_int32(data + 4, (size_t)object->count * %d);\n"
+            "        data += 8;\n", size);
+        if (size == 1 || type == FLOAT32_TYPE || type == FLOAT64_TYPE) {
+            char value[strlen(field_name) + 4];
+            sprintf(value, "%s[i]", field_name);
+            strbuf_appendf(cv_c_buf, "        for (i = 0; i < object->count; i++, data += %d) {\n            ", size);
+            strbuf_appendf(cv_c_buf, allowed_value_types_serialize[type], "0", value);
+            strbuf_appendf(cv_c_buf, "        }\n");
+        } else {
+            /* big-endian stores the compiler can turn into byte swaps */
+            strbuf_appendf(cv_c_buf,
+                "        for (i = 0; i < object->count; i++, data += %d) {\n"
+                "            unsigned long long value = (unsigned long long)object->%s[i];\n",
+                size, field_name);
+            for (k=0; k<size; k++) {
+                if (k < size - 1) {
+                    strbuf_appendf(cv_c_buf, "            data[%d] = (unsigned char)(value >> %d);\n",
+                        k, 8 * (size - 1 - k));
+                } else {
+                    strbuf_appendf(cv_c_buf, "            data[%d] = (unsigned char)value;\n", k);
+                }
+            }
+            strbuf_appendf(cv_c_buf, "        }\n");
+        }
+    }
+    strbuf_appendf(cv_c_buf,
+        "        result++;\n"
+        "    }\n"
+        "    return (result);\n"
+        "}\n");
+
+    /* columnar de-serialization */
+    strbuf_appendf(&doc,
+        "\n/**\n"
+        " * Convenience function to deserialize a sequence of bytes representing\n"
+        " * the columns of %s messages (see c_serialize_%s_soa), appending\n"
+        " * the messages to a %s structure of arrays.\n"
+        " *\n"
+        " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
+        " *        containing the serialized columns.\n"
+        " * @param object reference to the %s structure of arrays(not NULL).\n"
+        " *\n"
+        " * @return Non-zero upon successful de-serialization, zero otherwise\n"
+        " *         (nothing appended).\n"
+        " */\n", name, name, name, name);
+    strbuf_appendf(&signature, "int\nc_deserialize_%s_soa(serialized_data_info *serdi, %s_soa *object)",
+        name, name);
+    append_extern_function(cv_h_buf, cv_c_buf, &doc, &signature);
+    strbuf_appendf(cv_c_buf,
+        "    int result = 0;\n"
+        "    if (serdi != NULL && object != NULL && serdi->ser_data != NULL\n"
+        "        && serdi->ser_data_len >= %d\n"
+        "        && deserialize_uint32(serdi->ser_data) == %d\n"
+        "        && memcmp(serdi->ser_data + 4, \"%s\", %d) == 0\n"
+        "        && deserialize_uint32(serdi->ser_data + %d) == %d) {\n"
+        "        unsigned char *data = serdi->ser_data + %d;\n"
+        "        unsigned char *end = serdi->ser_data + serdi->ser_data_len;\n"
+        "        unsigned long count = deserialize_uint32(serdi->ser_data + %d);\n"
+        "        int start = object->count;\n"
+        "        int error = 0;\n"
+        "        int i;\n"
+        "        /* every message takes at least %d bytes */\n"
+        "        if (count > (unsigned long)(end - data) / %d\n"
+        "            || count > (unsigned long)(INT_MAX - start)\n"
+        "            || !c_%s_soa_reserve(object, start + (int)count)) {\n"
+        "            return (result);\n"
+        "        }\n",
+        12 + (int)strlen(name), (int)strlen(name), name, (int)strlen(name),
+        8 + (int)strlen(name), message_info->field_count, 12 + (int)strlen(name),
+        4 + (int)strlen(name), row_len, row_len, name);
+    for (i=0; i<message_info->field_count; i++) {
+        if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+            strbuf_appendf(cv_c_buf, "        memset(object->%s + start, 0, count * sizeof(char *));\n",
+                message_info->field_names[i]);
+        }
+    }
+    for (i=0; i<message_info->field_count; i++) {
+        char *field_name = message_info->field_names[i];
+        int type = get_field_value_type_index(message_info->field_types[i]);
+        int size = allowed_value_types_size[type];
+        strbuf_appendf(cv_c_buf,
+            "        /* %s column */\n"
+            "        if (!error && (end - data < 8 || deserialize_uint32(data) != %d\n",
+            field_name, type);
+        if (type == STRING_TYPE) {
+            strbuf_appendf(cv_c_buf,
+                "            || deserialize_uint32(data + 4) > (unsigned long)(end - data - 8))) {\n"
+                "            error++;\n"
+                "        } else if (!error) {\n"
+                "            unsigned char *column_end = data + 8 + deserialize_uint32(data + 4);\n"
+                "            data += 8;\n"
+                "            for (i = start; i < start + (int)count; i++) {\n"
+                "                size_t len;\n"
+                "                if (column_end - data < 4\n"
+                "                    || (len = deserialize_uint32(data)) > (size_t)(column_end - data - 4)) {\n"
+                "                    error++;\n"
+                "                    break;\n"
+                "                }\n"
+                "                object->%s[i] = (char *)SAFE_MALLOC(len + 1);\n"
+                "                memcpy(object->%s[i], data + 4, len);\n"
+                "                object->%s[i][len] = '\\0';\n"
+                "                data += 4 + len;\n"
+                "            }\n"
+                "            error += data != column_end;\n"
+                "        }\n", field_name, field_name, field_name);
+            continue;
+        }
+        strbuf_appendf(cv_c_buf,
+            "            || deserialize_uint32(data + 4) != count * %d\n"
+            "            || count * %d > (unsigned long)(end - data - 8))) {\n"
+            "            error++;\n"
+            "        } else if (!error) {\n"
+            "            data += 8;\n", size, size);
+        if (size == 1 || type == FLOAT32_TYPE || type == FLOAT64_TYPE) {
+            char value[strlen(field_name) + 4];
+            sprintf(value, "%s[i]", field_name);
+            strbuf_appendf(cv_c_buf,
+                "            for (i = start; i < start + (int)count; i++, data += %d) {\n"
+                "                ", size);
+            strbuf_appendf(cv_c_buf, allowed_value_types_deserialize[type], "object->", value, "0");
+            strbuf_appendf(cv_c_buf, "            }\n");
+        } else {
+            strbuf_appendf(cv_c_buf,
+                "            for (i = start; i < start + (int)count; i++, data += %d) {\n"
+                "                unsigned long long value = ", size);
+            for (k=0; k<size; k++) {
+                strbuf_appendf(cv_c_buf, k < size - 1 ? "(unsigned long long)data[%d] << %d\n"
+                    "                    | " : "(unsigned long long)data[%d];\n", k, 8 * (size - 1 - k));
+            }
+            strbuf_appendf(cv_c_buf, "                object->%s[i] = %s;\n"
+                "            }\n", field_name, allowed_value_types_soa_decode[type]);
+        }
+        strbuf_appendf(cv_c_buf, "        }\n");
+    }
+    strbuf_appendf(cv_c_buf, "        if (!error && data == end) {\n"
+        "            object->count = start + (int)count;\n"
+        "            result++;\n");
+    if (strings) {
+        strbuf_appendf(cv_c_buf,
+            "        } else {\n"
+            "            for (i = start; i < start + (int)count; i++) {\n");
+        for (i=0; i<message_info->field_count; i++) {
+            if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+                strbuf_appendf(cv_c_buf,
+                    "                if (object->%s[i] != NULL) {\n"
+                    "                    SAFE_FREE(object->%s[i]);\n"
+                    "                }\n", message_info->field_names[i], message_info->field_names[i]);
+            }
+        }
+        strbuf_appendf(cv_c_buf, "            }\n");
+    }
+    strbuf_appendf(cv_c_buf,
+        "        }\n"
+        "    }\n"
+        "    return (result);\n"
+        "}\n");
+}
+
+/**
+ * Function to generate the zero-copy view type of the given message: a
+ * validated serialized message, along with the offsets of its field values,
+ * and inline getters decoding each field value on demand.
+ *
+ * @param cv_h_buf buffer collecting the header file that will contain the declaration of convenience
+ *        (de)serialization functions for the message.
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
+ *        (de)serialization functions for the message.
+ * @param message_info reference to message information structure.
+ */
+static void
+generate_view(strbuf *cv_h_buf, strbuf *cv_c_buf, message_info_struct *message_info) {
+    char *name = message_info->message_name;
+    int name_len = strlen(name);
+    strbuf doc, signature;
+    int i;
+    strbuf_init(&doc);
+    strbuf_init(&signature);
+
+    /* view type */
+    strbuf_appendf(cv_h_buf,
+        "\n/* zero-copy view of a serialized %s message (see c_%s_view_init) */\n"
+        "typedef struct _%s_view_struct_ {\n"
+        "    const unsigned char *data; /* the serialized message (not copied) */\n"
+        "    size_t length; /* length of the serialized message */\n", name, name, name);
+    for (i=0; i<message_info->field_count; i++) {
+        char *field_name = message_info->field_names[i];
+        strbuf_appendf(cv_h_buf, "    size_t %s_offset; /* offset of the %s value */\n",
+            field_name, field_name);
+        if (get_field_value_type_index(message_info->field_types[i]) == STRING_TYPE) {
+            strbuf_appendf(cv_h_buf, "    size_t %s_len; /* length of the %s value */\n",
+                field_name, field_name);
+        }
+    }
+    strbuf_appendf(cv_h_buf, "} %s_view;\n", name);
+
+    /* view initialization */
+    strbuf_appendf(&doc,
+        "\n/**\n"
+        " * Initialize a zero-copy view of a serialized %s message: validate the\n"
+        " * message once and record where each field value lies, whatever the\n"
+        " * field order (fields of other names are skipped).\n"
+        " *\n"
+        " * @param view reference to the %s view(not NULL), only valid upon success.\n"
+        " * @param data the serialized %s message, which must outlive the view.\n"
+        " * @param data_len length in bytes of the data.\n"
+        " *\n"
+        " * @return Non-zero upon success, zero if the data is not a %s message.\n"
+        " */\n", name, name, name, name);
+    strbuf_appendf(&signature,
+        "int\nc_%s_view_init(%s_view *view, const unsigned char *data, size_t data_len)", name, name);
+    append_extern_function(cv_h_buf, cv_c_buf, &doc, &signature);
+    strbuf_appendf(cv_c_buf,
+        "    int result = 0;\n"
+        "    /* skip the schema fingerprint, if any */\n"
+        "    if (dynmessage_get_fingerprint(data, data_len) != 0) {\n"
+        "        data += DYN_MSG_FINGERPRINT_LEN;\n"
+        "        data_len -= DYN_MSG_FINGERPRINT_LEN;\n"
+        "    }\n");
+    if (is_fixed_size(message_info)) {
+        char *upper_name = get_c_upper_name(name);
+        strbuf_appendf(cv_c_buf,
+            "    if (view == NULL || data == NULL) {\n"
+            "        return (result);\n"
+            "    }\n"
+            "    if (c_%s_has_layout(data, data_len)) {\n"
+            "        /* constant layout */\n"
+            "        view->data = data;\n"
+            "        view->length = C_%s_SERIALIZED_LEN;\n", name, upper_name);
+        for (i=0; i<message_info->field_count; i++) {
+            char *upper_field_name = get_c_upper_name(message_info->field_names[i]);
+            strbuf_appendf(cv_c_buf, "        view->%s_offset = C_%s_%s_OFFSET;\n",
+                message_info->field_names[i], upper_name, upper_field_name);
+            free(upper_field_name);
+        }
+        strbuf_appendf(cv_c_buf,
+            "        result++;\n"
+            "    } else");
+        free(upper_name);
+    } else {
+        strbuf_appendf(cv_c_buf, "    if (view != NULL && data != NULL");
+    }
+    strbuf_appendf(cv_c_buf, "%sdata_len >= %d\n"
+        "        && deserialize_uint32((unsigned char *)data) == %dUL\n"
+        "        && deserialize_uint32((unsigned char *)data + 4) <= data_len\n"
+        "        && deserialize_uint32((unsigned char *)data + 4) >= %d\n"
+        "        && deserialize_uint32((unsigned char *)data + 8) == %d\n"
+        "        && memcmp(data + 12, \"%s\", %d) == 0) {\n"
+        "        /* any field order: walk through the fields */\n"
+        "        size_t length = deserialize_uint32((unsigned char *)data + 4);\n"
+        "        size_t offset = %d;\n"
+        "        unsigned long field_count = deserialize_uint32((unsigned char *)data + %d);\n"
+        "        unsigned long i;\n"
+        "        int known = 0;\n",
+        is_fixed_size(message_info) ? " if (" : "\n        && ",
+        DYN_MSG_HEAD_FIXED_LEN + name_len, DYN_MSG_START, DYN_MSG_HEAD_FIXED_LEN + name_len,
+        name_len, name, name_len, DYN_MSG_HEAD_FIXED_LEN + name_len, 12 + name_len);
+    for (i=0; i<message_info->field_count; i++) {
+        strbuf_appendf(cv_c_buf, "        view->%s_offset = 0;\n", message_info->field_names[i]);
+    }
+    strbuf_appendf(cv_c_buf,
+        "        for (i = 0; i < field_count; i++) {\n"
+        "            size_t name_len, value_len, value_offset;\n"
+        "            unsigned long type;\n"
+        "            if (length - offset < %d\n"
+        "                || (name_len = deserialize_uint32((unsigned char *)data + offset + 4))\n"
+        "                    > length - offset - %d) {\n"
+        "                break;\n"
+        "            }\n"
+        "            type = deserialize_uint32((unsigned char *)data + offset + 8 + name_len);\n"
+        "            value_len = deserialize_uint32((unsigned char *)data + offset + 12 + name_len);\n"
+        "            value_offset = offset + %d + name_len;\n"
+        "            if (value_len > length - value_offset\n"
+        "                || deserialize_uint32((unsigned char *)data + offset) != %d + name_len + value_len) {\n"
+        "                break;\n"
+        "            }\n",
+        DYN_FIELD_FIXED_LEN, DYN_FIELD_FIXED_LEN, DYN_FIELD_FIXED_LEN, DYN_FIELD_FIXED_LEN);
+    for (i=0; i<message_info->field_count; i++) {
+        char *field_name = message_info->field_names[i];
+        int type = get_field_value_type_index(message_info->field_types[i]);
+        strbuf_appendf(cv_c_buf,
+            "            %sif (name_len == %d && memcmp(data + offset + 8, \"%s\", %d) == 0) {\n",
+            i > 0 ? "} else " : "", (int)strlen(field_name), field_name, (int)strlen(field_name));
+        if (type == STRING_TYPE) {
+            strbuf_appendf(cv_c_buf,
+                "                if (type != %d || view->%s_offset != 0) {\n"
+                "                    break;\n"
+                "                }\n"
+                "                view->%s_len = value_len;\n",
+                type, field_name, field_name);
+        } else {
+            strbuf_appendf(cv_c_buf,
+                "                if (type != %d || value_len != %d || view->%s_offset != 0) {\n"
+                "                    break;\n"
+                "                }\n",
+                type, allowed_value_types_size[type], field_name);
+        }
+        strbuf_appendf(cv_c_buf,
+            "                view->%s_offset = value_offset;\n"
+            "                known++;\n", field_name);
+    }
+    strbuf_appendf(cv_c_buf,
         "            }\n"
-        "            dynmessage_destroy(dm);\n"
+        "            offset = value_offset + value_len;\n"
         "        }\n"
-        "    }\n",
+        "        if (i == field_count && offset == length && known == %d) {\n"
+        "            view->data = data;\n"
+        "            view->length = length;\n"
+        "            result++;\n"
+        "        }\n"
+        "    }\n"
+        "    return (result);\n"
+        "}\n", message_info->field_count);
+
+    /* inline getters */
+    for (i=0; i<message_info->field_count; i++) {
+        char *field_name = message_info->field_names[i];
+        int type = get_field_value_type_index(message_info->field_types[i]);
+        int len = strlen(field_name) + 16;
+        char offset[len];
+        if (type == STRING_TYPE) {
+            strbuf_appendf(cv_h_buf,
+                "\n/**\n"
+                " * Get the %s field value of a %s view (not null terminated).\n"
+                " *\n"
+                " * @param view reference to the %s view(not NULL).\n"
+                " * @param len reference to the length of the value(not NULL).\n"
+                " *\n"
+                " * @return the %s field value, within the serialized message.\n"
+                " */\n"
+                "static inline const char *\n"
+                "%s_view_%s(const %s_view *view, size_t *len) {\n"
+                "    *len = view->%s_len;\n"
+                "    return (const char *)view->data + view->%s_offset;\n"
+                "}\n",
+                field_name, name, name, field_name, name, field_name, name, field_name, field_name);
+            continue;
+        }
+        sprintf(offset, "view->%s_offset", field_name);
+        strbuf_appendf(cv_h_buf,
+            "\n/**\n"
+            " * Get the %s field value of a %s view.\n"
+            " *\n"
+            " * @param view reference to the %s view(not NULL).\n"
+            " *\n"
+            " * @return the %s field value.\n"
+            " */\n"
+            "static inline %s\n"
+            "%s_view_%s(const %s_view *view) {\n"
+            "    unsigned char *data = (unsigned char *)view->data;\n"
+            "    %s value;\n"
+            "    ",
+            field_name, name, name, field_name, get_field_value_type_text(message_info->field_types[i]),
+            name, field_name, name, get_field_value_type_text(message_info->field_types[i]));
+        strbuf_appendf(cv_h_buf, allowed_value_types_deserialize[type], "", "value", offset);
+        strbuf_appendf(cv_h_buf, "    return value;\n}\n");
+    }
+}
+
+/**
+ * Function to generate the implementation source code for the given message name.
+ *
+ * @param h_buf buffer collecting the header file containing the c structure of the message.
+ * @param cv_h_buf buffer collecting the header file that will contain the declaration of convenience
+ *        (de)serialization functions for the message.
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
+ *        (de)serialization functions for the message.
+ * @param message_info reference to message information structure.
+ */
+static void
+generate_implementation(
+    strbuf *h_buf, strbuf *cv_h_buf, strbuf *cv_c_buf, message_info_struct *message_info) {
+    char *upper_name = get_c_upper_name(message_info->message_name);
+    unsigned long long fingerprint;
+    int i;
+    /* definition of the c structure for the message */
+    strbuf_appendf(h_buf, "\n/* structure to store %s message information */\n"
+        "typedef struct _%s_struct_ {\n", message_info->message_name, message_info->message_name);
+    for (i=0; i<message_info->field_count; i++) {
+        strbuf_appendf(h_buf, "    %s %s;\n",
+            get_field_value_type_text(message_info->field_types[i]), message_info->field_names[i]);
+    }
+    strbuf_appendf(h_buf, "} %s;\n", message_info->message_name);
+
+    /* schema fingerprint of the message */
+    fingerprint = dynmessage_fingerprint_start(message_info->message_name, strlen(message_info->message_name));
+    for (i=0; i<message_info->field_count; i++) {
+        fingerprint = dynmessage_fingerprint_field(fingerprint, message_info->field_names[i],
+            strlen(message_info->field_names[i]),
+            (dyn_field_type)get_field_value_type_index(message_info->field_types[i]));
+    }
+    strbuf_appendf(cv_h_buf,
+        "\n/* schema fingerprint of the %s message (see dynmessage_fingerprint) */\n"
+        "#define C_%s_FINGERPRINT 0x%016llxULL\n",
+        message_info->message_name, upper_name, fingerprint);
+
+    strbuf_appendf(cv_c_buf,
+        "\n/**\n"
+        " * Test whether the provided dynamicmessage represents a %s instance.\n"
+        " *\n"
+        " * @param dm reference to the dynamicmessage structure(not NULL).\n"
+        " *\n"
+        " * @return Non-zero if test succeeds, zero otherwise.\n"
+        " */\n"
+        "extern int\n"
+        "c_instance_of_%s(dynamicmessage *dm){\n"
+        "    int ret = 0;\n"
+        "\n"
+        "    if (dm) {\n",
         message_info->message_name, message_info->message_name);
-    fprintf(cv_c_fptr, "    return (result);\n}\n");
+    if (message_info->field_count > 0) {
+        strbuf_appendf(cv_c_buf,
+            "        if (dm->fingerprint == C_%s_FINGERPRINT) {\n"
+            "            /* same schema fingerprint: same name, field names and types */\n"
+            "            ret++;\n"
+            "        } else", upper_name);
+    } else {
+        strbuf_appendf(cv_c_buf, "       ");
+    }
+    strbuf_appendf(cv_c_buf,
+        " if (dm->name) {\n"
+        "            if (strcmp((const char *)dm->name, \"%s\") == 0\n"
+        "                && dm->field_count > 0) {\n"
+        "                ret++;\n"
+        "            }\n"
+        "            if (ret) {\n"
+        "                ret = dm->field_count == %d;\n"
+        "            }\n",
+        message_info->message_name, message_info->field_count);
+    if (message_info->field_count > 0) {
+        strbuf_appendf(cv_c_buf,
+            "            if (ret) {\n"
+            "                dyn_field field;\n"
+            "                int error = 0;\n\n"
+            "                ret = 0;\n");
 
-    fprintf(cv_c_fptr,
+        for (i=0; i<message_info->field_count; i++) {
+            strbuf_appendf(cv_c_buf,
+            "                dynmessage_get_field(dm, \"%s\", &field);\n",
+            message_info->field_names[i]);
+            strbuf_appendf(cv_c_buf,
+            "                if (field.seq == -1) {\n"
+            "                    error++;\n"
+            "                }\n");
+        }
+        strbuf_appendf(cv_c_buf,
+            "                if (!error) {\n"
+            "                    ret++;\n"
+            "                }\n");
+           strbuf_appendf(cv_c_buf,
+            "            }\n");
+    }
+    strbuf_appendf(cv_c_buf,
+            "        }\n"
+            "    }\n"
+            "    return ret;\n"
+            "}\n");
+
+    /* direct (de)serialization into the dynamicmessage wire format */
+    if (is_fixed_size(message_info)) {
+        generate_fixed_wire_layout(cv_h_buf, cv_c_buf, message_info);
+        generate_fixed_encoder(cv_h_buf, cv_c_buf, message_info);
+        generate_fixed_layout_check(cv_c_buf, message_info);
+    } else {
+        generate_wire_layout(cv_c_buf, message_info);
+        if (message_info->field_count > 0) {
+            generate_writer(cv_c_buf, message_info);
+        }
+    }
+    generate_serializer(cv_c_buf, message_info, 0);
+    generate_serializer(cv_c_buf, message_info, 1);
+    generate_decoder(cv_c_buf, message_info);
+    generate_deserializer(cv_c_buf, message_info);
+    generate_array_serializer(cv_c_buf, message_info);
+    generate_array_deserializer(cv_c_buf, message_info);
+    if (message_info->field_count > 0) {
+        generate_view(cv_h_buf, cv_c_buf, message_info);
+    }
+    if (generate_soa_types && message_info->field_count > 0) {
+        generate_soa(h_buf, cv_h_buf, cv_c_buf, message_info);
+    }
+
+    strbuf_appendf(cv_c_buf,
         "\n/**\n"
         " * Convenience function to convert a %s message object\n"
         " * into a dynamic message object.\n"
@@ -612,48 +2305,48 @@ generate_implementation(FILE *h_fptr, FILE *cv_c_fptr, message_info_struct *mess
         message_info->message_name);
 
     if (message_info->field_count > 0) {
-        fprintf(cv_c_fptr, "    if (object != NULL && dm != NULL) {\n");
-        fprintf(cv_c_fptr, "        int error = 0;\n");
+        strbuf_appendf(cv_c_buf, "    if (object != NULL && dm != NULL) {\n");
+        strbuf_appendf(cv_c_buf, "        int error = 0;\n");
         /* do we need to declare a long value ? */
         for (i=0; i<message_info->field_count; i++) {
         	if (strcmp(message_info->field_types[i], "INT32_TYPE") == 0) {
-                fprintf(cv_c_fptr, "        long long_value = 0L;\n");
+                strbuf_appendf(cv_c_buf, "        long long_value = 0L;\n");
         		break;
         	}
         }
-        fprintf(cv_c_fptr, "        dynmessage_init(dm, \"%s\");\n", message_info->message_name);
+        strbuf_appendf(cv_c_buf, "        dynmessage_init(dm, \"%s\");\n", message_info->message_name);
         for (i=0; i<message_info->field_count; i++) {
             if (strcmp(message_info->field_types[i], "STRING_TYPE") == 0) {
-                fprintf(cv_c_fptr,
+                strbuf_appendf(cv_c_buf,
                     "        if (object->%s == NULL) {\n            error++;\n        } else {\n",
                 message_info->field_names[i]);
 
-                fprintf(cv_c_fptr,
+                strbuf_appendf(cv_c_buf,
                     "            dynmessage_put_field_and_value(dm, \"%s\", %s, object->%s);\n",
                     message_info->field_names[i], message_info->field_types[i], message_info->field_names[i]);
-                fprintf(cv_c_fptr, "        }\n");
+                strbuf_appendf(cv_c_buf, "        }\n");
             } else if (strcmp(message_info->field_types[i], "INT32_TYPE") == 0) {
-                fprintf(cv_c_fptr,
+                strbuf_appendf(cv_c_buf,
                     "        long_value = object->%s;\n"
                     "        dynmessage_put_field_and_value(dm, \"%s\",\n"
                     "            %s, &long_value);\n",
                     message_info->field_names[i], message_info->field_names[i], message_info->field_types[i]);
             } else {
-                fprintf(cv_c_fptr,
+                strbuf_appendf(cv_c_buf,
                     "        dynmessage_put_field_and_value(dm, \"%s\", %s, &object->%s);\n",
                     message_info->field_names[i], message_info->field_types[i], message_info->field_names[i]);
             }
         }
-        fprintf(cv_c_fptr,
+        strbuf_appendf(cv_c_buf,
                      "        if (error) {\n"
                      "            dynmessage_free(dm);\n"
                      "        } else {\n"
                      "            result++;\n"
                      "        }\n    }\n");
     }
-    fprintf(cv_c_fptr, "    return (result);\n}\n");
+    strbuf_appendf(cv_c_buf, "    return (result);\n}\n");
 
-    fprintf(cv_c_fptr,
+    strbuf_appendf(cv_c_buf,
         "\n/**\n"
         " * Convenience function to convert dynamic message into\n"
         " * a %s message object.\n"
@@ -671,57 +2364,552 @@ generate_implementation(FILE *h_fptr, FILE *cv_c_fptr, message_info_struct *mess
         message_info->message_name, message_info->message_name,
         message_info->message_name);
     if (message_info->field_count > 0) {
-        fprintf(cv_c_fptr,
+        strbuf_appendf(cv_c_buf,
             "    if (object != NULL && dm != NULL && c_instance_of_%s(dm)) {\n"
             "        dyn_field field;\n", message_info->message_name);
 
         for (i=0; i<message_info->field_count; i++) {
-            fprintf(cv_c_fptr, "        dynmessage_get_field(dm, \"%s\", &field);\n",
+            strbuf_appendf(cv_c_buf, "        dynmessage_get_field(dm, \"%s\", &field);\n",
                 message_info->field_names[i]);
-            fprintf(cv_c_fptr, "        object->%s = field.value->%s;\n",
+            strbuf_appendf(cv_c_buf, "        object->%s = field.value->%s;\n",
                 message_info->field_names[i],
                 get_field_value_type_union_text(message_info->field_types[i]));
         }
-        fprintf(cv_c_fptr,
+        strbuf_appendf(cv_c_buf,
             "        result++;\n    }\n");
     }
-    fprintf(cv_c_fptr, "    return (result);\n}\n");
+    strbuf_appendf(cv_c_buf, "    return (result);\n}\n");
+    free(upper_name);
 }
 
 /**
  * Function to finalize standard generated files that will contain the source code for the
  * given message name.
  *
- * @param h_fptr header file containing the c structure of the message.
- * @param cv_h_fptr header file that will contain the declaration of convenience
+ * @param h_buf buffer collecting the header file containing the c structure of the message.
+ * @param cv_h_buf buffer collecting the header file that will contain the declaration of convenience
  *        (de)serialization functions for the message.
- * @param cv_c_fptr header file that will contain the implementation of convenience
+ * @param cv_c_buf buffer collecting the source file that will contain the implementation of convenience
  *        (de)serialization functions for the message.
  * @param message_name name of the message.
  */
 static void
-finalize_standard_gen_files(FILE *h_fptr, FILE *cv_h_fptr, FILE *cv_c_fptr, char * message_name) {
-    fprintf(h_fptr,
+finalize_standard_gen_files(strbuf *h_buf, strbuf *cv_h_buf, strbuf *cv_c_buf, char * message_name) {
+    strbuf_appendf(h_buf,
         "\n#ifdef  __cplusplus\n}\n#endif\n\n#endif /* _%s_set_h_ */\n", message_name);
-    fprintf(cv_h_fptr,
+    strbuf_appendf(cv_h_buf,
         "\n#ifdef  __cplusplus\n}\n#endif\n\n#endif /* _%s_set_c_h_ */\n", message_name);
 }
 
 /**
- * Function to close standard generated files that will contain the source code for the
- * message.
+ * Function to write the collected source code to the standard generated files
+ * and close them. The buffers are released.
  *
  * @param h_fptr header file containing the c structure of the message.
  * @param cv_h_fptr header file that will contain the declaration of convenience
  *        (de)serialization functions for the message.
  * @param cv_c_fptr header file that will contain the implementation of convenience
  *        (de)serialization functions for the message.
+ * @param h_buf source code of the header file containing the c structure.
+ * @param cv_h_buf source code of the convenience functions header file.
+ * @param cv_c_buf source code of the convenience functions implementation file.
  */
 static void
-close_standard_gen_files(FILE *h_fptr, FILE *cv_h_fptr, FILE *cv_c_fptr) {
+close_standard_gen_files(
+    FILE *h_fptr, FILE *cv_h_fptr, FILE *cv_c_fptr,
+    strbuf *h_buf, strbuf *cv_h_buf, strbuf *cv_c_buf) {
+    /* a single write per generated file */
+    fwrite(h_buf->data, 1, h_buf->len, h_fptr);
+    fwrite(cv_h_buf->data, 1, cv_h_buf->len, cv_h_fptr);
+    fwrite(cv_c_buf->data, 1, cv_c_buf->len, cv_c_fptr);
     fclose(h_fptr);
     fclose(cv_h_fptr);
     fclose(cv_c_fptr);
+    strbuf_free(h_buf);
+    strbuf_free(cv_h_buf);
+    strbuf_free(cv_c_buf);
+}
+
+/**
+ * Hash function of the message names perfect hash (FNV-1a, seeded), the same
+ * as the one of the generated dispatcher (see generate_dispatcher).
+ *
+ * @param name message name.
+ * @param len length of the message name.
+ * @param seed hash seed.
+ *
+ * @return hash value.
+ */
+static unsigned int
+dispatch_hash(const char *name, size_t len, unsigned int seed) {
+    unsigned int hash = 2166136261u ^ seed;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+/**
+ * Function to build a perfect hash of the provided (distinct) message names
+ * (hash and displace): each name hashes (with seed zero) into one of count
+ * buckets, and the names of a bucket hash (with the seed of the bucket) into
+ * distinct slots of a power of two table.
+ *
+ * @param names message names.
+ * @param count number of message names.
+ * @param seeds seed of each bucket (count seeds, to be freed).
+ * @param slots index of the name of each slot, -1 if free (to be freed).
+ * @param slot_count number of slots.
+ */
+static void
+build_perfect_hash(char **names, int count, unsigned int **seeds, int **slots, int *slot_count) {
+    int *buckets = (int *)malloc(count * sizeof(int));
+    int *bucket_sizes = (int *)calloc(count, sizeof(int));
+    int max_size = 0;
+    int i, size, bucket;
+    *slot_count = 1;
+    while (*slot_count < count) {
+        *slot_count *= 2;
+    }
+    *seeds = (unsigned int *)calloc(count, sizeof(unsigned int));
+    *slots = NULL;
+    exit_if_null(buckets, "unable to allocate enough memory!");
+    exit_if_null(bucket_sizes, "unable to allocate enough memory!");
+    exit_if_null(*seeds, "unable to allocate enough memory!");
+    for (i = 0; i < count; i++) {
+        buckets[i] = dispatch_hash(names[i], strlen(names[i]), 0) % count;
+        bucket_sizes[buckets[i]]++;
+        if (bucket_sizes[buckets[i]] > max_size) {
+            max_size = bucket_sizes[buckets[i]];
+        }
+    }
+    for (;;) {
+        int placed = 1;
+        free(*slots);
+        *slots = (int *)malloc(*slot_count * sizeof(int));
+        exit_if_null(*slots, "unable to allocate enough memory!");
+        for (i = 0; i < *slot_count; i++) {
+            (*slots)[i] = -1;
+        }
+        /* place the largest buckets first */
+        for (size = max_size; size > 0 && placed; size--) {
+            for (bucket = 0; bucket < count && placed; bucket++) {
+                unsigned int seed;
+                if (bucket_sizes[bucket] != size) {
+                    continue;
+                }
+                placed = 0;
+                for (seed = 1; seed < (1u << 20) && !placed; seed++) {
+                    placed = 1;
+                    for (i = 0; i < count && placed; i++) {
+                        if (buckets[i] == bucket) {
+                            int slot = dispatch_hash(names[i], strlen(names[i]), seed) & (*slot_count - 1);
+                            if ((*slots)[slot] != -1) {
+                                placed = 0;
+                            } else {
+                                (*slots)[slot] = i;
+                            }
+                        }
+                    }
+                    if (!placed) {
+                        /* release the slots taken with this seed */
+                        for (i = 0; i < *slot_count; i++) {
+                            if ((*slots)[i] != -1 && buckets[(*slots)[i]] == bucket) {
+                                (*slots)[i] = -1;
+                            }
+                        }
+                    } else {
+                        (*seeds)[bucket] = seed;
+                    }
+                }
+            }
+        }
+        if (placed) {
+            break;
+        }
+        /* no seed found for a bucket, retry with a larger table */
+        *slot_count *= 2;
+    }
+    free(buckets);
+    free(bucket_sizes);
+}
+
+/**
+ * Function to generate the message dispatcher of all the messages of a
+ * cerializer dynamic message definition: message type IDs, a perfect hash
+ * of the message names and a table of message handlers, decoding messages
+ * with their direct de-serialization function.
+ *
+ * @param messages information of all messages (with fields).
+ * @param count number of messages.
+ */
+static void
+generate_dispatcher(message_info_struct *messages, int count) {
+    time_t timeval = time(NULL);
+    FILE *h_fptr, *c_fptr;
+    strbuf h_buf, c_buf;
+    char **names = (char **)malloc(count * sizeof(char *));
+    unsigned int *seeds;
+    int *slots;
+    int slot_count;
+    int i, j;
+
+    exit_if_null(names, "unable to allocate enough memory!");
+    for (i = 0; i < count; i++) {
+        names[i] = messages[i].message_name;
+    }
+    build_perfect_hash(names, count, &seeds, &slots, &slot_count);
+    if ((h_fptr = fopen(DISPATCH_H_FNAME, "w+")) == NULL) {
+        fprintf(stderr,"[ERROR]: cannot create %s! aborting\n", DISPATCH_H_FNAME);
+        exit(-1);
+    }
+    if ((c_fptr = fopen(DISPATCH_C_FNAME, "w+")) == NULL) {
+        fprintf(stderr,"[ERROR]: cannot create %s! aborting\n", DISPATCH_C_FNAME);
+        exit(-1);
+    }
+    strbuf_init(&h_buf);
+    strbuf_init(&c_buf);
+
+    /* header */
+    strbuf_appendf(&h_buf,
+        "\n/**\n * Dispatcher of the messages of a cerializer dynamic message definition.\n"
+        " * Generated by crealizertool at %s */\n\n"
+        "#ifndef _dmd_dispatch_h_\n#define _dmd_dispatch_h_\n\n#ifdef  __cplusplus\nextern \"C\" {\n#endif\n\n"
+        "#include <stddef.h>\n\n"
+        "#include \"cerializer.h\"\n", ctime(&timeval));
+    for (i = 0; i < count; i++) {
+        strbuf_appendf(&h_buf, "#include \"%s_set_c.h\"\n", messages[i].message_name);
+    }
+    strbuf_appendf(&h_buf, "\n/* message type IDs (zero for unknown message types) */\n");
+    for (i = 0; i < count; i++) {
+        char *upper_name = get_c_upper_name(messages[i].message_name);
+        strbuf_appendf(&h_buf, "#define C_DMD_%s_TYPE_ID %d\n", upper_name, i + 1);
+        free(upper_name);
+    }
+    strbuf_appendf(&h_buf,
+        "\n/* number of message types */\n"
+        "#define C_DMD_TYPE_COUNT %d\n"
+        "\n/**\n"
+        " * Handler of decoded messages.\n"
+        " *\n"
+        " * @param type_id message type ID.\n"
+        " * @param object reference to the decoded message object (of the message type),\n"
+        " *        only valid during the call.\n"
+        " * @param ctx context of the dispatcher.\n"
+        " */\n"
+        "typedef void (*c_dmd_handler)(int type_id, void *object, void *ctx);\n"
+        "\n/* message dispatcher: a handler per message type ID */\n"
+        "typedef struct _c_dmd_dispatcher_struct_ {\n"
+        "    c_dmd_handler handlers[C_DMD_TYPE_COUNT + 1]; /* handler of each message type ID */\n"
+        "    void *ctx; /* context passed to the handlers */\n"
+        "} c_dmd_dispatcher;\n", count);
+
+    /* implementation */
+    strbuf_appendf(&c_buf,
+        "\n/**\n * Dispatcher of the messages of a cerializer dynamic message definition.\n"
+        " * Generated by crealizertool at %s */\n\n"
+        "#include <string.h>\n\n"
+        "#include \"dmd_dispatch.h\"\n"
+        "#include \"dynmessage_cerializer.h\"\n"
+        "#include \"stdlib_util.h\"\n"
+        "\n/**\n"
+        " * Hash function of the message names perfect hash (FNV-1a, seeded).\n"
+        " *\n"
+        " * @param name message name.\n"
+        " * @param len length of the message name.\n"
+        " * @param seed hash seed.\n"
+        " *\n"
+        " * @return hash value.\n"
+        " */\n"
+        "static inline unsigned int\n"
+        "c_dmd_hash(const char *name, size_t len, unsigned int seed) {\n"
+        "    unsigned int hash = 2166136261u ^ seed;\n"
+        "    size_t i;\n"
+        "    for (i = 0; i < len; i++) {\n"
+        "        hash ^= (unsigned char)name[i];\n"
+        "        hash *= 16777619u;\n"
+        "    }\n"
+        "    return hash ^ (hash >> 15);\n"
+        "}\n"
+        "\n/* perfect hash of the message names: seed of each bucket */\n"
+        "static const unsigned int c_dmd_seeds[%d] = {", ctime(&timeval), count);
+    for (i = 0; i < count; i++) {
+        strbuf_appendf(&c_buf, "%s%u", i % 8 == 0 ? "\n    " : " ", seeds[i]);
+        strbuf_appendf(&c_buf, i < count - 1 ? "," : "\n");
+    }
+    strbuf_appendf(&c_buf,
+        "};\n"
+        "\n/* perfect hash of the message names: message type of each slot */\n"
+        "static const struct {\n"
+        "    const char *name;\n"
+        "    size_t len;\n"
+        "    int type_id;\n"
+        "} c_dmd_slots[%d] = {\n", slot_count);
+    for (i = 0; i < slot_count; i++) {
+        if (slots[i] == -1) {
+            strbuf_appendf(&c_buf, "    { NULL, 0, 0 }");
+        } else {
+            char *upper_name = get_c_upper_name(names[slots[i]]);
+            strbuf_appendf(&c_buf, "    { \"%s\", %d, C_DMD_%s_TYPE_ID }",
+                names[slots[i]], (int)strlen(names[slots[i]]), upper_name);
+            free(upper_name);
+        }
+        strbuf_appendf(&c_buf, i < slot_count - 1 ? ",\n" : "\n");
+    }
+    strbuf_appendf(&c_buf, "};\n");
+
+    /* type ID of a message name */
+    strbuf_appendf(&h_buf,
+        "\n/**\n"
+        " * Get the message type ID of a message name.\n"
+        " *\n"
+        " * @param name message name (not necessarily null terminated).\n"
+        " * @param len length of the message name.\n"
+        " *\n"
+        " * @return message type ID, zero for unknown message names.\n"
+        " */\n"
+        "extern int\n"
+        "c_dmd_type_id(const char *name, size_t len);\n");
+    strbuf_appendf(&c_buf,
+        "\n/**\n"
+        " * Get the message type ID of a message name.\n"
+        " *\n"
+        " * @param name message name (not necessarily null terminated).\n"
+        " * @param len length of the message name.\n"
+        " *\n"
+        " * @return message type ID, zero for unknown message names.\n"
+        " */\n"
+        "extern int\n"
+        "c_dmd_type_id(const char *name, size_t len) {\n"
+        "    unsigned int slot =\n"
+        "        c_dmd_hash(name, len, c_dmd_seeds[c_dmd_hash(name, len, 0) %% %d]) & %d;\n"
+        "    int result = 0;\n"
+        "    if (c_dmd_slots[slot].type_id != 0 && c_dmd_slots[slot].len == len\n"
+        "        && memcmp(c_dmd_slots[slot].name, name, len) == 0) {\n"
+        "        result = c_dmd_slots[slot].type_id;\n"
+        "    }\n"
+        "    return result;\n"
+        "}\n", count, slot_count - 1);
+
+    /* type ID of a serialized message */
+    strbuf_appendf(&h_buf,
+        "\n/**\n"
+        " * Get the message type ID of a serialized message.\n"
+        " *\n"
+        " * @param data the serialized message.\n"
+        " * @param data_len length in bytes of the data.\n"
+        " *\n"
+        " * @return message type ID, zero for unknown messages.\n"
+        " */\n"
+        "extern int\n"
+        "c_dmd_message_type_id(const unsigned char *data, size_t data_len);\n");
+    strbuf_appendf(&c_buf,
+        "\n/**\n"
+        " * Get the message type ID of a serialized message.\n"
+        " *\n"
+        " * @param data the serialized message.\n"
+        " * @param data_len length in bytes of the data.\n"
+        " *\n"
+        " * @return message type ID, zero for unknown messages.\n"
+        " */\n"
+        "extern int\n"
+        "c_dmd_message_type_id(const unsigned char *data, size_t data_len) {\n"
+        "    int result = 0;\n"
+        "    /* skip the schema fingerprint, if any */\n"
+        "    if (dynmessage_get_fingerprint(data, data_len) != 0) {\n"
+        "        data += DYN_MSG_FINGERPRINT_LEN;\n"
+        "        data_len -= DYN_MSG_FINGERPRINT_LEN;\n"
+        "    }\n"
+        "    if (data != NULL && data_len >= %d\n"
+        "        && deserialize_uint32((unsigned char *)data) == %dUL\n"
+        "        && deserialize_uint32((unsigned char *)data + 8) <= data_len - %d) {\n"
+        "        result = c_dmd_type_id((const char *)data + 12, deserialize_uint32((unsigned char *)data + 8));\n"
+        "    }\n"
+        "    return result;\n"
+        "}\n", DYN_MSG_HEAD_FIXED_LEN, DYN_MSG_START, DYN_MSG_HEAD_FIXED_LEN);
+
+    /* dispatcher initialization */
+    strbuf_appendf(&h_buf,
+        "\n/**\n"
+        " * Initialize a message dispatcher (with no handlers).\n"
+        " *\n"
+        " * @param dispatcher reference to the dispatcher(not NULL).\n"
+        " * @param ctx context passed to the handlers.\n"
+        " */\n"
+        "extern void\n"
+        "c_dmd_dispatcher_init(c_dmd_dispatcher *dispatcher, void *ctx);\n");
+    strbuf_appendf(&c_buf,
+        "\n/**\n"
+        " * Initialize a message dispatcher (with no handlers).\n"
+        " *\n"
+        " * @param dispatcher reference to the dispatcher(not NULL).\n"
+        " * @param ctx context passed to the handlers.\n"
+        " */\n"
+        "extern void\n"
+        "c_dmd_dispatcher_init(c_dmd_dispatcher *dispatcher, void *ctx) {\n"
+        "    memset(dispatcher, 0, sizeof(c_dmd_dispatcher));\n"
+        "    dispatcher->ctx = ctx;\n"
+        "}\n");
+
+    /* handler registration */
+    strbuf_appendf(&h_buf,
+        "\n/**\n"
+        " * Set the handler of a message type.\n"
+        " *\n"
+        " * @param dispatcher reference to the dispatcher(not NULL).\n"
+        " * @param type_id message type ID.\n"
+        " * @param handler message handler, NULL to ignore the message type.\n"
+        " *\n"
+        " * @return Non-zero upon success, zero for unknown message type IDs.\n"
+        " */\n"
+        "extern int\n"
+        "c_dmd_dispatcher_set(c_dmd_dispatcher *dispatcher, int type_id, c_dmd_handler handler);\n");
+    strbuf_appendf(&c_buf,
+        "\n/**\n"
+        " * Set the handler of a message type.\n"
+        " *\n"
+        " * @param dispatcher reference to the dispatcher(not NULL).\n"
+        " * @param type_id message type ID.\n"
+        " * @param handler message handler, NULL to ignore the message type.\n"
+        " *\n"
+        " * @return Non-zero upon success, zero for unknown message type IDs.\n"
+        " */\n"
+        "extern int\n"
+        "c_dmd_dispatcher_set(c_dmd_dispatcher *dispatcher, int type_id, c_dmd_handler handler) {\n"
+        "    int result = 0;\n"
+        "    if (type_id > 0 && type_id <= C_DMD_TYPE_COUNT) {\n"
+        "        dispatcher->handlers[type_id] = handler;\n"
+        "        result++;\n"
+        "    }\n"
+        "    return (result);\n"
+        "}\n");
+
+    /* dispatch of a message of known type */
+    strbuf_appendf(&h_buf,
+        "\n/**\n"
+        " * Decode a serialized message of a known message type (e.g. carried by\n"
+        " * the transport) and pass it to the handler of the message type.\n"
+        " *\n"
+        " * @param dispatcher reference to the dispatcher(not NULL).\n"
+        " * @param type_id message type ID.\n"
+        " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
+        " *        containing the serialized message.\n"
+        " *\n"
+        " * @return Non-zero if the message was handled, zero otherwise.\n"
+        " */\n"
+        "extern int\n"
+        "c_dmd_dispatch_type(c_dmd_dispatcher *dispatcher, int type_id, serialized_data_info *serdi);\n");
+    strbuf_appendf(&c_buf,
+        "\n/**\n"
+        " * Decode a serialized message of a known message type (e.g. carried by\n"
+        " * the transport) and pass it to the handler of the message type. String\n"
+        " * field values are released once the handler returns.\n"
+        " *\n"
+        " * @param dispatcher reference to the dispatcher(not NULL).\n"
+        " * @param type_id message type ID.\n"
+        " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
+        " *        containing the serialized message.\n"
+        " *\n"
+        " * @return Non-zero if the message was handled, zero otherwise.\n"
+        " */\n"
+        "extern int\n"
+        "c_dmd_dispatch_type(c_dmd_dispatcher *dispatcher, int type_id, serialized_data_info *serdi) {\n"
+        "    int result = 0;\n"
+        "    if (dispatcher != NULL && serdi != NULL && type_id > 0 && type_id <= C_DMD_TYPE_COUNT\n"
+        "        && dispatcher->handlers[type_id] != NULL) {\n"
+        "        switch (type_id) {\n");
+    for (i = 0; i < count; i++) {
+        char *name = messages[i].message_name;
+        char *upper_name = get_c_upper_name(name);
+        strbuf_appendf(&c_buf,
+            "        case C_DMD_%s_TYPE_ID:\n"
+            "            {\n"
+            "                %s object;\n"
+            "                if (c_deserialize_%s(serdi, &object)) {\n"
+            "                    dispatcher->handlers[type_id](type_id, &object, dispatcher->ctx);\n",
+            upper_name, name, name);
+        for (j = 0; j < messages[i].field_count; j++) {
+            if (get_field_value_type_index(messages[i].field_types[j]) == STRING_TYPE) {
+                strbuf_appendf(&c_buf, "                    SAFE_FREE(object.%s);\n", messages[i].field_names[j]);
+            }
+        }
+        strbuf_appendf(&c_buf,
+            "                    result++;\n"
+            "                }\n"
+            "            }\n"
+            "            break;\n");
+        free(upper_name);
+    }
+    strbuf_appendf(&c_buf,
+        "        }\n"
+        "    }\n"
+        "    return (result);\n"
+        "}\n");
+
+    /* dispatch of any message */
+    strbuf_appendf(&h_buf,
+        "\n/**\n"
+        " * Decode a serialized message and pass it to the handler of its message\n"
+        " * type (found out of the message name with a perfect hash).\n"
+        " *\n"
+        " * @param dispatcher reference to the dispatcher(not NULL).\n"
+        " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
+        " *        containing the serialized message.\n"
+        " *\n"
+        " * @return Non-zero if the message was handled, zero otherwise.\n"
+        " */\n"
+        "extern int\n"
+        "c_dmd_dispatch(c_dmd_dispatcher *dispatcher, serialized_data_info *serdi);\n");
+    strbuf_appendf(&c_buf,
+        "\n/**\n"
+        " * Decode a serialized message and pass it to the handler of its message\n"
+        " * type (found out of the message name with a perfect hash).\n"
+        " *\n"
+        " * @param dispatcher reference to the dispatcher(not NULL).\n"
+        " * @param serdi reference to the serialized_data_info structure(not NULL)\n"
+        " *        containing the serialized message.\n"
+        " *\n"
+        " * @return Non-zero if the message was handled, zero otherwise.\n"
+        " */\n"
+        "extern int\n"
+        "c_dmd_dispatch(c_dmd_dispatcher *dispatcher, serialized_data_info *serdi) {\n"
+        "    int result = 0;\n"
+        "    if (serdi != NULL && serdi->ser_data != NULL && serdi->ser_data_len > 0) {\n"
+        "        result = c_dmd_dispatch_type(dispatcher,\n"
+        "            c_dmd_message_type_id(serdi->ser_data, serdi->ser_data_len), serdi);\n"
+        "    }\n"
+        "    return (result);\n"
+        "}\n");
+
+    strbuf_appendf(&h_buf, "\n#ifdef  __cplusplus\n}\n#endif\n\n#endif /* _dmd_dispatch_h_ */\n");
+    fwrite(h_buf.data, 1, h_buf.len, h_fptr);
+    fwrite(c_buf.data, 1, c_buf.len, c_fptr);
+    fclose(h_fptr);
+    fclose(c_fptr);
+    strbuf_free(&h_buf);
+    strbuf_free(&c_buf);
+    free(seeds);
+    free(slots);
+    free(names);
+}
+
+/**
+ * Free the message name and fields of a message information structure.
+ *
+ * @param message_info reference to message information structure(not NULL).
+ */
+static void
+free_message_info(message_info_struct *message_info) {
+    int i;
+    for (i=0; i<message_info->field_count; i++) {
+        free(message_info->field_names[i]);
+        free(message_info->field_types[i]);
+    }
+    free(message_info->field_names);
+    free(message_info->field_types);
+    free(message_info->message_name);
 }
 
 /**
@@ -737,13 +2925,16 @@ gen_source_set_from_string(char * cerializer_dmd_xml) {
         ezxml_t cerializer_dmd =
             ezxml_parse_str(cerializer_dmd_xml, strlen(cerializer_dmd_xml));
         ezxml_t message, field;
+        message_info_struct *messages = NULL; /* messages of the dispatcher */
+        int message_count = 0;
+        int m;
 
         for (message = ezxml_child(cerializer_dmd, "message"); message; message = message->next) {
             FILE *h_fptr, *cv_h_fptr, *cv_c_fptr; /* set of generated files */
+            strbuf h_buf, cv_h_buf, cv_c_buf; /* source code of generated files */
             message_info_struct message_info;
             char * message_name;
             char * s;
-            int i;
             /* set message attributes */
             exit_if_null((void *)ezxml_attr(message, "name"), "unspecified message name attribute!");
             s = strdup(ezxml_attr(message, "name"));
@@ -755,7 +2946,10 @@ gen_source_set_from_string(char * cerializer_dmd_xml) {
             message_info.field_count = 0;
             /* prepare all files */
             open_standard_gen_files(&h_fptr, &cv_h_fptr, &cv_c_fptr, message_name);
-            prepare_standard_gen_files(h_fptr, cv_h_fptr, cv_c_fptr, message_name);
+            strbuf_init(&h_buf);
+            strbuf_init(&cv_h_buf);
+            strbuf_init(&cv_c_buf);
+            prepare_standard_gen_files(&h_buf, &cv_h_buf, &cv_c_buf, message_name);
 #ifdef DEBUG
             fprintf(stdout, "processing message %s\n", ezxml_attr(message, "name"));
 #endif /* DEBUG */
@@ -800,21 +2994,40 @@ gen_source_set_from_string(char * cerializer_dmd_xml) {
                 message_info.field_count++;
             }
             /* generate implementation source code */
-            generate_implementation(h_fptr, cv_c_fptr, &message_info);
-            if (message_info.field_count > 0) {
-                /* free allocated memory resources */
-                for (i=0; i<message_info.field_count; i++) {
-                    free(message_info.field_names[i]);
-                    free(message_info.field_types[i]);
+            generate_implementation(&h_buf, &cv_h_buf, &cv_c_buf, &message_info);
+            /* finalize generated files */
+            finalize_standard_gen_files(&h_buf, &cv_h_buf, &cv_c_buf, message_name);
+            close_standard_gen_files(h_fptr, cv_h_fptr, cv_c_fptr, &h_buf, &cv_h_buf, &cv_c_buf);
+            /* keep messages with fields for the dispatcher: the last definition of
+               a message name replaces the others, as its generated files do */
+            for (m = 0; m < message_count; m++) {
+                if (strcmp(messages[m].message_name, message_name) == 0) {
+                    fprintf(stderr, "warning: message %s defined more than once, using the last definition!\n",
+                        message_name);
+                    free_message_info(&messages[m]);
+                    message_count--;
+                    memmove(&messages[m], &messages[m + 1], (message_count - m)*sizeof(message_info_struct));
+                    break;
                 }
-                free(message_info.field_names);
-                free(message_info.field_types);
             }
-            /* finalize generated files */
-            finalize_standard_gen_files(h_fptr, cv_h_fptr, cv_c_fptr, message_name);
-            close_standard_gen_files(h_fptr, cv_h_fptr, cv_c_fptr);
-            free(message_name);
+            if (message_info.field_count > 0) {
+                message_info_struct *new_messages =
+                    (message_info_struct *)realloc(messages, (message_count + 1)*sizeof(message_info_struct));
+                exit_if_null(new_messages, "unable to re-allocate enough memory!");
+                messages = new_messages;
+                messages[message_count++] = message_info;
+            } else {
+                free_message_info(&message_info);
+            }
         }
+        /* generate the dispatcher of all messages */
+        if (message_count > 0) {
+            generate_dispatcher(messages, message_count);
+        }
+        for (m = 0; m < message_count; m++) {
+            free_message_info(&messages[m]);
+        }
+        free(messages);
         ezxml_free(cerializer_dmd);
     }
 }
@@ -858,7 +3071,8 @@ generate_source_set_from_file(FILE * f_ptr) {
  */
 static void
 print_usage(char * tool_name) {
-    fprintf(stdout, "usage: %s -f <filename>\n", tool_name);
+    fprintf(stdout, "usage: %s [-soa] -f <filename>\n", tool_name);
+    fprintf(stdout, "  -soa  also generate structure of arrays (columnar) message types\n");
     fprintf(stdout, "(version: 1.0.1)\n");
     exit(1);
 }
@@ -872,12 +3086,17 @@ main(int argc, char ** argv) {
     test_gen_source_set(void);
 #else
     int usage_error = 1;
+    int arg = 1;
     char * fname_ptr;
     FILE * f_ptr = NULL;
     /* validate command line arguments */
-    if (argc == 3) {
-        if (strcmp(argv[1], "-f") == 0) {
-            fname_ptr = argv[2];
+    if (argc == 4 && strcmp(argv[1], "-soa") == 0) {
+        generate_soa_types = 1;
+        arg++;
+    }
+    if (argc == arg + 2) {
+        if (strcmp(argv[arg], "-f") == 0) {
+            fname_ptr = argv[arg + 1];
             usage_error = 0;
         }
     }